@@ -0,0 +1,142 @@
+/* context switch cost of SysFiber against ucontext and thread yields.
+ *
+ * Two fibers ping-pong with sys_fiber_yield() for N rounds, on the
+ * switch this build's backend uses: the hand written one on x86_64,
+ * aarch64 and armv7 ELF, ucontext or native fibers elsewhere. On Unix
+ * the same ping-pong is then done straight on swapcontext(), which is
+ * what the backend falls back to, and last two threads call
+ * sys_thread_yield() N times each. Every figure is per switch.
+ *
+ * Built by the SysFiberBench target with SYS_BUILD_BENCHMARKS on:
+ *
+ *   SysFiberBench [rounds]
+ *
+ * rounds defaults to 1000000. On a single cpu each thread yield is a
+ * real switch between the two threads, with more cpus the threads run
+ * side by side and it mostly measures the syscall. */
+
+#include <System/SysCore.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(SYS_OS_UNIX) && !defined(SYS_OS_ANDROID)
+#define BENCH_UCONTEXT
+#include <ucontext.h>
+#endif
+
+static SysUInt bench_rounds = 1000000;
+
+static void bench_report(const SysChar *what, SysUInt64 start, SysUInt64 switches) {
+  SysDouble ns = (SysDouble)(sys_get_monotonic_time() - start) * 1000.0 / (SysDouble)switches;
+
+  printf("%-24s %10.1f ns/switch\n", what, ns);
+}
+
+/* fibers */
+static void bench_fiber_func(SysPointer data) {
+  UNUSED(data);
+
+  for (SysUInt i = 0; i < bench_rounds; i++) {
+    sys_fiber_yield();
+  }
+}
+
+static void bench_fiber(void) {
+  SysUInt64 start;
+
+  if (sys_fiber_new(bench_fiber_func, NULL, 0) == NULL
+      || sys_fiber_new(bench_fiber_func, NULL, 0) == NULL) {
+    printf("%-24s %10s\n", "sys_fiber_yield", "unsupported");
+    return;
+  }
+
+  start = sys_get_monotonic_time();
+  sys_fiber_run();
+  bench_report("sys_fiber_yield", start, (SysUInt64)bench_rounds * 2);
+}
+
+/* raw ucontext */
+#if defined(BENCH_UCONTEXT)
+static ucontext_t bench_main_uc, bench_uc[2];
+
+static void bench_ucontext_func(void) {
+  for (SysUInt i = 0; i < bench_rounds; i++) {
+    swapcontext(&bench_uc[0], &bench_uc[1]);
+  }
+}
+
+static void bench_ucontext_peer(void) {
+  for (;;) {
+    swapcontext(&bench_uc[1], &bench_uc[0]);
+  }
+}
+
+static void bench_ucontext(void) {
+  SysSize stack_size = SYS_FIBER_STACK_SIZE;
+  SysPointer stacks[2];
+  SysUInt64 start;
+
+  for (SysInt i = 0; i < 2; i++) {
+    stacks[i] = sys_malloc(stack_size);
+    getcontext(&bench_uc[i]);
+    bench_uc[i].uc_stack.ss_sp = stacks[i];
+    bench_uc[i].uc_stack.ss_size = stack_size;
+    bench_uc[i].uc_link = &bench_main_uc;
+  }
+  makecontext(&bench_uc[0], bench_ucontext_func, 0);
+  makecontext(&bench_uc[1], bench_ucontext_peer, 0);
+
+  start = sys_get_monotonic_time();
+  swapcontext(&bench_main_uc, &bench_uc[0]);
+  bench_report("swapcontext", start, (SysUInt64)bench_rounds * 2);
+
+  sys_free(stacks[0]);
+  sys_free(stacks[1]);
+}
+#endif
+
+/* threads */
+static SysPointer bench_thread_func(SysPointer data) {
+  UNUSED(data);
+
+  for (SysUInt i = 0; i < bench_rounds; i++) {
+    sys_thread_yield();
+  }
+
+  return NULL;
+}
+
+static void bench_threads(void) {
+  SysThread *threads[2];
+  SysUInt64 start;
+
+  start = sys_get_monotonic_time();
+  threads[0] = sys_thread_new("bench0", bench_thread_func, NULL);
+  threads[1] = sys_thread_new("bench1", bench_thread_func, NULL);
+  sys_thread_join(threads[0]);
+  sys_thread_join(threads[1]);
+  bench_report("sys_thread_yield", start, (SysUInt64)bench_rounds * 2);
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1) {
+    bench_rounds = (SysUInt)strtoul(argv[1], NULL, 10);
+  }
+  if (bench_rounds == 0) {
+    bench_rounds = 1;
+  }
+
+  sys_setup();
+
+  printf("%u rounds\n", bench_rounds);
+  bench_fiber();
+#if defined(BENCH_UCONTEXT)
+  bench_ucontext();
+#endif
+  bench_threads();
+
+  sys_teardown();
+
+  return 0;
+}
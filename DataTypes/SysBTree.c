@@ -0,0 +1,1088 @@
+#include <System/DataTypes/SysBTree.h>
+
+#define BTREE_LEAF_MIN (SYS_BTREE_LEAF_MAX / 2)
+#define BTREE_INNER_MIN (SYS_BTREE_INNER_MAX / 2)
+
+typedef struct _SysBTreeNode SysBTreeNode;
+typedef struct _SysBTreeLeaf SysBTreeLeaf;
+typedef struct _SysBTreeInner SysBTreeInner;
+
+struct _SysBTreeNode {
+  SysUInt16 nkeys;
+  SysUInt16 is_leaf;
+};
+
+struct _SysBTreeLeaf {
+  SysBTreeNode node;
+  SysBTreeLeaf *prev;
+  SysBTreeLeaf *next;
+  SysPointer keys[SYS_BTREE_LEAF_MAX];
+  SysPointer values[SYS_BTREE_LEAF_MAX];
+};
+
+/* keys[i] is the smallest key reachable through children[i + 1] */
+struct _SysBTreeInner {
+  SysBTreeNode node;
+  SysPointer keys[SYS_BTREE_INNER_MAX];
+  SysBTreeNode *children[SYS_BTREE_INNER_MAX + 1];
+};
+
+struct _SysBTree {
+  SysBTreeNode *root;
+  SysCompareDataFunc key_compare;
+  SysDestroyFunc key_destroy_func;
+  SysDestroyFunc value_destroy_func;
+  SysPointer key_compare_data;
+  SysUInt nnodes;
+  SysInt ref_count;
+};
+
+#define BTREE_LEAF(n) ((SysBTreeLeaf *)(n))
+#define BTREE_INNER(n) ((SysBTreeInner *)(n))
+#define btree_cmp(tree, a, b) ((tree)->key_compare((a), (b), (tree)->key_compare_data))
+
+static SysBTreeLeaf *btree_leaf_new(void) {
+  SysBTreeLeaf *leaf = sys_slice_new(SysBTreeLeaf);
+
+  leaf->node.nkeys = 0;
+  leaf->node.is_leaf = true;
+  leaf->prev = NULL;
+  leaf->next = NULL;
+
+  return leaf;
+}
+
+static SysBTreeInner *btree_inner_new(void) {
+  SysBTreeInner *inner = sys_slice_new(SysBTreeInner);
+
+  inner->node.nkeys = 0;
+  inner->node.is_leaf = false;
+
+  return inner;
+}
+
+static void btree_node_free(SysBTreeNode *node) {
+  if (node->is_leaf) {
+    sys_slice_free(SysBTreeLeaf, BTREE_LEAF(node));
+  } else {
+    sys_slice_free(SysBTreeInner, BTREE_INNER(node));
+  }
+}
+
+/* first position whose key is >= key */
+static SysUInt btree_leaf_lower(SysBTree *tree, SysBTreeLeaf *leaf, const SysPointer key, SysBool *found) {
+  SysUInt lo = 0, hi = leaf->node.nkeys, mid;
+  SysInt cmp;
+
+  *found = false;
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    cmp = btree_cmp(tree, key, leaf->keys[mid]);
+
+    if (cmp > 0) {
+      lo = mid + 1;
+    } else {
+      if (cmp == 0) {
+        *found = true;
+      }
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+/* first position whose key is > key */
+static SysUInt btree_leaf_upper(SysBTree *tree, SysBTreeLeaf *leaf, const SysPointer key) {
+  SysUInt lo = 0, hi = leaf->node.nkeys, mid;
+
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+
+    if (btree_cmp(tree, key, leaf->keys[mid]) >= 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+static SysUInt btree_inner_child(SysBTree *tree, SysBTreeInner *inner, const SysPointer key) {
+  SysUInt lo = 0, hi = inner->node.nkeys, mid;
+
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+
+    if (btree_cmp(tree, key, inner->keys[mid]) >= 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+static SysBTreeLeaf *btree_find_leaf(SysBTree *tree, const SysPointer key) {
+  SysBTreeNode *node = tree->root;
+
+  if (node == NULL) {
+    return NULL;
+  }
+
+  while (!node->is_leaf) {
+    SysBTreeInner *inner = BTREE_INNER(node);
+
+    node = inner->children[btree_inner_child(tree, inner, key)];
+  }
+
+  return BTREE_LEAF(node);
+}
+
+static SysBTreeLeaf *btree_first_leaf(SysBTreeNode *node) {
+  while (!node->is_leaf) {
+    node = BTREE_INNER(node)->children[0];
+  }
+
+  return BTREE_LEAF(node);
+}
+
+static SysBTreeLeaf *btree_last_leaf(SysBTreeNode *node) {
+  while (!node->is_leaf) {
+    node = BTREE_INNER(node)->children[node->nkeys];
+  }
+
+  return BTREE_LEAF(node);
+}
+
+static SysBool btree_iter_set(SysBTreeIter *iter, SysBTreeLeaf *leaf, SysUInt pos) {
+  if (leaf != NULL && pos >= leaf->node.nkeys) {
+    leaf = leaf->next;
+    pos = 0;
+  }
+
+  iter->leaf = leaf;
+  iter->pos = (SysInt)pos;
+
+  return leaf != NULL;
+}
+
+static void btree_free_node(SysBTree *tree, SysBTreeNode *node) {
+  if (node->is_leaf) {
+    SysBTreeLeaf *leaf = BTREE_LEAF(node);
+
+    for (SysUInt i = 0; i < node->nkeys; i++) {
+      if (tree->key_destroy_func) {
+        tree->key_destroy_func(leaf->keys[i]);
+      }
+      if (tree->value_destroy_func) {
+        tree->value_destroy_func(leaf->values[i]);
+      }
+    }
+  } else {
+    SysBTreeInner *inner = BTREE_INNER(node);
+
+    for (SysUInt i = 0; i <= node->nkeys; i++) {
+      btree_free_node(tree, inner->children[i]);
+    }
+  }
+
+  btree_node_free(node);
+}
+
+/*
+ * a separator must not outlive the key it was copied from, only the
+ * first key of a leaf is ever copied into an inner node.
+ */
+static void btree_fix_separator(SysBTree *tree, const SysPointer key) {
+  SysBTreeNode *node = tree->root;
+  SysBTreeInner *inner;
+  SysUInt i;
+
+  while (node != NULL && !node->is_leaf) {
+    inner = BTREE_INNER(node);
+    i = btree_inner_child(tree, inner, key);
+
+    if (i > 0 && btree_cmp(tree, inner->keys[i - 1], key) == 0) {
+      inner->keys[i - 1] = btree_first_leaf(inner->children[i])->keys[0];
+      return;
+    }
+
+    node = inner->children[i];
+  }
+}
+
+/* insert */
+static void btree_leaf_store(SysBTree *tree,
+    SysBTreeLeaf *leaf,
+    SysUInt pos,
+    SysPointer key,
+    SysPointer value,
+    SysBool replace,
+    SysPointer *stale_key) {
+
+  if (tree->value_destroy_func) {
+    tree->value_destroy_func(leaf->values[pos]);
+  }
+  leaf->values[pos] = value;
+
+  if (!replace) {
+    if (tree->key_destroy_func) {
+      tree->key_destroy_func(key);
+    }
+    return;
+  }
+
+  /* a first key may be a separator too, free it once that is fixed */
+  if (pos == 0) {
+    *stale_key = leaf->keys[pos];
+  } else if (tree->key_destroy_func) {
+    tree->key_destroy_func(leaf->keys[pos]);
+  }
+  leaf->keys[pos] = key;
+}
+
+static SysBool btree_leaf_insert(SysBTree *tree,
+    SysBTreeLeaf *leaf,
+    SysPointer key,
+    SysPointer value,
+    SysBool replace,
+    SysPointer *stale_key,
+    SysPointer *split_key,
+    SysBTreeNode **split_node) {
+  SysPointer keys[SYS_BTREE_LEAF_MAX + 1];
+  SysPointer values[SYS_BTREE_LEAF_MAX + 1];
+  SysBTreeLeaf *right;
+  SysUInt n = leaf->node.nkeys;
+  SysUInt pos, nleft;
+  SysBool found;
+
+  pos = btree_leaf_lower(tree, leaf, key, &found);
+  if (found) {
+    btree_leaf_store(tree, leaf, pos, key, value, replace, stale_key);
+    return false;
+  }
+
+  tree->nnodes++;
+
+  if (n < SYS_BTREE_LEAF_MAX) {
+    memmove(&leaf->keys[pos + 1], &leaf->keys[pos], (n - pos) * sizeof(SysPointer));
+    memmove(&leaf->values[pos + 1], &leaf->values[pos], (n - pos) * sizeof(SysPointer));
+    leaf->keys[pos] = key;
+    leaf->values[pos] = value;
+    leaf->node.nkeys++;
+
+    return false;
+  }
+
+  memcpy(keys, leaf->keys, pos * sizeof(SysPointer));
+  memcpy(values, leaf->values, pos * sizeof(SysPointer));
+  keys[pos] = key;
+  values[pos] = value;
+  memcpy(&keys[pos + 1], &leaf->keys[pos], (n - pos) * sizeof(SysPointer));
+  memcpy(&values[pos + 1], &leaf->values[pos], (n - pos) * sizeof(SysPointer));
+
+  n++;
+  nleft = (n + 1) / 2;
+  right = btree_leaf_new();
+
+  memcpy(leaf->keys, keys, nleft * sizeof(SysPointer));
+  memcpy(leaf->values, values, nleft * sizeof(SysPointer));
+  leaf->node.nkeys = (SysUInt16)nleft;
+
+  memcpy(right->keys, &keys[nleft], (n - nleft) * sizeof(SysPointer));
+  memcpy(right->values, &values[nleft], (n - nleft) * sizeof(SysPointer));
+  right->node.nkeys = (SysUInt16)(n - nleft);
+
+  right->next = leaf->next;
+  right->prev = leaf;
+  if (leaf->next) {
+    leaf->next->prev = right;
+  }
+  leaf->next = right;
+
+  *split_key = right->keys[0];
+  *split_node = (SysBTreeNode *)right;
+
+  return true;
+}
+
+static SysBool btree_insert_node(SysBTree *tree,
+    SysBTreeNode *node,
+    SysPointer key,
+    SysPointer value,
+    SysBool replace,
+    SysPointer *stale_key,
+    SysPointer *split_key,
+    SysBTreeNode **split_node) {
+  SysPointer keys[SYS_BTREE_INNER_MAX + 1];
+  SysBTreeNode *children[SYS_BTREE_INNER_MAX + 2];
+  SysBTreeInner *inner, *right;
+  SysPointer ckey;
+  SysBTreeNode *cnode;
+  SysUInt n, i, nleft;
+
+  if (node->is_leaf) {
+    return btree_leaf_insert(tree, BTREE_LEAF(node), key, value, replace, stale_key, split_key, split_node);
+  }
+
+  inner = BTREE_INNER(node);
+  i = btree_inner_child(tree, inner, key);
+
+  if (!btree_insert_node(tree, inner->children[i], key, value, replace, stale_key, &ckey, &cnode)) {
+    return false;
+  }
+
+  n = node->nkeys;
+  if (n < SYS_BTREE_INNER_MAX) {
+    memmove(&inner->keys[i + 1], &inner->keys[i], (n - i) * sizeof(SysPointer));
+    memmove(&inner->children[i + 2], &inner->children[i + 1], (n - i) * sizeof(SysBTreeNode *));
+    inner->keys[i] = ckey;
+    inner->children[i + 1] = cnode;
+    node->nkeys++;
+
+    return false;
+  }
+
+  memcpy(keys, inner->keys, i * sizeof(SysPointer));
+  keys[i] = ckey;
+  memcpy(&keys[i + 1], &inner->keys[i], (n - i) * sizeof(SysPointer));
+
+  memcpy(children, inner->children, (i + 1) * sizeof(SysBTreeNode *));
+  children[i + 1] = cnode;
+  memcpy(&children[i + 2], &inner->children[i + 1], (n - i) * sizeof(SysBTreeNode *));
+
+  /* n + 1 keys: nleft stay, one moves up, the rest go right */
+  n++;
+  nleft = n / 2;
+  right = btree_inner_new();
+
+  memcpy(inner->keys, keys, nleft * sizeof(SysPointer));
+  memcpy(inner->children, children, (nleft + 1) * sizeof(SysBTreeNode *));
+  node->nkeys = (SysUInt16)nleft;
+
+  memcpy(right->keys, &keys[nleft + 1], (n - nleft - 1) * sizeof(SysPointer));
+  memcpy(right->children, &children[nleft + 1], (n - nleft) * sizeof(SysBTreeNode *));
+  right->node.nkeys = (SysUInt16)(n - nleft - 1);
+
+  *split_key = keys[nleft];
+  *split_node = (SysBTreeNode *)right;
+
+  return true;
+}
+
+static void btree_insert_internal(SysBTree *tree, SysPointer key, SysPointer value, SysBool replace) {
+  SysPointer split_key;
+  SysBTreeNode *split_node;
+  SysBTreeInner *root;
+  SysPointer stale_key = NULL;
+
+  if (tree->root == NULL) {
+    tree->root = (SysBTreeNode *)btree_leaf_new();
+  }
+
+  if (!btree_insert_node(tree, tree->root, key, value, replace, &stale_key, &split_key, &split_node)) {
+    if (stale_key != NULL) {
+      btree_fix_separator(tree, key);
+
+      if (tree->key_destroy_func) {
+        tree->key_destroy_func(stale_key);
+      }
+    }
+    return;
+  }
+
+  root = btree_inner_new();
+  root->node.nkeys = 1;
+  root->keys[0] = split_key;
+  root->children[0] = tree->root;
+  root->children[1] = split_node;
+  tree->root = (SysBTreeNode *)root;
+}
+
+/* remove */
+static void btree_inner_drop(SysBTreeInner *inner, SysUInt i) {
+  SysUInt n = inner->node.nkeys;
+
+  /* drops keys[i] and children[i + 1] */
+  memmove(&inner->keys[i], &inner->keys[i + 1], (n - i - 1) * sizeof(SysPointer));
+  memmove(&inner->children[i + 1], &inner->children[i + 2], (n - i - 1) * sizeof(SysBTreeNode *));
+  inner->node.nkeys--;
+}
+
+static void btree_fix_leaf(SysBTreeInner *parent, SysUInt i) {
+  SysBTreeLeaf *child = BTREE_LEAF(parent->children[i]);
+  SysBTreeLeaf *left = i > 0 ? BTREE_LEAF(parent->children[i - 1]) : NULL;
+  SysBTreeLeaf *right = i < parent->node.nkeys ? BTREE_LEAF(parent->children[i + 1]) : NULL;
+  SysUInt n = child->node.nkeys;
+
+  if (left && left->node.nkeys > BTREE_LEAF_MIN) {
+    SysUInt ln = --left->node.nkeys;
+
+    memmove(&child->keys[1], &child->keys[0], n * sizeof(SysPointer));
+    memmove(&child->values[1], &child->values[0], n * sizeof(SysPointer));
+    child->keys[0] = left->keys[ln];
+    child->values[0] = left->values[ln];
+    child->node.nkeys++;
+    parent->keys[i - 1] = child->keys[0];
+
+  } else if (right && right->node.nkeys > BTREE_LEAF_MIN) {
+    SysUInt rn = --right->node.nkeys;
+
+    child->keys[n] = right->keys[0];
+    child->values[n] = right->values[0];
+    child->node.nkeys++;
+    memmove(&right->keys[0], &right->keys[1], rn * sizeof(SysPointer));
+    memmove(&right->values[0], &right->values[1], rn * sizeof(SysPointer));
+    parent->keys[i] = right->keys[0];
+
+  } else {
+    if (left) {
+      right = child;
+      child = left;
+      i--;
+    }
+
+    memcpy(&child->keys[child->node.nkeys], right->keys, right->node.nkeys * sizeof(SysPointer));
+    memcpy(&child->values[child->node.nkeys], right->values, right->node.nkeys * sizeof(SysPointer));
+    child->node.nkeys += right->node.nkeys;
+
+    child->next = right->next;
+    if (right->next) {
+      right->next->prev = child;
+    }
+
+    btree_inner_drop(parent, i);
+    sys_slice_free(SysBTreeLeaf, right);
+  }
+}
+
+static void btree_fix_inner(SysBTreeInner *parent, SysUInt i) {
+  SysBTreeInner *child = BTREE_INNER(parent->children[i]);
+  SysBTreeInner *left = i > 0 ? BTREE_INNER(parent->children[i - 1]) : NULL;
+  SysBTreeInner *right = i < parent->node.nkeys ? BTREE_INNER(parent->children[i + 1]) : NULL;
+  SysUInt n = child->node.nkeys;
+
+  if (left && left->node.nkeys > BTREE_INNER_MIN) {
+    SysUInt ln = left->node.nkeys;
+
+    memmove(&child->keys[1], &child->keys[0], n * sizeof(SysPointer));
+    memmove(&child->children[1], &child->children[0], (n + 1) * sizeof(SysBTreeNode *));
+    child->keys[0] = parent->keys[i - 1];
+    child->children[0] = left->children[ln];
+    child->node.nkeys++;
+    parent->keys[i - 1] = left->keys[ln - 1];
+    left->node.nkeys--;
+
+  } else if (right && right->node.nkeys > BTREE_INNER_MIN) {
+    SysUInt rn = right->node.nkeys;
+
+    child->keys[n] = parent->keys[i];
+    child->children[n + 1] = right->children[0];
+    child->node.nkeys++;
+    parent->keys[i] = right->keys[0];
+    memmove(&right->keys[0], &right->keys[1], (rn - 1) * sizeof(SysPointer));
+    memmove(&right->children[0], &right->children[1], rn * sizeof(SysBTreeNode *));
+    right->node.nkeys--;
+
+  } else {
+    if (left) {
+      right = child;
+      child = left;
+      i--;
+    }
+
+    n = child->node.nkeys;
+    child->keys[n] = parent->keys[i];
+    memcpy(&child->keys[n + 1], right->keys, right->node.nkeys * sizeof(SysPointer));
+    memcpy(&child->children[n + 1], right->children, (right->node.nkeys + 1) * sizeof(SysBTreeNode *));
+    child->node.nkeys += right->node.nkeys + 1;
+
+    btree_inner_drop(parent, i);
+    sys_slice_free(SysBTreeInner, right);
+  }
+}
+
+static SysBool btree_remove_node(SysBTree *tree,
+    SysBTreeNode *node,
+    const SysPointer key,
+    SysPointer *okey,
+    SysPointer *ovalue,
+    SysBool *was_first) {
+  SysBTreeInner *inner;
+  SysBTreeNode *child;
+  SysUInt i;
+
+  if (node->is_leaf) {
+    SysBTreeLeaf *leaf = BTREE_LEAF(node);
+    SysBool found;
+    SysUInt n;
+
+    i = btree_leaf_lower(tree, leaf, key, &found);
+    if (!found) {
+      return false;
+    }
+
+    *okey = leaf->keys[i];
+    *ovalue = leaf->values[i];
+    *was_first = i == 0;
+
+    n = --node->nkeys;
+    memmove(&leaf->keys[i], &leaf->keys[i + 1], (n - i) * sizeof(SysPointer));
+    memmove(&leaf->values[i], &leaf->values[i + 1], (n - i) * sizeof(SysPointer));
+
+    return true;
+  }
+
+  inner = BTREE_INNER(node);
+  i = btree_inner_child(tree, inner, key);
+  child = inner->children[i];
+
+  if (!btree_remove_node(tree, child, key, okey, ovalue, was_first)) {
+    return false;
+  }
+
+  if (child->is_leaf) {
+    if (child->nkeys < BTREE_LEAF_MIN) {
+      btree_fix_leaf(inner, i);
+    }
+  } else {
+    if (child->nkeys < BTREE_INNER_MIN) {
+      btree_fix_inner(inner, i);
+    }
+  }
+
+  return true;
+}
+
+static SysBool btree_remove_internal(SysBTree *tree, const SysPointer key, SysBool steal) {
+  SysPointer okey, ovalue;
+  SysBool was_first = false;
+  SysBTreeNode *root = tree->root;
+
+  if (root == NULL) {
+    return false;
+  }
+
+  if (!btree_remove_node(tree, root, key, &okey, &ovalue, &was_first)) {
+    return false;
+  }
+
+  if (root->nkeys == 0) {
+    if (root->is_leaf) {
+      tree->root = NULL;
+    } else {
+      tree->root = BTREE_INNER(root)->children[0];
+    }
+
+    btree_node_free(root);
+  }
+
+  if (was_first) {
+    btree_fix_separator(tree, okey);
+  }
+
+  if (!steal) {
+    if (tree->key_destroy_func) {
+      tree->key_destroy_func(okey);
+    }
+    if (tree->value_destroy_func) {
+      tree->value_destroy_func(ovalue);
+    }
+  }
+
+  tree->nnodes--;
+
+  return true;
+}
+
+/* bulk load */
+static SysBool btree_is_sorted(SysBTree *tree, SysPointer *keys, SysUInt n) {
+  for (SysUInt i = 1; i < n; i++) {
+    if (btree_cmp(tree, keys[i - 1], keys[i]) >= 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* nodes at each level are filled evenly so none is below minimum */
+static SysUInt btree_bulk_leaves(SysPointer *keys,
+    SysPointer *values,
+    SysUInt n,
+    SysBTreeNode **nodes,
+    SysPointer *mins) {
+  SysUInt count = (n + SYS_BTREE_LEAF_MAX - 1) / SYS_BTREE_LEAF_MAX;
+  SysBTreeLeaf *leaf, *prev = NULL;
+  SysUInt offset = 0, take;
+
+  for (SysUInt i = 0; i < count; i++) {
+    take = n / count + (i < n % count ? 1 : 0);
+    leaf = btree_leaf_new();
+
+    memcpy(leaf->keys, &keys[offset], take * sizeof(SysPointer));
+    if (values) {
+      memcpy(leaf->values, &values[offset], take * sizeof(SysPointer));
+    } else {
+      memset(leaf->values, 0, take * sizeof(SysPointer));
+    }
+    leaf->node.nkeys = (SysUInt16)take;
+
+    leaf->prev = prev;
+    if (prev) {
+      prev->next = leaf;
+    }
+    prev = leaf;
+
+    nodes[i] = (SysBTreeNode *)leaf;
+    mins[i] = leaf->keys[0];
+    offset += take;
+  }
+
+  return count;
+}
+
+static SysUInt btree_bulk_level(SysBTreeNode **nodes, SysPointer *mins, SysUInt n) {
+  SysUInt fanout = SYS_BTREE_INNER_MAX + 1;
+  SysUInt count = (n + fanout - 1) / fanout;
+  SysBTreeInner *inner;
+  SysUInt offset = 0, take;
+
+  for (SysUInt i = 0; i < count; i++) {
+    take = n / count + (i < n % count ? 1 : 0);
+    inner = btree_inner_new();
+
+    memcpy(inner->children, &nodes[offset], take * sizeof(SysBTreeNode *));
+    memcpy(inner->keys, &mins[offset + 1], (take - 1) * sizeof(SysPointer));
+    inner->node.nkeys = (SysUInt16)(take - 1);
+
+    /* i <= offset, the slots are already consumed */
+    nodes[i] = (SysBTreeNode *)inner;
+    mins[i] = mins[offset];
+    offset += take;
+  }
+
+  return count;
+}
+
+SysBTree *sys_btree_new(SysCompareFunc key_compare_func) {
+  sys_return_val_if_fail(key_compare_func != NULL, NULL);
+
+  return sys_btree_new_full((SysCompareDataFunc)key_compare_func, NULL, NULL, NULL);
+}
+
+SysBTree *sys_btree_new_with_data(SysCompareDataFunc key_compare_func,
+    SysPointer key_compare_data) {
+  sys_return_val_if_fail(key_compare_func != NULL, NULL);
+
+  return sys_btree_new_full(key_compare_func, key_compare_data, NULL, NULL);
+}
+
+SysBTree *sys_btree_new_full(SysCompareDataFunc key_compare_func,
+    SysPointer key_compare_data,
+    SysDestroyFunc key_destroy_func,
+    SysDestroyFunc value_destroy_func) {
+  SysBTree *tree;
+
+  sys_return_val_if_fail(key_compare_func != NULL, NULL);
+
+  tree = sys_slice_new(SysBTree);
+  tree->root = NULL;
+  tree->key_compare = key_compare_func;
+  tree->key_destroy_func = key_destroy_func;
+  tree->value_destroy_func = value_destroy_func;
+  tree->key_compare_data = key_compare_data;
+  tree->nnodes = 0;
+  tree->ref_count = 1;
+
+  return tree;
+}
+
+SysBTree *sys_btree_ref(SysBTree *tree) {
+  sys_return_val_if_fail(tree != NULL, NULL);
+
+  sys_atomic_int_inc(&tree->ref_count);
+
+  return tree;
+}
+
+void sys_btree_unref(SysBTree *tree) {
+  sys_return_if_fail(tree != NULL);
+
+  if (sys_atomic_int_dec_and_test(&tree->ref_count)) {
+    sys_btree_remove_all(tree);
+    sys_slice_free(SysBTree, tree);
+  }
+}
+
+void sys_btree_destroy(SysBTree *tree) {
+  sys_return_if_fail(tree != NULL);
+
+  sys_btree_remove_all(tree);
+  sys_btree_unref(tree);
+}
+
+void sys_btree_remove_all(SysBTree *tree) {
+  sys_return_if_fail(tree != NULL);
+
+  if (tree->root) {
+    btree_free_node(tree, tree->root);
+  }
+
+  tree->root = NULL;
+  tree->nnodes = 0;
+}
+
+/**
+ * sys_btree_bulk_load:
+ * @tree: an empty #SysBTree
+ * @keys: @n keys in strictly ascending order
+ * @values: (nullable): @n values, or %NULL for all %NULL values
+ * @n: number of entries
+ *
+ * Builds the tree bottom up in O(n). Each level uses the fewest nodes
+ * that can hold its entries and spreads them evenly, so every node is
+ * nearly full and none is below the minimum fill.
+ *
+ * Returns: false if @tree is not empty or @keys are not sorted.
+ */
+SysBool sys_btree_bulk_load(SysBTree *tree,
+    SysPointer *keys,
+    SysPointer *values,
+    SysUInt n) {
+  SysBTreeNode **nodes;
+  SysPointer *mins;
+  SysUInt count;
+
+  sys_return_val_if_fail(tree != NULL, false);
+  sys_return_val_if_fail(tree->root == NULL, false);
+  sys_return_val_if_fail(keys != NULL || n == 0, false);
+
+  if (n == 0) {
+    return true;
+  }
+
+  if (!btree_is_sorted(tree, keys, n)) {
+    sys_warning_N("%s", "sys_btree_bulk_load(): keys are not in ascending order.");
+    return false;
+  }
+
+  count = (n + SYS_BTREE_LEAF_MAX - 1) / SYS_BTREE_LEAF_MAX;
+  nodes = sys_new(SysBTreeNode *, count);
+  mins = sys_new(SysPointer, count);
+
+  count = btree_bulk_leaves(keys, values, n, nodes, mins);
+  while (count > 1) {
+    count = btree_bulk_level(nodes, mins, count);
+  }
+
+  tree->root = nodes[0];
+  tree->nnodes = n;
+
+  sys_free(nodes);
+  sys_free(mins);
+
+  return true;
+}
+
+void sys_btree_insert(SysBTree *tree, SysPointer key, SysPointer value) {
+  sys_return_if_fail(tree != NULL);
+
+  btree_insert_internal(tree, key, value, false);
+}
+
+void sys_btree_replace(SysBTree *tree, SysPointer key, SysPointer value) {
+  sys_return_if_fail(tree != NULL);
+
+  btree_insert_internal(tree, key, value, true);
+}
+
+SysBool sys_btree_remove(SysBTree *tree, const SysPointer key) {
+  sys_return_val_if_fail(tree != NULL, false);
+
+  return btree_remove_internal(tree, key, false);
+}
+
+SysBool sys_btree_steal(SysBTree *tree, const SysPointer key) {
+  sys_return_val_if_fail(tree != NULL, false);
+
+  return btree_remove_internal(tree, key, true);
+}
+
+SysBool sys_btree_lookup_extended(SysBTree *tree,
+    const SysPointer lookup_key,
+    SysPointer *orig_key,
+    SysPointer *value) {
+  SysBTreeLeaf *leaf;
+  SysBool found;
+  SysUInt pos;
+
+  sys_return_val_if_fail(tree != NULL, false);
+
+  leaf = btree_find_leaf(tree, lookup_key);
+  if (leaf == NULL) {
+    return false;
+  }
+
+  pos = btree_leaf_lower(tree, leaf, lookup_key, &found);
+  if (!found) {
+    return false;
+  }
+
+  if (orig_key) {
+    *orig_key = leaf->keys[pos];
+  }
+  if (value) {
+    *value = leaf->values[pos];
+  }
+
+  return true;
+}
+
+SysPointer sys_btree_lookup(SysBTree *tree, const SysPointer key) {
+  SysPointer value = NULL;
+
+  sys_btree_lookup_extended(tree, key, NULL, &value);
+
+  return value;
+}
+
+/*
+ * search_func follows sys_tree_search: it returns the sign of
+ * (searched key - @key), so inner nodes follow the last separator
+ * it does not report as greater.
+ */
+SysPointer sys_btree_search(SysBTree *tree,
+    SysCompareFunc search_func,
+    const SysPointer user_data) {
+  SysBTreeNode *node;
+  SysUInt lo, hi, mid;
+  SysInt dir;
+
+  sys_return_val_if_fail(tree != NULL, NULL);
+  sys_return_val_if_fail(search_func != NULL, NULL);
+
+  node = tree->root;
+  if (node == NULL) {
+    return NULL;
+  }
+
+  while (!node->is_leaf) {
+    SysBTreeInner *inner = BTREE_INNER(node);
+
+    lo = 0;
+    hi = node->nkeys;
+    while (lo < hi) {
+      mid = (lo + hi) / 2;
+
+      if (search_func(inner->keys[mid], user_data) >= 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+
+    node = inner->children[lo];
+  }
+
+  SysBTreeLeaf *leaf = BTREE_LEAF(node);
+
+  lo = 0;
+  hi = node->nkeys;
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    dir = search_func(leaf->keys[mid], user_data);
+
+    if (dir == 0) {
+      return leaf->values[mid];
+    }
+
+    if (dir > 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return NULL;
+}
+
+void sys_btree_foreach(SysBTree *tree, SysTraverseFunc func, SysPointer user_data) {
+  SysBTreeLeaf *leaf;
+
+  sys_return_if_fail(tree != NULL);
+  sys_return_if_fail(func != NULL);
+
+  if (tree->root == NULL) {
+    return;
+  }
+
+  for (leaf = btree_first_leaf(tree->root); leaf; leaf = leaf->next) {
+    for (SysUInt i = 0; i < leaf->node.nkeys; i++) {
+      if (func(leaf->keys[i], leaf->values[i], user_data)) {
+        return;
+      }
+    }
+  }
+}
+
+/**
+ * sys_btree_foreach_range:
+ * @tree: a #SysBTree
+ * @lo: first key of the range, inclusive
+ * @hi: last key of the range, exclusive
+ * @func: called in key order, returns true to stop
+ * @user_data: passed to @func
+ */
+void sys_btree_foreach_range(SysBTree *tree,
+    const SysPointer lo,
+    const SysPointer hi,
+    SysTraverseFunc func,
+    SysPointer user_data) {
+  SysBTreeLeaf *leaf;
+  SysBool found;
+  SysUInt i;
+
+  sys_return_if_fail(tree != NULL);
+  sys_return_if_fail(func != NULL);
+
+  leaf = btree_find_leaf(tree, lo);
+  if (leaf == NULL) {
+    return;
+  }
+
+  i = btree_leaf_lower(tree, leaf, lo, &found);
+  for (; leaf; leaf = leaf->next, i = 0) {
+    for (; i < leaf->node.nkeys; i++) {
+      if (btree_cmp(tree, leaf->keys[i], hi) >= 0) {
+        return;
+      }
+
+      if (func(leaf->keys[i], leaf->values[i], user_data)) {
+        return;
+      }
+    }
+  }
+}
+
+SysBool sys_btree_lower_bound(SysBTree *tree, const SysPointer key, SysBTreeIter *iter) {
+  SysBTreeLeaf *leaf;
+  SysBool found;
+
+  sys_return_val_if_fail(tree != NULL, false);
+  sys_return_val_if_fail(iter != NULL, false);
+
+  leaf = btree_find_leaf(tree, key);
+  if (leaf == NULL) {
+    return btree_iter_set(iter, NULL, 0);
+  }
+
+  return btree_iter_set(iter, leaf, btree_leaf_lower(tree, leaf, key, &found));
+}
+
+SysBool sys_btree_upper_bound(SysBTree *tree, const SysPointer key, SysBTreeIter *iter) {
+  SysBTreeLeaf *leaf;
+
+  sys_return_val_if_fail(tree != NULL, false);
+  sys_return_val_if_fail(iter != NULL, false);
+
+  leaf = btree_find_leaf(tree, key);
+  if (leaf == NULL) {
+    return btree_iter_set(iter, NULL, 0);
+  }
+
+  return btree_iter_set(iter, leaf, btree_leaf_upper(tree, leaf, key));
+}
+
+SysBool sys_btree_iter_init(SysBTreeIter *iter, SysBTree *tree) {
+  sys_return_val_if_fail(iter != NULL, false);
+  sys_return_val_if_fail(tree != NULL, false);
+
+  if (tree->root == NULL) {
+    return btree_iter_set(iter, NULL, 0);
+  }
+
+  return btree_iter_set(iter, btree_first_leaf(tree->root), 0);
+}
+
+SysBool sys_btree_iter_init_last(SysBTreeIter *iter, SysBTree *tree) {
+  SysBTreeLeaf *leaf;
+
+  sys_return_val_if_fail(iter != NULL, false);
+  sys_return_val_if_fail(tree != NULL, false);
+
+  if (tree->root == NULL) {
+    return btree_iter_set(iter, NULL, 0);
+  }
+
+  leaf = btree_last_leaf(tree->root);
+
+  return btree_iter_set(iter, leaf, leaf->node.nkeys - 1);
+}
+
+SysBool sys_btree_iter_is_valid(SysBTreeIter *iter) {
+  sys_return_val_if_fail(iter != NULL, false);
+
+  return iter->leaf != NULL;
+}
+
+SysBool sys_btree_iter_next(SysBTreeIter *iter) {
+  sys_return_val_if_fail(iter != NULL, false);
+  sys_return_val_if_fail(iter->leaf != NULL, false);
+
+  return btree_iter_set(iter, iter->leaf, iter->pos + 1);
+}
+
+SysBool sys_btree_iter_prev(SysBTreeIter *iter) {
+  SysBTreeLeaf *leaf;
+
+  sys_return_val_if_fail(iter != NULL, false);
+  sys_return_val_if_fail(iter->leaf != NULL, false);
+
+  if (iter->pos > 0) {
+    iter->pos--;
+    return true;
+  }
+
+  leaf = BTREE_LEAF(iter->leaf)->prev;
+  iter->leaf = leaf;
+  iter->pos = leaf ? leaf->node.nkeys - 1 : 0;
+
+  return leaf != NULL;
+}
+
+SysPointer sys_btree_iter_key(SysBTreeIter *iter) {
+  sys_return_val_if_fail(iter != NULL, NULL);
+  sys_return_val_if_fail(iter->leaf != NULL, NULL);
+
+  return BTREE_LEAF(iter->leaf)->keys[iter->pos];
+}
+
+SysPointer sys_btree_iter_value(SysBTreeIter *iter) {
+  sys_return_val_if_fail(iter != NULL, NULL);
+  sys_return_val_if_fail(iter->leaf != NULL, NULL);
+
+  return BTREE_LEAF(iter->leaf)->values[iter->pos];
+}
+
+SysInt sys_btree_height(SysBTree *tree) {
+  SysBTreeNode *node;
+  SysInt height = 0;
+
+  sys_return_val_if_fail(tree != NULL, 0);
+
+  for (node = tree->root; node; node = node->is_leaf ? NULL : BTREE_INNER(node)->children[0]) {
+    height++;
+  }
+
+  return height;
+}
+
+SysInt sys_btree_nnodes(SysBTree *tree) {
+  sys_return_val_if_fail(tree != NULL, 0);
+
+  return tree->nnodes;
+}
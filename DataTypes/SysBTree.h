@@ -0,0 +1,87 @@
+#ifndef __SYS_BTREE_H__
+#define __SYS_BTREE_H__
+
+#include <System/DataTypes/SysTree.h>
+
+SYS_BEGIN_DECLS
+
+/**
+ * SysBTree: ordered map stored as a B+tree.
+ *
+ * Leaves hold up to SYS_BTREE_LEAF_MAX key/value pairs and are linked
+ * in key order, inner nodes hold up to SYS_BTREE_INNER_MAX separators.
+ * Both node kinds fit in 256 bytes on 64 bit, so a lookup touches a
+ * handful of cache lines and range scans walk the leaf chain.
+ *
+ * The interface follows SysTree, positions are returned as SysBTreeIter
+ * instead of nodes since entries move between leaves on insert/remove.
+ * Any modification of the tree invalidates all iterators.
+ */
+
+#define SYS_BTREE_LEAF_MAX 12
+#define SYS_BTREE_INNER_MAX 15
+
+typedef struct _SysBTree SysBTree;
+typedef struct _SysBTreeIter SysBTreeIter;
+
+struct _SysBTreeIter {
+  /* <private> */
+  SysPointer leaf;
+  SysInt pos;
+};
+
+SYS_API SysBTree *sys_btree_new(SysCompareFunc key_compare_func);
+SYS_API SysBTree *sys_btree_new_with_data(SysCompareDataFunc key_compare_func,
+    SysPointer key_compare_data);
+SYS_API SysBTree *sys_btree_new_full(SysCompareDataFunc key_compare_func,
+    SysPointer key_compare_data,
+    SysDestroyFunc key_destroy_func,
+    SysDestroyFunc value_destroy_func);
+SYS_API SysBTree *sys_btree_ref(SysBTree *tree);
+SYS_API void sys_btree_unref(SysBTree *tree);
+SYS_API void sys_btree_destroy(SysBTree *tree);
+
+SYS_API SysBool sys_btree_bulk_load(SysBTree *tree,
+    SysPointer *keys,
+    SysPointer *values,
+    SysUInt n);
+
+SYS_API void sys_btree_insert(SysBTree *tree, SysPointer key, SysPointer value);
+SYS_API void sys_btree_replace(SysBTree *tree, SysPointer key, SysPointer value);
+SYS_API SysBool sys_btree_remove(SysBTree *tree, const SysPointer key);
+SYS_API SysBool sys_btree_steal(SysBTree *tree, const SysPointer key);
+SYS_API void sys_btree_remove_all(SysBTree *tree);
+
+SYS_API SysPointer sys_btree_lookup(SysBTree *tree, const SysPointer key);
+SYS_API SysBool sys_btree_lookup_extended(SysBTree *tree,
+    const SysPointer lookup_key,
+    SysPointer *orig_key,
+    SysPointer *value);
+SYS_API SysPointer sys_btree_search(SysBTree *tree,
+    SysCompareFunc search_func,
+    const SysPointer user_data);
+
+SYS_API void sys_btree_foreach(SysBTree *tree, SysTraverseFunc func, SysPointer user_data);
+SYS_API void sys_btree_foreach_range(SysBTree *tree,
+    const SysPointer lo,
+    const SysPointer hi,
+    SysTraverseFunc func,
+    SysPointer user_data);
+
+SYS_API SysBool sys_btree_lower_bound(SysBTree *tree, const SysPointer key, SysBTreeIter *iter);
+SYS_API SysBool sys_btree_upper_bound(SysBTree *tree, const SysPointer key, SysBTreeIter *iter);
+
+SYS_API SysBool sys_btree_iter_init(SysBTreeIter *iter, SysBTree *tree);
+SYS_API SysBool sys_btree_iter_init_last(SysBTreeIter *iter, SysBTree *tree);
+SYS_API SysBool sys_btree_iter_is_valid(SysBTreeIter *iter);
+SYS_API SysBool sys_btree_iter_next(SysBTreeIter *iter);
+SYS_API SysBool sys_btree_iter_prev(SysBTreeIter *iter);
+SYS_API SysPointer sys_btree_iter_key(SysBTreeIter *iter);
+SYS_API SysPointer sys_btree_iter_value(SysBTreeIter *iter);
+
+SYS_API SysInt sys_btree_height(SysBTree *tree);
+SYS_API SysInt sys_btree_nnodes(SysBTree *tree);
+
+SYS_END_DECLS
+
+#endif
@@ -0,0 +1,319 @@
+#include <System/DataTypes/SysHArray.h>
+#include <System/DataTypes/SysDHeap.h>
+
+#define MIN_DHEAP_SIZE 16
+#define DHEAP_ARITY 4
+
+#define dheap_parent(n) (((n) - 1) / DHEAP_ARITY)
+#define dheap_child(n) ((n) * DHEAP_ARITY + 1)
+
+static void dheap_set(SysDHeap *hp, SysUInt n, SysDHeapEntry *entry) {
+  hp->entries[n] = *entry;
+  sys_hash_table_replace(hp->index_map, entry->node, UINT_TO_POINTER(n + 1));
+}
+
+static SysInt dheap_index_node(SysDHeap *hp, SysPointer node) {
+  SysPointer v = sys_hash_table_lookup(hp->index_map, node);
+
+  return v == NULL ? -1 : (SysInt)(POINTER_TO_UINT(v) - 1);
+}
+
+static void dheap_maybe_expand(SysDHeap *hp, SysUInt len) {
+  if ((UINT_MAX - hp->len) < len) {
+    sys_error_N("adding %u to heap would overflow", len);
+  }
+
+  if ((hp->len + len) > hp->alloc) {
+    hp->alloc = sys_nearest_pow(hp->len + len);
+    hp->alloc = max(hp->alloc, MIN_DHEAP_SIZE);
+    hp->entries = sys_renew(SysDHeapEntry, hp->entries, hp->alloc);
+  }
+}
+
+static void dheap_bubbleup(SysDHeap *hp, SysUInt n) {
+  SysDHeapEntry entry = hp->entries[n];
+  SysUInt parent;
+
+  while (n > 0) {
+    parent = dheap_parent(n);
+    if (!(entry.score < hp->entries[parent].score)) {
+      break;
+    }
+
+    dheap_set(hp, n, &hp->entries[parent]);
+    n = parent;
+  }
+
+  dheap_set(hp, n, &entry);
+}
+
+/* map update is skipped while heapify builds the whole map at the end */
+static SysUInt dheap_sinkdown_raw(SysDHeap *hp, SysUInt n, SysBool update_map) {
+  SysDHeapEntry entry = hp->entries[n];
+  SysDHeapEntry *entries = hp->entries;
+  SysUInt child, last, best;
+
+  while (true) {
+    child = dheap_child(n);
+    if (child >= hp->len) {
+      break;
+    }
+
+    last = min(child + DHEAP_ARITY, hp->len);
+    best = child;
+    for (child = child + 1; child < last; child++) {
+      if (entries[child].score < entries[best].score) {
+        best = child;
+      }
+    }
+
+    if (!(entries[best].score < entry.score)) {
+      break;
+    }
+
+    if (update_map) {
+      dheap_set(hp, n, &entries[best]);
+    } else {
+      entries[n] = entries[best];
+    }
+    n = best;
+  }
+
+  if (update_map) {
+    dheap_set(hp, n, &entry);
+  } else {
+    entries[n] = entry;
+  }
+
+  return n;
+}
+
+static void dheap_sinkdown(SysDHeap *hp, SysUInt n) {
+  dheap_sinkdown_raw(hp, n, true);
+}
+
+static void dheap_fix(SysDHeap *hp, SysUInt n) {
+  if (n > 0 && hp->entries[n].score < hp->entries[dheap_parent(n)].score) {
+    dheap_bubbleup(hp, n);
+  } else {
+    dheap_sinkdown(hp, n);
+  }
+}
+
+static void dheap_remove_index(SysDHeap *hp, SysUInt n) {
+  SysPointer node = hp->entries[n].node;
+
+  sys_hash_table_remove(hp->index_map, node);
+  hp->len--;
+
+  if (n != hp->len) {
+    dheap_set(hp, n, &hp->entries[hp->len]);
+    dheap_fix(hp, n);
+  }
+}
+
+void sys_dheap_init(SysDHeap *hp, SysBHeapFunc func, SysDestroyFunc node_free) {
+  sys_return_if_fail(hp != NULL);
+
+  hp->entries = NULL;
+  hp->len = 0;
+  hp->alloc = 0;
+  hp->score_func = func;
+  hp->node_free = node_free;
+  hp->index_map = sys_hash_table_new(sys_direct_hash, sys_direct_equal);
+}
+
+SysDHeap *sys_dheap_new(SysBHeapFunc func, SysDestroyFunc node_free) {
+  SysDHeap *hp = sys_new0(SysDHeap, 1);
+
+  sys_dheap_init(hp, func, node_free);
+
+  return hp;
+}
+
+SysDHeap *sys_dheap_new_from_harray(SysHArray *array, SysBHeapFunc func, SysDestroyFunc node_free) {
+  sys_return_val_if_fail(array != NULL, NULL);
+  sys_return_val_if_fail(func != NULL, NULL);
+
+  SysDHeap *hp = sys_dheap_new(func, node_free);
+
+  sys_dheap_heapify(hp, array);
+
+  return hp;
+}
+
+void sys_dheap_destroy(SysDHeap *hp) {
+  sys_return_if_fail(hp != NULL);
+
+  if (hp->node_free) {
+    for (SysUInt i = 0; i < hp->len; i++) {
+      hp->node_free(hp->entries[i].node);
+    }
+  }
+
+  sys_clear_pointer(&hp->entries, sys_free);
+  sys_clear_pointer(&hp->index_map, sys_hash_table_unref);
+  hp->len = 0;
+  hp->alloc = 0;
+}
+
+void sys_dheap_free(SysDHeap *hp) {
+  sys_return_if_fail(hp != NULL);
+
+  sys_dheap_destroy(hp);
+
+  sys_free(hp);
+}
+
+/**
+ * sys_dheap_heapify:
+ * @hp: a #SysDHeap
+ * @array: nodes to add
+ *
+ * Adds every node of @array in O(n + len). Like sys_dheap_push() a node
+ * may be in the heap only once: when one is %NULL, already in @hp or
+ * given twice, nothing is added.
+ */
+void sys_dheap_heapify(SysDHeap *hp, SysHArray *array) {
+  sys_return_if_fail(hp != NULL);
+  sys_return_if_fail(array != NULL);
+  sys_return_if_fail(hp->score_func != NULL);
+
+  SysDHeapEntry *entry;
+  SysPointer node;
+
+  if (array->len == 0) {
+    return;
+  }
+
+  /* claims each node in the map first, a placeholder index is enough
+   * to catch duplicates and the real ones are set after the build */
+  for (SysUInt i = 0; i < array->len; i++) {
+    node = array->pdata[i];
+
+    if (node == NULL || dheap_index_node(hp, node) != -1) {
+      sys_warning_N("heapify node %u is NULL or already in the heap", i);
+
+      while (i-- > 0) {
+        sys_hash_table_remove(hp->index_map, array->pdata[i]);
+      }
+      return;
+    }
+
+    sys_hash_table_insert(hp->index_map, node, UINT_TO_POINTER(1));
+  }
+
+  dheap_maybe_expand(hp, array->len);
+
+  for (SysUInt i = 0; i < array->len; i++) {
+    entry = &hp->entries[hp->len++];
+    entry->node = array->pdata[i];
+    entry->score = hp->score_func(entry->node);
+  }
+
+  /* floyd build, O(n) */
+  if (hp->len > 1) {
+    for (SysUInt i = dheap_parent(hp->len - 1) + 1; i-- > 0;) {
+      dheap_sinkdown_raw(hp, i, false);
+    }
+  }
+
+  for (SysUInt i = 0; i < hp->len; i++) {
+    sys_hash_table_replace(hp->index_map, hp->entries[i].node, UINT_TO_POINTER(i + 1));
+  }
+}
+
+void sys_dheap_push_with_score(SysDHeap *hp, SysPointer node, SysDouble score) {
+  sys_return_if_fail(hp != NULL);
+  sys_return_if_fail(node != NULL);
+  sys_return_if_fail(dheap_index_node(hp, node) == -1);
+
+  dheap_maybe_expand(hp, 1);
+
+  hp->entries[hp->len].node = node;
+  hp->entries[hp->len].score = score;
+  hp->len++;
+
+  dheap_bubbleup(hp, hp->len - 1);
+}
+
+void sys_dheap_push(SysDHeap *hp, SysPointer node) {
+  sys_return_if_fail(hp != NULL);
+  sys_return_if_fail(hp->score_func != NULL);
+
+  sys_dheap_push_with_score(hp, node, hp->score_func(node));
+}
+
+SysPointer sys_dheap_peek(SysDHeap *hp) {
+  sys_return_val_if_fail(hp != NULL, NULL);
+
+  return hp->len > 0 ? hp->entries[0].node : NULL;
+}
+
+SysBool sys_dheap_peek_score(SysDHeap *hp, SysDouble *score) {
+  sys_return_val_if_fail(hp != NULL, false);
+  sys_return_val_if_fail(score != NULL, false);
+
+  if (hp->len == 0) {
+    return false;
+  }
+
+  *score = hp->entries[0].score;
+
+  return true;
+}
+
+SysPointer sys_dheap_pop(SysDHeap *hp) {
+  sys_return_val_if_fail(hp != NULL, NULL);
+
+  if (hp->len == 0) { return NULL; }
+
+  SysPointer result = hp->entries[0].node;
+  dheap_remove_index(hp, 0);
+
+  return result;
+}
+
+SysBool sys_dheap_remove(SysDHeap *hp, SysPointer node) {
+  sys_return_val_if_fail(hp != NULL, false);
+  sys_return_val_if_fail(node != NULL, false);
+
+  SysInt n = dheap_index_node(hp, node);
+  if (n == -1) { return false; }
+
+  dheap_remove_index(hp, (SysUInt)n);
+
+  return true;
+}
+
+SysBool sys_dheap_update_score(SysDHeap *hp, SysPointer node, SysDouble score) {
+  sys_return_val_if_fail(hp != NULL, false);
+  sys_return_val_if_fail(node != NULL, false);
+
+  SysInt n = dheap_index_node(hp, node);
+  if (n == -1) { return false; }
+
+  hp->entries[n].score = score;
+  dheap_fix(hp, (SysUInt)n);
+
+  return true;
+}
+
+SysBool sys_dheap_update(SysDHeap *hp, SysPointer node) {
+  sys_return_val_if_fail(hp != NULL, false);
+  sys_return_val_if_fail(hp->score_func != NULL, false);
+
+  return sys_dheap_update_score(hp, node, hp->score_func(node));
+}
+
+SysBool sys_dheap_contains(SysDHeap *hp, SysPointer node) {
+  sys_return_val_if_fail(hp != NULL, false);
+
+  return dheap_index_node(hp, node) != -1;
+}
+
+SysInt sys_dheap_size(SysDHeap *hp) {
+  sys_return_val_if_fail(hp != NULL, -1);
+
+  return hp->len;
+}
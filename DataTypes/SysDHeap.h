@@ -0,0 +1,55 @@
+#ifndef __SYS_DHEAP_H__
+#define __SYS_DHEAP_H__
+
+#include <System/DataTypes/SysBHeap.h>
+#include <System/DataTypes/SysHashTable.h>
+
+SYS_BEGIN_DECLS
+
+/**
+ * SysDHeap: 4-ary min heap of (score, pointer) entries.
+ * score_func is called once when a node is pushed or updated,
+ * sifting compares the cached scores only.
+ * node -> position map gives O(log n) remove and update.
+ */
+
+typedef struct _SysDHeap SysDHeap;
+typedef struct _SysDHeapEntry SysDHeapEntry;
+
+struct _SysDHeapEntry {
+  SysDouble score;
+  SysPointer node;
+};
+
+struct _SysDHeap {
+  SysDHeapEntry *entries;
+  SysUInt len;
+
+  /* <private> */
+  SysUInt alloc;
+  SysHashTable *index_map;
+  SysBHeapFunc score_func;
+  SysDestroyFunc node_free;
+};
+
+SYS_API void sys_dheap_init(SysDHeap *hp, SysBHeapFunc func, SysDestroyFunc node_free);
+SYS_API SysDHeap *sys_dheap_new(SysBHeapFunc func, SysDestroyFunc node_free);
+SYS_API SysDHeap *sys_dheap_new_from_harray(SysHArray *array, SysBHeapFunc func, SysDestroyFunc node_free);
+SYS_API void sys_dheap_free(SysDHeap *hp);
+SYS_API void sys_dheap_destroy(SysDHeap *hp);
+
+SYS_API void sys_dheap_heapify(SysDHeap *hp, SysHArray *array);
+SYS_API void sys_dheap_push(SysDHeap *hp, SysPointer node);
+SYS_API void sys_dheap_push_with_score(SysDHeap *hp, SysPointer node, SysDouble score);
+SYS_API SysPointer sys_dheap_peek(SysDHeap *hp);
+SYS_API SysBool sys_dheap_peek_score(SysDHeap *hp, SysDouble *score);
+SYS_API SysPointer sys_dheap_pop(SysDHeap *hp);
+SYS_API SysBool sys_dheap_remove(SysDHeap *hp, SysPointer node);
+SYS_API SysBool sys_dheap_update(SysDHeap *hp, SysPointer node);
+SYS_API SysBool sys_dheap_update_score(SysDHeap *hp, SysPointer node, SysDouble score);
+SYS_API SysBool sys_dheap_contains(SysDHeap *hp, SysPointer node);
+SYS_API SysInt sys_dheap_size(SysDHeap *hp);
+
+SYS_END_DECLS
+
+#endif
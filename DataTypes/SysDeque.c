@@ -0,0 +1,298 @@
+#include <System/DataTypes/SysDeque.h>
+
+#define MIN_DEQUE_SIZE  16
+
+#define deque_mask(self) ((self)->alloc - 1)
+#define deque_elt_len(self, i) ((SysSize)(self)->elt_size * (i))
+#define deque_elt_pos(self, i) ((self)->data + deque_elt_len((self), (i)))
+#define deque_slot(self, i) (((self)->head + (i)) & deque_mask(self))
+
+static void deque_maybe_expand(SysDeque *self, SysUInt len) {
+  SysUInt old_alloc;
+  SysUInt wrapped;
+
+  if ((UINT_MAX - self->len) < len) {
+    sys_error_N("adding %u to deque would overflow", len);
+  }
+
+  if ((self->len + len) <= self->alloc) {
+    return;
+  }
+
+  old_alloc = self->alloc;
+  self->alloc = sys_nearest_pow(self->len + len);
+  self->alloc = max(self->alloc, MIN_DEQUE_SIZE);
+  self->data = sys_realloc(self->data, deque_elt_len(self, self->alloc));
+
+  /* move wrapped part behind the old end, new capacity is at least double */
+  if (self->head + self->len > old_alloc) {
+    wrapped = self->head + self->len - old_alloc;
+    memcpy(deque_elt_pos(self, old_alloc), self->data, deque_elt_len(self, wrapped));
+  }
+}
+
+/* copy len elements from data into ring position [pos, pos + len) */
+static void deque_copy_in(SysDeque *self, SysUInt pos, const SysUInt8 *data, SysUInt len) {
+  SysUInt slot = pos & deque_mask(self);
+  SysUInt n = min(len, self->alloc - slot);
+
+  memcpy(deque_elt_pos(self, slot), data, deque_elt_len(self, n));
+  if (n < len) {
+    memcpy(self->data, data + deque_elt_len(self, n), deque_elt_len(self, len - n));
+  }
+}
+
+static void deque_copy_out(SysDeque *self, SysUInt pos, SysUInt8 *data, SysUInt len) {
+  SysUInt slot = pos & deque_mask(self);
+  SysUInt n = min(len, self->alloc - slot);
+
+  memcpy(data, deque_elt_pos(self, slot), deque_elt_len(self, n));
+  if (n < len) {
+    memcpy(data + deque_elt_len(self, n), self->data, deque_elt_len(self, len - n));
+  }
+}
+
+SysDeque* sys_deque_new(SysUInt elt_size) {
+  return sys_deque_sized_new(elt_size, 0);
+}
+
+SysDeque* sys_deque_sized_new(SysUInt elt_size, SysUInt reserved_size) {
+  SysDeque *self;
+
+  sys_return_val_if_fail(elt_size > 0, NULL);
+
+  self = sys_slice_new(SysDeque);
+  sys_deque_init(self, elt_size);
+
+  if (reserved_size != 0)
+    deque_maybe_expand(self, reserved_size);
+
+  return self;
+}
+
+void sys_deque_free(SysDeque *self) {
+  sys_return_if_fail(self != NULL);
+
+  sys_deque_destroy(self);
+  sys_slice_free(SysDeque, self);
+}
+
+void sys_deque_init(SysDeque *self, SysUInt elt_size) {
+  sys_return_if_fail(self != NULL);
+  sys_return_if_fail(elt_size > 0);
+
+  self->data = NULL;
+  self->len = 0;
+  self->head = 0;
+  self->alloc = 0;
+  self->elt_size = elt_size;
+}
+
+void sys_deque_destroy(SysDeque *self) {
+  sys_return_if_fail(self != NULL);
+
+  SysUInt8 *data = sys_steal_pointer(&self->data);
+
+  if (data != NULL) {
+    sys_free(data);
+  }
+
+  self->len = 0;
+  self->head = 0;
+  self->alloc = 0;
+}
+
+void sys_deque_clear(SysDeque *self) {
+  sys_return_if_fail(self != NULL);
+
+  self->len = 0;
+  self->head = 0;
+}
+
+void sys_deque_reserve(SysDeque *self, SysUInt len) {
+  sys_return_if_fail(self != NULL);
+
+  if (len > self->len) {
+    deque_maybe_expand(self, len - self->len);
+  }
+}
+
+SysUInt sys_deque_get_length(SysDeque *self) {
+  sys_return_val_if_fail(self != NULL, 0);
+
+  return self->len;
+}
+
+SysBool sys_deque_is_empty(SysDeque *self) {
+  sys_return_val_if_fail(self != NULL, true);
+
+  return self->len == 0;
+}
+
+void sys_deque_push_head(SysDeque *self, const SysPointer elem) {
+  sys_return_if_fail(self != NULL);
+
+  deque_maybe_expand(self, 1);
+
+  self->head = (self->head - 1) & deque_mask(self);
+  memcpy(deque_elt_pos(self, self->head), elem, self->elt_size);
+  self->len++;
+}
+
+void sys_deque_push_tail(SysDeque *self, const SysPointer elem) {
+  sys_return_if_fail(self != NULL);
+
+  deque_maybe_expand(self, 1);
+
+  memcpy(deque_elt_pos(self, deque_slot(self, self->len)), elem, self->elt_size);
+  self->len++;
+}
+
+SysBool sys_deque_pop_head(SysDeque *self, SysPointer elem) {
+  sys_return_val_if_fail(self != NULL, false);
+
+  if (self->len == 0) {
+    return false;
+  }
+
+  if (elem != NULL) {
+    memcpy(elem, deque_elt_pos(self, self->head), self->elt_size);
+  }
+
+  self->head = (self->head + 1) & deque_mask(self);
+  self->len--;
+
+  return true;
+}
+
+SysBool sys_deque_pop_tail(SysDeque *self, SysPointer elem) {
+  sys_return_val_if_fail(self != NULL, false);
+
+  if (self->len == 0) {
+    return false;
+  }
+
+  self->len--;
+
+  if (elem != NULL) {
+    memcpy(elem, deque_elt_pos(self, deque_slot(self, self->len)), self->elt_size);
+  }
+
+  return true;
+}
+
+SysPointer sys_deque_peek_head(SysDeque *self) {
+  sys_return_val_if_fail(self != NULL, NULL);
+
+  if (self->len == 0) {
+    return NULL;
+  }
+
+  return deque_elt_pos(self, self->head);
+}
+
+SysPointer sys_deque_peek_tail(SysDeque *self) {
+  sys_return_val_if_fail(self != NULL, NULL);
+
+  if (self->len == 0) {
+    return NULL;
+  }
+
+  return deque_elt_pos(self, deque_slot(self, self->len - 1));
+}
+
+SysPointer sys_deque_index(SysDeque *self, SysUInt index_) {
+  sys_return_val_if_fail(self != NULL, NULL);
+  sys_return_val_if_fail(index_ < self->len, NULL);
+
+  return deque_elt_pos(self, deque_slot(self, index_));
+}
+
+void sys_deque_push_head_vals(SysDeque *self, const SysPointer data, SysUInt len) {
+  sys_return_if_fail(self != NULL);
+  sys_return_if_fail(data != NULL || len == 0);
+
+  if (len == 0) {
+    return;
+  }
+
+  deque_maybe_expand(self, len);
+
+  self->head = (self->head - len) & deque_mask(self);
+  deque_copy_in(self, self->head, data, len);
+  self->len += len;
+}
+
+void sys_deque_push_tail_vals(SysDeque *self, const SysPointer data, SysUInt len) {
+  sys_return_if_fail(self != NULL);
+  sys_return_if_fail(data != NULL || len == 0);
+
+  if (len == 0) {
+    return;
+  }
+
+  deque_maybe_expand(self, len);
+
+  deque_copy_in(self, self->head + self->len, data, len);
+  self->len += len;
+}
+
+SysUInt sys_deque_pop_head_vals(SysDeque *self, SysPointer data, SysUInt len) {
+  sys_return_val_if_fail(self != NULL, 0);
+
+  len = min(len, self->len);
+  if (len == 0) {
+    return 0;
+  }
+
+  if (data != NULL) {
+    deque_copy_out(self, self->head, data, len);
+  }
+
+  self->head = (self->head + len) & deque_mask(self);
+  self->len -= len;
+
+  return len;
+}
+
+SysUInt sys_deque_pop_tail_vals(SysDeque *self, SysPointer data, SysUInt len) {
+  sys_return_val_if_fail(self != NULL, 0);
+
+  len = min(len, self->len);
+  if (len == 0) {
+    return 0;
+  }
+
+  self->len -= len;
+
+  if (data != NULL) {
+    deque_copy_out(self, self->head + self->len, data, len);
+  }
+
+  return len;
+}
+
+void sys_deque_get_views(SysDeque *self,
+    SysPointer *first, SysUInt *first_len,
+    SysPointer *second, SysUInt *second_len) {
+  SysUInt n;
+
+  sys_return_if_fail(self != NULL);
+  sys_return_if_fail(first != NULL && first_len != NULL);
+  sys_return_if_fail(second != NULL && second_len != NULL);
+
+  if (self->len == 0) {
+    *first = NULL;
+    *first_len = 0;
+    *second = NULL;
+    *second_len = 0;
+    return;
+  }
+
+  n = min(self->len, self->alloc - self->head);
+
+  *first = deque_elt_pos(self, self->head);
+  *first_len = n;
+  *second = n < self->len ? self->data : NULL;
+  *second_len = self->len - n;
+}
@@ -0,0 +1,59 @@
+#ifndef __SYS_DEQUE_H__
+#define __SYS_DEQUE_H__
+
+#include <System/Fundamental/SysCommonCore.h>
+
+SYS_BEGIN_DECLS
+
+/**
+ * SysDeque: growable ring buffer with power-of-two capacity.
+ * push/pop on both ends and random index are O(1), elements are
+ * stored inline with elt_size bytes each.
+ */
+
+#define sys_deque_push_head_val(d, v) sys_deque_push_head(d, &(v))
+#define sys_deque_push_tail_val(d, v) sys_deque_push_tail(d, &(v))
+#define sys_deque_index_val(d, t, i) (*(t *)sys_deque_index(d, i))
+
+typedef struct _SysDeque SysDeque;
+
+struct _SysDeque {
+  SysUInt8 *data;
+  SysUInt   len;
+
+  /* <private> */
+  SysUInt   head;
+  SysUInt   alloc;
+  SysUInt   elt_size;
+};
+
+SYS_API SysDeque* sys_deque_new(SysUInt elt_size);
+SYS_API SysDeque* sys_deque_sized_new(SysUInt elt_size, SysUInt reserved_size);
+SYS_API void sys_deque_free(SysDeque *self);
+SYS_API void sys_deque_init(SysDeque *self, SysUInt elt_size);
+SYS_API void sys_deque_destroy(SysDeque *self);
+SYS_API void sys_deque_clear(SysDeque *self);
+SYS_API void sys_deque_reserve(SysDeque *self, SysUInt len);
+SYS_API SysUInt sys_deque_get_length(SysDeque *self);
+SYS_API SysBool sys_deque_is_empty(SysDeque *self);
+
+SYS_API void sys_deque_push_head(SysDeque *self, const SysPointer elem);
+SYS_API void sys_deque_push_tail(SysDeque *self, const SysPointer elem);
+SYS_API SysBool sys_deque_pop_head(SysDeque *self, SysPointer elem);
+SYS_API SysBool sys_deque_pop_tail(SysDeque *self, SysPointer elem);
+SYS_API SysPointer sys_deque_peek_head(SysDeque *self);
+SYS_API SysPointer sys_deque_peek_tail(SysDeque *self);
+SYS_API SysPointer sys_deque_index(SysDeque *self, SysUInt index_);
+
+SYS_API void sys_deque_push_head_vals(SysDeque *self, const SysPointer data, SysUInt len);
+SYS_API void sys_deque_push_tail_vals(SysDeque *self, const SysPointer data, SysUInt len);
+SYS_API SysUInt sys_deque_pop_head_vals(SysDeque *self, SysPointer data, SysUInt len);
+SYS_API SysUInt sys_deque_pop_tail_vals(SysDeque *self, SysPointer data, SysUInt len);
+
+SYS_API void sys_deque_get_views(SysDeque *self,
+    SysPointer *first, SysUInt *first_len,
+    SysPointer *second, SysUInt *second_len);
+
+SYS_END_DECLS
+
+#endif
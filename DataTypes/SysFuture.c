@@ -0,0 +1,824 @@
+#include <System/DataTypes/SysFuture.h>
+#include <System/DataTypes/SysHList.h>
+#include <System/DataTypes/SysAsyncQueue.h>
+#include <System/Platform/Common/SysAtomic.h>
+#include <System/Utils/SysString.h>
+
+typedef struct _SysFutureCallback SysFutureCallback;
+typedef struct _SysFutureTask SysFutureTask;
+typedef struct _SysFutureThen SysFutureThen;
+typedef struct _SysFutureJoin SysFutureJoin;
+typedef struct _SysThreadExecutor SysThreadExecutor;
+typedef struct _SysExecutorJob SysExecutorJob;
+
+typedef void (*SysFutureNotify)(SysFuture *source, SysPointer data);
+
+struct _SysFuture {
+  SysRef ref_count;
+  SysMutex lock;
+  SysCond cond;
+  /* written under the lock, read without it */
+  SysInt state;
+  SysPointer value;
+  SysDestroyFunc value_destroy;
+  SysError *error;
+  /* newest first, dispatched once on completion */
+  SysFutureCallback *callbacks;
+  SysCancelToken *token;
+  SysHList token_link;
+};
+
+struct _SysPromise {
+  SysFuture *future;
+};
+
+struct _SysCancelToken {
+  SysRef ref_count;
+  SysInt cancelled;
+  SysMutex lock;
+  /* pending futures started with this token */
+  SysHList futures;
+};
+
+struct _SysFutureCallback {
+  SysFutureCallback *next;
+  SysFutureNotify func;
+  SysPointer data;
+  SysExecutor *executor;
+  SysFuture *source;
+};
+
+struct _SysFutureTask {
+  SysFuture *future;
+  SysFutureTaskFunc func;
+  SysPointer user_data;
+  SysCancelToken *token;
+};
+
+struct _SysFutureThen {
+  SysFuture *derived;
+  SysFutureThenFunc func;
+  SysPointer user_data;
+};
+
+struct _SysFutureJoin {
+  SysFuture *result;
+  /* callbacks still to come */
+  SysInt remaining;
+};
+
+struct _SysThreadExecutor {
+  SysExecutor parent;
+  SysAsyncQueue *queue;
+  SysThread **threads;
+  SysUInt n_threads;
+};
+
+struct _SysExecutorJob {
+  SysExecutorFunc func;
+  SysPointer data;
+};
+
+/* executor */
+static SysPointer thread_executor_worker(SysPointer data) {
+  SysAsyncQueue *queue = data;
+  SysExecutorJob *job;
+
+  while (true) {
+    job = sys_async_queue_pop(queue);
+    if (job->func == NULL) {
+      sys_slice_free(SysExecutorJob, job);
+      break;
+    }
+
+    job->func(job->data);
+    sys_slice_free(SysExecutorJob, job);
+  }
+
+  return NULL;
+}
+
+static void thread_executor_execute(SysExecutor *self, SysExecutorFunc func, SysPointer data) {
+  SysThreadExecutor *pool = (SysThreadExecutor *)self;
+  SysExecutorJob *job = sys_slice_new(SysExecutorJob);
+
+  job->func = func;
+  job->data = data;
+  sys_async_queue_push(pool->queue, job);
+}
+
+static void thread_executor_free(SysExecutor *self) {
+  SysThreadExecutor *pool = (SysThreadExecutor *)self;
+  SysExecutorJob *job;
+  SysUInt i;
+
+  /* one stop job per worker, queued behind the pending work */
+  for (i = 0; i < pool->n_threads; i++) {
+    job = sys_slice_new0(SysExecutorJob);
+    sys_async_queue_push(pool->queue, job);
+  }
+
+  for (i = 0; i < pool->n_threads; i++) {
+    sys_thread_join(pool->threads[i]);
+  }
+
+  sys_async_queue_unref(pool->queue);
+  sys_free(pool->threads);
+  sys_slice_free(SysThreadExecutor, pool);
+}
+
+/**
+ * sys_executor_new_threads:
+ * @n_threads: number of workers, 0 for one per CPU
+ *
+ * Creates an executor running jobs in FIFO order on a fixed set of
+ * threads. sys_executor_free() runs the jobs already queued, then
+ * joins the workers.
+ *
+ * Returns: a new #SysExecutor
+ */
+SysExecutor *sys_executor_new_threads(SysUInt n_threads) {
+  SysThreadExecutor *pool;
+  SysUInt i;
+
+  if (n_threads == 0) {
+    n_threads = sys_get_num_processors();
+  }
+
+  pool = sys_slice_new(SysThreadExecutor);
+  pool->parent.execute = thread_executor_execute;
+  pool->parent.free = thread_executor_free;
+  pool->queue = sys_async_queue_new();
+  pool->n_threads = n_threads;
+  pool->threads = sys_new0(SysThread *, n_threads);
+
+  for (i = 0; i < n_threads; i++) {
+    pool->threads[i] = sys_thread_new("executor", thread_executor_worker, pool->queue);
+  }
+
+  return (SysExecutor *)pool;
+}
+
+/**
+ * sys_executor_execute:
+ * @executor: (nullable): a #SysExecutor, %NULL to run inline
+ * @func: function to run
+ * @data: argument of @func
+ */
+void sys_executor_execute(SysExecutor *executor, SysExecutorFunc func, SysPointer data) {
+  sys_return_if_fail(func != NULL);
+
+  if (executor == NULL) {
+    func(data);
+    return;
+  }
+
+  executor->execute(executor, func, data);
+}
+
+void sys_executor_free(SysExecutor *executor) {
+  sys_return_if_fail(executor != NULL);
+
+  if (executor->free) {
+    executor->free(executor);
+  }
+}
+
+/* future */
+static SysFuture *future_new(SysDestroyFunc value_destroy) {
+  SysFuture *future = sys_slice_new0(SysFuture);
+
+  sys_ref_count_init(future);
+  sys_mutex_init(&future->lock);
+  sys_cond_init(&future->cond);
+  future->state = SYS_FUTURE_PENDING;
+  future->value_destroy = value_destroy;
+  sys_hlist_init(&future->token_link);
+
+  return future;
+}
+
+static SysError *future_error_copy(const SysError *error) {
+  SysError *copy = sys_error_new();
+
+  copy->message = sys_strdup(error->message);
+  copy->func = error->func;
+  copy->line = error->line;
+
+  return copy;
+}
+
+static void future_token_unlink(SysFuture *future) {
+  SysCancelToken *token = future->token;
+
+  sys_mutex_lock(&token->lock);
+  if (sys_hlist_is_linked(&future->token_link)) {
+    sys_hlist_unlink(&future->token_link);
+  }
+  sys_mutex_unlock(&token->lock);
+}
+
+static void future_callback_run(SysPointer data) {
+  SysFutureCallback *cb = data;
+
+  cb->func(cb->source, cb->data);
+
+  sys_future_unref(cb->source);
+  sys_slice_free(SysFutureCallback, cb);
+}
+
+static void future_callback_dispatch(SysFutureCallback *cb) {
+  sys_executor_execute(cb->executor, future_callback_run, cb);
+}
+
+/* only the first completion wins, the loser keeps @value and @error */
+static SysBool future_complete(SysFuture *future, SysFutureState state, SysPointer value, SysError *error) {
+  SysFutureCallback *cbs, *next, *fifo = NULL;
+
+  sys_mutex_lock(&future->lock);
+  if (future->state != SYS_FUTURE_PENDING) {
+    sys_mutex_unlock(&future->lock);
+    return false;
+  }
+
+  future->value = value;
+  future->error = error;
+  sys_atomic_int_store(&future->state, state, SYS_ATOMIC_RELEASE);
+
+  cbs = future->callbacks;
+  future->callbacks = NULL;
+
+  sys_cond_broadcast(&future->cond);
+  sys_mutex_unlock(&future->lock);
+
+  if (future->token) {
+    future_token_unlink(future);
+  }
+
+  for (; cbs; cbs = next) {
+    next = cbs->next;
+    cbs->next = fifo;
+    fifo = cbs;
+  }
+
+  for (; fifo; fifo = next) {
+    next = fifo->next;
+    future_callback_dispatch(fifo);
+  }
+
+  return true;
+}
+
+static void future_add_callback(SysFuture *future, SysFutureNotify func, SysPointer data, SysExecutor *executor) {
+  SysFutureCallback *cb = sys_slice_new(SysFutureCallback);
+
+  cb->func = func;
+  cb->data = data;
+  cb->executor = executor;
+  cb->source = sys_future_ref(future);
+
+  sys_mutex_lock(&future->lock);
+  if (future->state == SYS_FUTURE_PENDING) {
+    cb->next = future->callbacks;
+    future->callbacks = cb;
+    sys_mutex_unlock(&future->lock);
+
+    return;
+  }
+  sys_mutex_unlock(&future->lock);
+
+  future_callback_dispatch(cb);
+}
+
+/* refuses a future whose last reference is already gone */
+static SysBool future_try_ref(SysFuture *future) {
+  SysInt n = sys_atomic_int_load(&future->ref_count, SYS_ATOMIC_RELAXED);
+
+  do {
+    if (n == 0) {
+      return false;
+    }
+  } while (!sys_atomic_int_compare_exchange(&future->ref_count, &n, n + 1, SYS_ATOMIC_ACQ_REL));
+
+  return true;
+}
+
+SysFuture *sys_future_ref(SysFuture *future) {
+  sys_return_val_if_fail(future != NULL, NULL);
+
+  sys_ref_count_inc(future);
+
+  return future;
+}
+
+void sys_future_unref(SysFuture *future) {
+  sys_return_if_fail(future != NULL);
+
+  if (!sys_ref_count_dec(future)) {
+    return;
+  }
+
+  if (future->token) {
+    future_token_unlink(future);
+    sys_cancel_token_unref(future->token);
+  }
+
+  if (future->state == SYS_FUTURE_READY && future->value_destroy) {
+    future->value_destroy(future->value);
+  }
+
+  if (future->error) {
+    sys_error_free(future->error);
+  }
+
+  sys_cond_clear(&future->cond);
+  sys_mutex_clear(&future->lock);
+  sys_slice_free(SysFuture, future);
+}
+
+SysFutureState sys_future_get_state(SysFuture *future) {
+  sys_return_val_if_fail(future != NULL, SYS_FUTURE_PENDING);
+
+  return sys_atomic_int_load(&future->state, SYS_ATOMIC_ACQUIRE);
+}
+
+SysBool sys_future_is_done(SysFuture *future) {
+  return sys_future_get_state(future) != SYS_FUTURE_PENDING;
+}
+
+/**
+ * sys_future_get_value:
+ * @future: a #SysFuture
+ *
+ * Returns: the value of a ready future, %NULL in any other state. It
+ *   stays valid as long as @future is referenced.
+ */
+SysPointer sys_future_get_value(SysFuture *future) {
+  if (sys_future_get_state(future) != SYS_FUTURE_READY) {
+    return NULL;
+  }
+
+  return future->value;
+}
+
+const SysError *sys_future_get_error(SysFuture *future) {
+  if (sys_future_get_state(future) != SYS_FUTURE_FAILED) {
+    return NULL;
+  }
+
+  return future->error;
+}
+
+/**
+ * sys_future_cancel:
+ * @future: a #SysFuture
+ *
+ * Completes a pending @future as cancelled, its continuations run and a
+ * later value from the producer is dropped.
+ *
+ * Returns: %true if @future was still pending
+ */
+SysBool sys_future_cancel(SysFuture *future) {
+  sys_return_val_if_fail(future != NULL, false);
+
+  return future_complete(future, SYS_FUTURE_CANCELLED, NULL, NULL);
+}
+
+SysFutureState sys_future_wait(SysFuture *future) {
+  SysFutureState state;
+
+  sys_return_val_if_fail(future != NULL, SYS_FUTURE_PENDING);
+
+  sys_mutex_lock(&future->lock);
+  while (future->state == SYS_FUTURE_PENDING) {
+    sys_cond_wait(&future->cond, &future->lock);
+  }
+  state = future->state;
+  sys_mutex_unlock(&future->lock);
+
+  return state;
+}
+
+/**
+ * sys_future_wait_until:
+ * @future: a #SysFuture
+ * @end_time: the monotonic time to wait until
+ *
+ * Returns: %true if @future is done, %false if @end_time passed first
+ */
+SysBool sys_future_wait_until(SysFuture *future, SysInt64 end_time) {
+  SysBool done;
+
+  sys_return_val_if_fail(future != NULL, false);
+
+  sys_mutex_lock(&future->lock);
+  while (future->state == SYS_FUTURE_PENDING) {
+    if (!sys_cond_wait_until(&future->cond, &future->lock, end_time)) {
+      break;
+    }
+  }
+  done = future->state != SYS_FUTURE_PENDING;
+  sys_mutex_unlock(&future->lock);
+
+  return done;
+}
+
+/* cancel token */
+SysCancelToken *sys_cancel_token_new(void) {
+  SysCancelToken *token = sys_slice_new(SysCancelToken);
+
+  sys_ref_count_init(token);
+  token->cancelled = 0;
+  sys_mutex_init(&token->lock);
+  sys_hlist_init(&token->futures);
+
+  return token;
+}
+
+SysCancelToken *sys_cancel_token_ref(SysCancelToken *token) {
+  sys_return_val_if_fail(token != NULL, NULL);
+
+  sys_ref_count_inc(token);
+
+  return token;
+}
+
+void sys_cancel_token_unref(SysCancelToken *token) {
+  sys_return_if_fail(token != NULL);
+
+  if (!sys_ref_count_dec(token)) {
+    return;
+  }
+
+  sys_mutex_clear(&token->lock);
+  sys_slice_free(SysCancelToken, token);
+}
+
+/**
+ * sys_cancel_token_cancel:
+ * @token: a #SysCancelToken
+ *
+ * Cancels every pending future started with @token. Tasks already
+ * running see it through sys_cancel_token_is_cancelled(), tasks not
+ * started yet are skipped.
+ */
+void sys_cancel_token_cancel(SysCancelToken *token) {
+  SysFuture *future;
+  SysHList *node;
+
+  sys_return_if_fail(token != NULL);
+
+  sys_atomic_int_store(&token->cancelled, 1, SYS_ATOMIC_RELEASE);
+
+  while (true) {
+    sys_mutex_lock(&token->lock);
+    if (sys_hlist_is_empty(&token->futures)) {
+      sys_mutex_unlock(&token->lock);
+      break;
+    }
+
+    node = sys_hlist_first(&token->futures);
+    sys_hlist_unlink(node);
+    future = SYS_HLIST_CAST_TO(node, SysFuture, token_link);
+    if (!future_try_ref(future)) {
+      sys_mutex_unlock(&token->lock);
+      continue;
+    }
+    sys_mutex_unlock(&token->lock);
+
+    sys_future_cancel(future);
+    sys_future_unref(future);
+  }
+}
+
+SysBool sys_cancel_token_is_cancelled(SysCancelToken *token) {
+  sys_return_val_if_fail(token != NULL, false);
+
+  return sys_atomic_int_load(&token->cancelled, SYS_ATOMIC_ACQUIRE) != 0;
+}
+
+/* promise */
+SysPromise *sys_promise_new(void) {
+  return sys_promise_new_full(NULL);
+}
+
+/**
+ * sys_promise_new_full:
+ * @value_destroy: (nullable): frees the value with the future
+ *
+ * Returns: a new #SysPromise, free it with sys_promise_free()
+ */
+SysPromise *sys_promise_new_full(SysDestroyFunc value_destroy) {
+  SysPromise *promise = sys_slice_new(SysPromise);
+
+  promise->future = future_new(value_destroy);
+
+  return promise;
+}
+
+/**
+ * sys_promise_free:
+ * @promise: a #SysPromise
+ *
+ * A future still pending at this point fails, so no consumer waits
+ * forever on a producer that gave up.
+ */
+void sys_promise_free(SysPromise *promise) {
+  SysError *error = NULL;
+
+  sys_return_if_fail(promise != NULL);
+
+  if (!sys_future_is_done(promise->future)) {
+    sys_error_set_N(&error, "%s", "promise freed before it was completed");
+    if (!future_complete(promise->future, SYS_FUTURE_FAILED, NULL, error)) {
+      sys_error_free(error);
+    }
+  }
+
+  sys_future_unref(promise->future);
+  sys_slice_free(SysPromise, promise);
+}
+
+SysFuture *sys_promise_get_future(SysPromise *promise) {
+  sys_return_val_if_fail(promise != NULL, NULL);
+
+  return sys_future_ref(promise->future);
+}
+
+/**
+ * sys_promise_set_value:
+ * @promise: a #SysPromise
+ * @value: the result
+ *
+ * Returns: %false if the future was already done (cancelled), @value
+ *   is then freed right away when the promise owns values
+ */
+SysBool sys_promise_set_value(SysPromise *promise, SysPointer value) {
+  SysFuture *future;
+
+  sys_return_val_if_fail(promise != NULL, false);
+
+  future = promise->future;
+  if (future_complete(future, SYS_FUTURE_READY, value, NULL)) {
+    return true;
+  }
+
+  if (future->value_destroy) {
+    future->value_destroy(value);
+  }
+
+  return false;
+}
+
+/**
+ * sys_promise_set_error:
+ * @promise: a #SysPromise
+ * @error: (transfer full): the failure
+ *
+ * Returns: %false if the future was already done
+ */
+SysBool sys_promise_set_error(SysPromise *promise, SysError *error) {
+  sys_return_val_if_fail(promise != NULL, false);
+  sys_return_val_if_fail(error != NULL, false);
+
+  if (future_complete(promise->future, SYS_FUTURE_FAILED, NULL, error)) {
+    return true;
+  }
+
+  sys_error_free(error);
+
+  return false;
+}
+
+SysBool sys_promise_is_cancelled(SysPromise *promise) {
+  sys_return_val_if_fail(promise != NULL, false);
+
+  return sys_future_get_state(promise->future) == SYS_FUTURE_CANCELLED;
+}
+
+/* combinators */
+static void future_finish(SysFuture *future, SysPointer value, SysError *error) {
+  if (error) {
+    if (!future_complete(future, SYS_FUTURE_FAILED, NULL, error)) {
+      sys_error_free(error);
+    }
+  } else {
+    future_complete(future, SYS_FUTURE_READY, value, NULL);
+  }
+}
+
+/* completes @future the way @source failed or was cancelled */
+static void future_forward(SysFuture *future, SysFuture *source) {
+  SysError *error;
+
+  if (source->state == SYS_FUTURE_CANCELLED) {
+    future_complete(future, SYS_FUTURE_CANCELLED, NULL, NULL);
+    return;
+  }
+
+  error = future_error_copy(source->error);
+  if (!future_complete(future, SYS_FUTURE_FAILED, NULL, error)) {
+    sys_error_free(error);
+  }
+}
+
+static void future_task_run(SysPointer data) {
+  SysFutureTask *task = data;
+  SysError *error = NULL;
+  SysPointer value;
+
+  if (sys_future_is_done(task->future)
+      || (task->token && sys_cancel_token_is_cancelled(task->token))) {
+    future_complete(task->future, SYS_FUTURE_CANCELLED, NULL, NULL);
+  } else {
+    value = task->func(task->token, task->user_data, &error);
+    future_finish(task->future, value, error);
+  }
+
+  sys_future_unref(task->future);
+  sys_slice_free(SysFutureTask, task);
+}
+
+/**
+ * sys_future_run:
+ * @executor: (nullable): where to run @func, %NULL to run it now
+ * @func: the task
+ * @user_data: argument of @func
+ * @token: (nullable): token to cancel the task with
+ *
+ * Runs @func and completes the returned future with its result or
+ * the error it sets. The value is not owned by the future.
+ *
+ * Returns: a new #SysFuture
+ */
+SysFuture *sys_future_run(SysExecutor *executor,
+    SysFutureTaskFunc func,
+    SysPointer user_data,
+    SysCancelToken *token) {
+  SysFutureTask *task;
+  SysFuture *future;
+
+  sys_return_val_if_fail(func != NULL, NULL);
+
+  future = future_new(NULL);
+
+  if (token) {
+    future->token = sys_cancel_token_ref(token);
+
+    sys_mutex_lock(&token->lock);
+    if (sys_cancel_token_is_cancelled(token)) {
+      sys_mutex_unlock(&token->lock);
+      future_complete(future, SYS_FUTURE_CANCELLED, NULL, NULL);
+
+      return future;
+    }
+    sys_hlist_add_tail(&token->futures, &future->token_link);
+    sys_mutex_unlock(&token->lock);
+  }
+
+  task = sys_slice_new(SysFutureTask);
+  task->future = sys_future_ref(future);
+  task->func = func;
+  task->user_data = user_data;
+  task->token = token;
+
+  sys_executor_execute(executor, future_task_run, task);
+
+  return future;
+}
+
+static void future_then_notify(SysFuture *source, SysPointer data) {
+  SysFutureThen *then = data;
+  SysError *error = NULL;
+  SysPointer value;
+
+  if (sys_future_is_done(then->derived)) {
+    /* cancelled by its consumer, nobody wants the result */
+  } else if (source->state == SYS_FUTURE_READY) {
+    value = then->func(source, then->user_data, &error);
+    future_finish(then->derived, value, error);
+  } else {
+    future_forward(then->derived, source);
+  }
+
+  sys_future_unref(then->derived);
+  sys_slice_free(SysFutureThen, then);
+}
+
+/**
+ * sys_future_then:
+ * @future: a #SysFuture
+ * @executor: (nullable): where to run @func, %NULL to run it on the
+ *   thread completing @future
+ * @func: continuation, called only if @future is ready
+ * @user_data: argument of @func
+ *
+ * Chains @func after @future. A failed or cancelled @future completes
+ * the returned future the same way without calling @func.
+ *
+ * Returns: a new #SysFuture for the result of @func
+ */
+SysFuture *sys_future_then(SysFuture *future,
+    SysExecutor *executor,
+    SysFutureThenFunc func,
+    SysPointer user_data) {
+  SysFutureThen *then;
+  SysFuture *derived;
+
+  sys_return_val_if_fail(future != NULL, NULL);
+  sys_return_val_if_fail(func != NULL, NULL);
+
+  derived = future_new(NULL);
+
+  then = sys_slice_new(SysFutureThen);
+  then->derived = sys_future_ref(derived);
+  then->func = func;
+  then->user_data = user_data;
+
+  future_add_callback(future, future_then_notify, then, executor);
+
+  return derived;
+}
+
+static void future_join_release(SysFutureJoin *join) {
+  if (!sys_atomic_int_dec_and_test(&join->remaining)) {
+    return;
+  }
+
+  future_complete(join->result, SYS_FUTURE_READY, NULL, NULL);
+
+  sys_future_unref(join->result);
+  sys_slice_free(SysFutureJoin, join);
+}
+
+static void future_all_notify(SysFuture *source, SysPointer data) {
+  SysFutureJoin *join = data;
+
+  if (source->state != SYS_FUTURE_READY) {
+    future_forward(join->result, source);
+  }
+
+  future_join_release(join);
+}
+
+static void future_any_notify(SysFuture *source, SysPointer data) {
+  SysFutureJoin *join = data;
+
+  sys_future_ref(source);
+  if (!future_complete(join->result, SYS_FUTURE_READY, source, NULL)) {
+    sys_future_unref(source);
+  }
+
+  future_join_release(join);
+}
+
+static SysFuture *future_join(SysFuture **futures, SysUInt n_futures, SysFutureNotify func, SysDestroyFunc value_destroy) {
+  SysFutureJoin *join;
+  SysFuture *result;
+  SysUInt i;
+
+  result = future_new(value_destroy);
+
+  join = sys_slice_new(SysFutureJoin);
+  join->result = sys_future_ref(result);
+  /* one extra count so the join is not released while still adding */
+  join->remaining = n_futures + 1;
+
+  for (i = 0; i < n_futures; i++) {
+    future_add_callback(futures[i], func, join, NULL);
+  }
+
+  future_join_release(join);
+
+  return result;
+}
+
+/**
+ * sys_future_when_all:
+ * @futures: (array length=n_futures): futures to wait for
+ * @n_futures: length of @futures
+ *
+ * Returns: a new #SysFuture, ready with a %NULL value once all of
+ *   @futures are ready, or failed or cancelled like the first of them
+ *   that was not
+ */
+SysFuture *sys_future_when_all(SysFuture **futures, SysUInt n_futures) {
+  sys_return_val_if_fail(futures != NULL || n_futures == 0, NULL);
+
+  return future_join(futures, n_futures, future_all_notify, NULL);
+}
+
+/**
+ * sys_future_when_any:
+ * @futures: (array length=n_futures): futures to wait for
+ * @n_futures: length of @futures, at least 1
+ *
+ * Returns: a new #SysFuture whose value is the first of @futures to
+ *   be done, referenced by the result, whatever its state
+ */
+SysFuture *sys_future_when_any(SysFuture **futures, SysUInt n_futures) {
+  sys_return_val_if_fail(futures != NULL, NULL);
+  sys_return_val_if_fail(n_futures > 0, NULL);
+
+  return future_join(futures, n_futures, future_any_notify, (SysDestroyFunc)sys_future_unref);
+}
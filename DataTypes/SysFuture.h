@@ -0,0 +1,94 @@
+#ifndef __SYS_FUTURE_H__
+#define __SYS_FUTURE_H__
+
+#include <System/Fundamental/SysCommonCore.h>
+#include <System/Platform/Common/SysThread.h>
+
+SYS_BEGIN_DECLS
+
+/**
+ * SysFuture: result of an asynchronous computation.
+ *
+ * A #SysPromise is the producer end, it completes its future once with
+ * a value or an error. Consumers wait on the future, poll it, or chain
+ * continuations with sys_future_then(); a continuation runs on the
+ * thread that completes the future, or on a #SysExecutor when one is
+ * given, so a pipeline never blocks a thread while it is pending.
+ *
+ * Futures are reference counted and thread safe. A value is owned by
+ * the future only when the promise was created with a destroy function.
+ */
+
+typedef struct _SysFuture SysFuture;
+typedef struct _SysPromise SysPromise;
+typedef struct _SysCancelToken SysCancelToken;
+typedef struct _SysExecutor SysExecutor;
+
+typedef enum {
+  SYS_FUTURE_PENDING,
+  SYS_FUTURE_READY,
+  SYS_FUTURE_FAILED,
+  SYS_FUTURE_CANCELLED
+} SysFutureState;
+
+typedef void (*SysExecutorFunc)(SysPointer data);
+typedef SysPointer (*SysFutureTaskFunc)(SysCancelToken *token, SysPointer user_data, SysError **error);
+typedef SysPointer (*SysFutureThenFunc)(SysFuture *source, SysPointer user_data, SysError **error);
+
+/**
+ * SysExecutor: where continuations and tasks run.
+ *
+ * @execute: runs @func with @data at some later point, may be called
+ *   from any thread
+ * @free: releases the executor, %NULL if it is not owned by the caller
+ *
+ * Embed it as first member to provide your own executor.
+ */
+struct _SysExecutor {
+  void (*execute)(SysExecutor *self, SysExecutorFunc func, SysPointer data);
+  void (*free)(SysExecutor *self);
+};
+
+SYS_API SysExecutor *sys_executor_new_threads(SysUInt n_threads);
+SYS_API void sys_executor_execute(SysExecutor *executor, SysExecutorFunc func, SysPointer data);
+SYS_API void sys_executor_free(SysExecutor *executor);
+
+SYS_API SysCancelToken *sys_cancel_token_new(void);
+SYS_API SysCancelToken *sys_cancel_token_ref(SysCancelToken *token);
+SYS_API void sys_cancel_token_unref(SysCancelToken *token);
+SYS_API void sys_cancel_token_cancel(SysCancelToken *token);
+SYS_API SysBool sys_cancel_token_is_cancelled(SysCancelToken *token);
+
+SYS_API SysPromise *sys_promise_new(void);
+SYS_API SysPromise *sys_promise_new_full(SysDestroyFunc value_destroy);
+SYS_API void sys_promise_free(SysPromise *promise);
+SYS_API SysFuture *sys_promise_get_future(SysPromise *promise);
+SYS_API SysBool sys_promise_set_value(SysPromise *promise, SysPointer value);
+SYS_API SysBool sys_promise_set_error(SysPromise *promise, SysError *error);
+SYS_API SysBool sys_promise_is_cancelled(SysPromise *promise);
+
+SYS_API SysFuture *sys_future_ref(SysFuture *future);
+SYS_API void sys_future_unref(SysFuture *future);
+SYS_API SysFutureState sys_future_get_state(SysFuture *future);
+SYS_API SysBool sys_future_is_done(SysFuture *future);
+SYS_API SysPointer sys_future_get_value(SysFuture *future);
+SYS_API const SysError *sys_future_get_error(SysFuture *future);
+SYS_API SysBool sys_future_cancel(SysFuture *future);
+
+SYS_API SysFutureState sys_future_wait(SysFuture *future);
+SYS_API SysBool sys_future_wait_until(SysFuture *future, SysInt64 end_time);
+
+SYS_API SysFuture *sys_future_run(SysExecutor *executor,
+    SysFutureTaskFunc func,
+    SysPointer user_data,
+    SysCancelToken *token);
+SYS_API SysFuture *sys_future_then(SysFuture *future,
+    SysExecutor *executor,
+    SysFutureThenFunc func,
+    SysPointer user_data);
+SYS_API SysFuture *sys_future_when_all(SysFuture **futures, SysUInt n_futures);
+SYS_API SysFuture *sys_future_when_any(SysFuture **futures, SysUInt n_futures);
+
+SYS_END_DECLS
+
+#endif
@@ -0,0 +1,118 @@
+#include <System/DataTypes/SysHList.h>
+
+SysUInt sys_hlist_length(SysHList *head) {
+  SysUInt len = 0;
+
+  sys_return_val_if_fail(SYS_HLIST_CHECK(head), 0);
+
+  sys_hlist_foreach(head, node) {
+    len++;
+  }
+
+  return len;
+}
+
+/* links first..last between prev and next */
+static void sys_hlist_link_range(SysHList *prev, SysHList *next, SysHList *first, SysHList *last) {
+  first->prev = prev;
+  prev->next = first;
+  last->next = next;
+  next->prev = last;
+}
+
+/**
+ * sys_hlist_splice_head:
+ * @head: the list to move entries to
+ * @list: the list to take entries from, left empty
+ *
+ * Moves every entry of @list to the front of @head in O(1).
+ */
+void sys_hlist_splice_head(SysHList *head, SysHList *list) {
+  SysHList *first, *last;
+
+  sys_return_if_fail(SYS_HLIST_CHECK(head));
+  sys_return_if_fail(SYS_HLIST_CHECK(list));
+
+  if (sys_hlist_is_empty(list)) {
+    return;
+  }
+
+  first = list->next;
+  last = list->prev;
+  sys_hlist_init(list);
+
+  sys_hlist_link_range(head, head->next, first, last);
+}
+
+/**
+ * sys_hlist_splice_tail:
+ * @head: the list to move entries to
+ * @list: the list to take entries from, left empty
+ *
+ * Moves every entry of @list to the back of @head in O(1).
+ */
+void sys_hlist_splice_tail(SysHList *head, SysHList *list) {
+  SysHList *first, *last;
+
+  sys_return_if_fail(SYS_HLIST_CHECK(head));
+  sys_return_if_fail(SYS_HLIST_CHECK(list));
+
+  if (sys_hlist_is_empty(list)) {
+    return;
+  }
+
+  first = list->next;
+  last = list->prev;
+  sys_hlist_init(list);
+
+  sys_hlist_link_range(head->prev, head, first, last);
+}
+
+/**
+ * sys_hlist_move_range:
+ * @head: the list to move entries to
+ * @first: first entry of the run to move
+ * @last: last entry of the run, @first itself or one after it
+ *
+ * Cuts the run first..last out of whatever list holds it and appends it
+ * to @head in O(1). The run must not contain @head.
+ */
+void sys_hlist_move_range(SysHList *head, SysHList *first, SysHList *last) {
+  sys_return_if_fail(SYS_HLIST_CHECK(head));
+  sys_return_if_fail(SYS_HLIST_CHECK(first));
+  sys_return_if_fail(SYS_HLIST_CHECK(last));
+
+  first->prev->next = last->next;
+  last->next->prev = first->prev;
+
+  sys_hlist_link_range(head->prev, head, first, last);
+}
+
+/**
+ * sys_hlist_cut_after:
+ * @head: the list to cut
+ * @list: an empty list that receives the cut entries
+ * @node: an entry of @head, or @head itself to move everything
+ *
+ * Moves every entry after @node to @list, keeping their order.
+ */
+void sys_hlist_cut_after(SysHList *head, SysHList *list, SysHList *node) {
+  SysHList *first, *last;
+
+  sys_return_if_fail(SYS_HLIST_CHECK(head));
+  sys_return_if_fail(SYS_HLIST_CHECK(list));
+  sys_return_if_fail(SYS_HLIST_CHECK(node));
+  sys_return_if_fail(sys_hlist_is_empty(list));
+
+  if (node->next == head) {
+    return;
+  }
+
+  first = node->next;
+  last = head->prev;
+
+  node->next = head;
+  head->prev = node;
+
+  sys_hlist_link_range(list, list, first, last);
+}
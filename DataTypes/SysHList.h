@@ -0,0 +1,140 @@
+#ifndef __SYS_HLIST_H__
+#define __SYS_HLIST_H__
+
+#include <System/Fundamental/SysCommonCore.h>
+
+SYS_BEGIN_DECLS
+
+/**
+ * SysHList: intrusive circular doubly linked list.
+ *
+ * A list is a SysHList head embedded anywhere, entries embed a SysHList
+ * link and get back to their struct with SYS_HLIST_CAST_TO. An empty
+ * list and an unlinked entry point to themselves, so insert and unlink
+ * are O(1) and never allocate. The check word only exists in SYS_DEBUG
+ * builds.
+ */
+
+typedef struct _SysHList SysHList;
+
+struct _SysHList {
+  SysHList *next;
+  SysHList *prev;
+#if SYS_DEBUG
+  SysInt check;
+#endif
+};
+
+#define SYS_HLIST_CAST_TO(o, TypeName, member) SYS_HDATA_CAST_TO(o, TypeName, member)
+#define SYS_HLIST(o) SYS_HDATA(o, SysHList)
+
+#if SYS_DEBUG
+#define SYS_HLIST_CHECK(o) SYS_HDATA_CHECK(o)
+#define SYS_HLIST_INIT(name) { &(name), &(name), SYS_HDATA_CHECK_VALUE }
+#else
+#define SYS_HLIST_CHECK(o) ((o) != NULL)
+#define SYS_HLIST_INIT(name) { &(name), &(name) }
+#endif
+
+#define sys_hlist_foreach(head, node) \
+    for(SysHList *node = (head)->next; node != (head); node = node->next)
+
+#define sys_hlist_foreach_reverse(head, node) \
+    for(SysHList *node = (head)->prev; node != (head); node = node->prev)
+
+/* node may be unlinked or freed inside the loop */
+#define sys_hlist_foreach_safe(head, node, tmp) \
+    for(SysHList *node = (head)->next, *tmp = node->next; node != (head); node = tmp, tmp = node->next)
+
+SYS_API SysUInt sys_hlist_length(SysHList *head);
+SYS_API void sys_hlist_splice_head(SysHList *head, SysHList *list);
+SYS_API void sys_hlist_splice_tail(SysHList *head, SysHList *list);
+SYS_API void sys_hlist_move_range(SysHList *head, SysHList *first, SysHList *last);
+SYS_API void sys_hlist_cut_after(SysHList *head, SysHList *list, SysHList *node);
+
+static inline void sys_hlist_init(SysHList *node) {
+  node->next = node;
+  node->prev = node;
+#if SYS_DEBUG
+  node->check = SYS_HDATA_CHECK_VALUE;
+#endif
+}
+
+static inline SysBool sys_hlist_is_empty(const SysHList *head) {
+  return head->next == head;
+}
+
+static inline SysBool sys_hlist_is_linked(const SysHList *node) {
+  return node->next != node;
+}
+
+static inline void _sys_hlist_link(SysHList *prev, SysHList *next, SysHList *node) {
+  node->prev = prev;
+  node->next = next;
+  prev->next = node;
+  next->prev = node;
+}
+
+static inline void sys_hlist_insert_after(SysHList *pos, SysHList *node) {
+  sys_return_if_fail(SYS_HLIST_CHECK(pos));
+  sys_return_if_fail(SYS_HLIST_CHECK(node));
+
+  _sys_hlist_link(pos, pos->next, node);
+}
+
+static inline void sys_hlist_insert_before(SysHList *pos, SysHList *node) {
+  sys_return_if_fail(SYS_HLIST_CHECK(pos));
+  sys_return_if_fail(SYS_HLIST_CHECK(node));
+
+  _sys_hlist_link(pos->prev, pos, node);
+}
+
+#define sys_hlist_add_head(head, node) sys_hlist_insert_after((head), (node))
+#define sys_hlist_add_tail(head, node) sys_hlist_insert_before((head), (node))
+
+static inline void sys_hlist_unlink(SysHList *node) {
+  sys_return_if_fail(SYS_HLIST_CHECK(node));
+
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  node->next = node;
+  node->prev = node;
+}
+
+static inline void sys_hlist_move_head(SysHList *head, SysHList *node) {
+  sys_return_if_fail(SYS_HLIST_CHECK(head));
+  sys_return_if_fail(SYS_HLIST_CHECK(node));
+
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  _sys_hlist_link(head, head->next, node);
+}
+
+static inline void sys_hlist_move_tail(SysHList *head, SysHList *node) {
+  sys_return_if_fail(SYS_HLIST_CHECK(head));
+  sys_return_if_fail(SYS_HLIST_CHECK(node));
+
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  _sys_hlist_link(head->prev, head, node);
+}
+
+static inline SysHList* sys_hlist_first(SysHList *head) {
+  return head->next == head ? NULL : head->next;
+}
+
+static inline SysHList* sys_hlist_last(SysHList *head) {
+  return head->prev == head ? NULL : head->prev;
+}
+
+static inline SysHList* sys_hlist_next(SysHList *head, SysHList *node) {
+  return node->next == head ? NULL : node->next;
+}
+
+static inline SysHList* sys_hlist_prev(SysHList *head, SysHList *node) {
+  return node->prev == head ? NULL : node->prev;
+}
+
+SYS_END_DECLS
+
+#endif
@@ -1,5 +1,7 @@
 #include <System/DataTypes/SysHNode.h>
 #include <System/DataTypes/SysQueue.h>
+#include <System/Platform/Common/SysThread.h>
+#include <System/Platform/Common/SysAtomic.h>
 
 #define sys_hnode_alloc0()         sys_slice_new0 (SysHNode)
 #define sys_hnode_free(hnode)       sys_slice_free (SysHNode, hnode)
@@ -775,3 +777,730 @@ SysBool sys_hnode_has_one_child(SysHNode *self) {
   return self->children != NULL && self->next == NULL;
 }
 
+
+
+/* iterators */
+static SysBool sys_hnode_iter_descends (SysHNodeIter *iter,
+    SysHNode *node,
+    SysInt depth) {
+  return node->children != NULL && (iter->max_depth < 0 || depth + 1 < iter->max_depth);
+}
+
+static SysHNode* sys_hnode_iter_leftmost (SysHNodeIter *iter, SysHNode *node) {
+  while (sys_hnode_iter_descends (iter, node, iter->depth)) {
+    node = node->children;
+    iter->depth++;
+  }
+
+  return node;
+}
+
+static SysHNode* sys_hnode_iter_pre_next (SysHNodeIter *iter, SysHNode *node) {
+  if (sys_hnode_iter_descends (iter, node, iter->depth)) {
+    iter->depth++;
+    return node->children;
+  }
+
+  while (node != iter->root && node->next == NULL) {
+    node = node->parent;
+    iter->depth--;
+  }
+
+  return node == iter->root ? NULL : node->next;
+}
+
+static SysHNode* sys_hnode_iter_post_next (SysHNodeIter *iter, SysHNode *node) {
+  if (node == iter->root)
+    return NULL;
+
+  if (node->next)
+    return sys_hnode_iter_leftmost (iter, node->next);
+
+  iter->depth--;
+  return node->parent;
+}
+
+static SysHNode* sys_hnode_iter_in_next (SysHNodeIter *iter, SysHNode *node) {
+  SysHNode *parent;
+
+  if (sys_hnode_iter_descends (iter, node, iter->depth) && node->children->next) {
+    iter->depth++;
+    return sys_hnode_iter_leftmost (iter, node->children->next);
+  }
+
+  /* the subtree of node is done, climb to the next unvisited node */
+  while (node != iter->root) {
+    parent = node->parent;
+
+    if (node == parent->children) {
+      iter->depth--;
+      return parent;
+    }
+
+    if (node->next)
+      return sys_hnode_iter_leftmost (iter, node->next);
+
+    node = parent;
+    iter->depth--;
+  }
+
+  return NULL;
+}
+
+/* level order without a queue: a pruned preorder walk per level */
+static SysHNode* sys_hnode_iter_level_next (SysHNodeIter *iter, SysHNode *node) {
+  SysInt level = iter->level;
+  SysInt depth = level;
+  SysBool restarted = false;
+
+  while (true) {
+    if (depth < level && sys_hnode_iter_descends (iter, node, depth)) {
+      node = node->children;
+      depth++;
+
+    } else {
+      while (node != iter->root && node->next == NULL) {
+        node = node->parent;
+        depth--;
+      }
+
+      if (node == iter->root) {
+        level++;
+        if (restarted || (iter->max_depth > 0 && level >= iter->max_depth))
+          return NULL;
+
+        restarted = true;
+        depth = 0;
+        continue;
+      }
+
+      node = node->next;
+    }
+
+    if (depth == level)
+      break;
+  }
+
+  iter->level = level;
+  iter->depth = depth;
+
+  return node;
+}
+
+static SysHNode* sys_hnode_iter_queue_next (SysHNodeIter *iter) {
+  SysHNode *node, *child;
+  SysUInt tail;
+
+  if (iter->len == 0)
+    return NULL;
+
+  if (iter->level_left == 0) {
+    iter->level++;
+    iter->level_left = iter->len;
+  }
+
+  node = iter->queue[iter->head];
+  iter->head = (iter->head + 1) % iter->queue_size;
+  iter->len--;
+  iter->level_left--;
+
+  if (!sys_hnode_iter_descends (iter, node, iter->level))
+    return node;
+
+  for (child = node->children; child; child = child->next) {
+    if (iter->len == iter->queue_size) {
+      /* scratch is too small for this level, continue without it */
+      iter->queue = NULL;
+      iter->node = sys_hnode_iter_level_next (iter, node);
+      return node;
+    }
+
+    tail = (iter->head + iter->len) % iter->queue_size;
+    iter->queue[tail] = child;
+    iter->len++;
+  }
+
+  return node;
+}
+
+/**
+ * sys_hnode_iter_init:
+ * @iter: an uninitialized #SysHNodeIter
+ * @root: the root of the tree to walk
+ * @order: the order in which nodes are returned
+ * @flags: which types of children are to be returned
+ * @max_depth: maximum depth of the traversal, -1 for all
+ * @scratch: (nullable): buffer used as queue for %SYS_LEVEL_ORDER
+ * @scratch_len: number of nodes @scratch can hold
+ *
+ * Depth first orders follow the parent links and need no memory at all.
+ * Level order uses @scratch as a ring queue, it should hold the widest
+ * level plus one. Without it, or once it is full, level order falls back
+ * to one pruned walk per level, which is slower but never allocates.
+ */
+void sys_hnode_iter_init (SysHNodeIter *iter,
+    SysHNode    *root,
+    SysTraverseType    order,
+    SysTraverseFlags    flags,
+    SysInt     max_depth,
+    SysHNode    **scratch,
+    SysUInt     scratch_len) {
+  sys_return_if_fail (iter != NULL);
+  sys_return_if_fail (SYS_HNODE_CHECK (root));
+  sys_return_if_fail (order <= SYS_LEVEL_ORDER);
+  sys_return_if_fail (flags <= SYS_TRAVERSE_MASK);
+  sys_return_if_fail (max_depth == -1 || max_depth > 0);
+
+  iter->root = root;
+  iter->node = NULL;
+  iter->order = order;
+  iter->flags = flags;
+  iter->max_depth = max_depth;
+  iter->depth = 0;
+  iter->level = 0;
+  iter->queue = NULL;
+  iter->queue_size = 0;
+  iter->head = 0;
+  iter->len = 0;
+  iter->level_left = 0;
+
+  switch (order) {
+    case SYS_PRE_ORDER:
+      iter->node = root;
+      break;
+    case SYS_POST_ORDER:
+    case SYS_IN_ORDER:
+      iter->node = sys_hnode_iter_leftmost (iter, root);
+      break;
+    case SYS_LEVEL_ORDER:
+      if (scratch != NULL && scratch_len > 0) {
+        iter->queue = scratch;
+        iter->queue_size = scratch_len;
+        iter->queue[0] = root;
+        iter->len = 1;
+        iter->level_left = 1;
+      } else {
+        iter->node = root;
+      }
+      break;
+  }
+}
+
+static SysHNode* sys_hnode_iter_step (SysHNodeIter *iter) {
+  SysHNode *node;
+
+  if (iter->queue != NULL)
+    return sys_hnode_iter_queue_next (iter);
+
+  node = iter->node;
+  if (node == NULL)
+    return NULL;
+
+  switch (iter->order) {
+    case SYS_PRE_ORDER:
+      iter->node = sys_hnode_iter_pre_next (iter, node);
+      break;
+    case SYS_POST_ORDER:
+      iter->node = sys_hnode_iter_post_next (iter, node);
+      break;
+    case SYS_IN_ORDER:
+      iter->node = sys_hnode_iter_in_next (iter, node);
+      break;
+    case SYS_LEVEL_ORDER:
+      iter->node = sys_hnode_iter_level_next (iter, node);
+      break;
+  }
+
+  return node;
+}
+
+/**
+ * sys_hnode_iter_next:
+ * @iter: a #SysHNodeIter
+ *
+ * Returns: the next node in the order given to sys_hnode_iter_init(),
+ *   or %NULL when the walk is done
+ */
+SysHNode* sys_hnode_iter_next (SysHNodeIter *iter) {
+  SysHNode *node;
+
+  sys_return_val_if_fail (iter != NULL, NULL);
+
+  while ((node = sys_hnode_iter_step (iter)) != NULL) {
+    if (node->children ? (iter->flags & SYS_TRAVERSE_NON_LEAFS) : (iter->flags & SYS_TRAVERSE_LEAFS))
+      return node;
+  }
+
+  return NULL;
+}
+
+/* frozen layout */
+static SysUInt sys_hfrozen_push(SysHFrozen *frozen, SysHNode *node, SysInt parent, SysUInt depth) {
+  SysHFrozenEntry *entry;
+
+  if (frozen->len == frozen->alloc) {
+    frozen->alloc = max(frozen->alloc * 2, 16);
+    frozen->entries = sys_renew(SysHFrozenEntry, frozen->entries, frozen->alloc);
+  }
+
+  entry = &frozen->entries[frozen->len];
+  entry->node = node;
+  entry->parent = parent;
+  entry->size = 1;
+  entry->depth = depth;
+
+  return frozen->len++;
+}
+
+/**
+ * sys_hnode_freeze:
+ * @root: the root of the tree to freeze, its siblings are not included
+ *
+ * Walks the tree once without recursion and records it in preorder.
+ *
+ * Returns: a new #SysHFrozen, free with sys_hfrozen_free()
+ */
+SysHFrozen* sys_hnode_freeze(SysHNode *root) {
+  SysHFrozen *frozen;
+  SysHNode *node;
+  SysUInt idx;
+
+  sys_return_val_if_fail(SYS_HNODE_CHECK(root), NULL);
+
+  frozen = sys_new0(SysHFrozen, 1);
+  node = root;
+  idx = sys_hfrozen_push(frozen, node, -1, 0);
+
+  while (true) {
+    if (node->children) {
+      node = node->children;
+      idx = sys_hfrozen_push(frozen, node, (SysInt)idx, frozen->entries[idx].depth + 1);
+      continue;
+    }
+
+    /* close finished subtrees until one has a next sibling */
+    while (true) {
+      frozen->entries[idx].size = frozen->len - idx;
+
+      if (node == root) {
+        return frozen;
+      }
+
+      if (node->next) {
+        break;
+      }
+
+      node = node->parent;
+      idx = (SysUInt)frozen->entries[idx].parent;
+    }
+
+    node = node->next;
+    idx = sys_hfrozen_push(frozen, node, frozen->entries[idx].parent, frozen->entries[idx].depth);
+  }
+}
+
+void sys_hfrozen_free(SysHFrozen *frozen) {
+  sys_return_if_fail(frozen != NULL);
+
+  sys_free(frozen->entries);
+  sys_free(frozen);
+}
+
+SysHNode* sys_hfrozen_node(SysHFrozen *frozen, SysUInt index) {
+  sys_return_val_if_fail(frozen != NULL, NULL);
+  sys_return_val_if_fail(index < frozen->len, NULL);
+
+  return frozen->entries[index].node;
+}
+
+SysInt sys_hfrozen_parent(SysHFrozen *frozen, SysUInt index) {
+  sys_return_val_if_fail(frozen != NULL, -1);
+  sys_return_val_if_fail(index < frozen->len, -1);
+
+  return frozen->entries[index].parent;
+}
+
+SysInt sys_hfrozen_first_child(SysHFrozen *frozen, SysUInt index) {
+  sys_return_val_if_fail(frozen != NULL, -1);
+  sys_return_val_if_fail(index < frozen->len, -1);
+
+  return frozen->entries[index].size > 1 ? (SysInt)index + 1 : -1;
+}
+
+SysInt sys_hfrozen_next_sibling(SysHFrozen *frozen, SysUInt index) {
+  SysHFrozenEntry *entry, *parent;
+  SysUInt next;
+
+  sys_return_val_if_fail(frozen != NULL, -1);
+  sys_return_val_if_fail(index < frozen->len, -1);
+
+  entry = &frozen->entries[index];
+  if (entry->parent < 0) {
+    return -1;
+  }
+
+  next = index + entry->size;
+  parent = &frozen->entries[entry->parent];
+
+  return next < entry->parent + parent->size ? (SysInt)next : -1;
+}
+
+static SysBool sys_hfrozen_visit(SysHFrozenEntry *entry,
+    SysTraverseFlags flags,
+    SysHNodeTraverseFunc func,
+    SysPointer user_data) {
+  if (entry->size > 1) {
+    return (flags & SYS_TRAVERSE_NON_LEAFS) && func(entry->node, user_data);
+  }
+
+  return (flags & SYS_TRAVERSE_LEAFS) && func(entry->node, user_data);
+}
+
+static void sys_hfrozen_pre_order(SysHFrozen *frozen,
+    SysTraverseFlags flags,
+    SysInt max_depth,
+    SysHNodeTraverseFunc func,
+    SysPointer user_data) {
+  SysHFrozenEntry *entry;
+  SysUInt i = 0;
+
+  while (i < frozen->len) {
+    entry = &frozen->entries[i];
+
+    if (sys_hfrozen_visit(entry, flags, func, user_data)) {
+      return;
+    }
+
+    if (max_depth > 0 && entry->depth + 1 >= (SysUInt)max_depth) {
+      i += entry->size;
+    } else {
+      i++;
+    }
+  }
+}
+
+/* a node is visited once the scan leaves its subtree */
+static void sys_hfrozen_post_order(SysHFrozen *frozen,
+    SysTraverseFlags flags,
+    SysInt max_depth,
+    SysHNodeTraverseFunc func,
+    SysPointer user_data) {
+  SysHFrozenEntry *entries = frozen->entries;
+  SysHFrozenEntry *entry;
+  SysUInt i = 0, next;
+  SysInt p;
+
+  while (i < frozen->len) {
+    entry = &entries[i];
+
+    if (entry->size > 1 && !(max_depth > 0 && entry->depth + 1 >= (SysUInt)max_depth)) {
+      i++;
+      continue;
+    }
+
+    next = i + entry->size;
+    if (sys_hfrozen_visit(entry, flags, func, user_data)) {
+      return;
+    }
+
+    for (p = entry->parent; p >= 0 && p + entries[p].size <= next; p = entries[p].parent) {
+      if (sys_hfrozen_visit(&entries[p], flags, func, user_data)) {
+        return;
+      }
+    }
+
+    i = next;
+  }
+}
+
+static void sys_hfrozen_level_order(SysHFrozen *frozen,
+    SysTraverseFlags flags,
+    SysInt max_depth,
+    SysHNodeTraverseFunc func,
+    SysPointer user_data) {
+  SysHFrozenEntry *entry;
+  SysBool more_levels = true;
+  SysUInt level, i;
+
+  for (level = 0; more_levels && (max_depth < 0 || level < (SysUInt)max_depth); level++) {
+    more_levels = false;
+
+    for (i = 0; i < frozen->len;) {
+      entry = &frozen->entries[i];
+
+      if (entry->depth < level) {
+        i++;
+        continue;
+      }
+
+      if (sys_hfrozen_visit(entry, flags, func, user_data)) {
+        return;
+      }
+
+      more_levels |= entry->size > 1;
+      i += entry->size;
+    }
+  }
+}
+
+/**
+ * sys_hfrozen_traverse:
+ * @frozen: a #SysHFrozen
+ * @order: SYS_PRE_ORDER, SYS_POST_ORDER or SYS_LEVEL_ORDER
+ * @flags: which types of children are to be visited
+ * @max_depth: maximum depth of the traversal, -1 for all
+ * @func: called for each node, returns true to stop
+ * @user_data: passed to @func
+ *
+ * Same visiting order as sys_hnode_traverse(), done as linear scans
+ * of the frozen array without recursion.
+ */
+void sys_hfrozen_traverse(SysHFrozen *frozen,
+    SysTraverseType order,
+    SysTraverseFlags flags,
+    SysInt max_depth,
+    SysHNodeTraverseFunc func,
+    SysPointer user_data) {
+  sys_return_if_fail(frozen != NULL);
+  sys_return_if_fail(func != NULL);
+  sys_return_if_fail(order != SYS_IN_ORDER && order <= SYS_LEVEL_ORDER);
+  sys_return_if_fail(flags <= SYS_TRAVERSE_MASK);
+  sys_return_if_fail(max_depth == -1 || max_depth > 0);
+
+  switch (order) {
+    case SYS_PRE_ORDER:
+      sys_hfrozen_pre_order(frozen, flags, max_depth, func, user_data);
+      break;
+    case SYS_POST_ORDER:
+      sys_hfrozen_post_order(frozen, flags, max_depth, func, user_data);
+      break;
+    default:
+      sys_hfrozen_level_order(frozen, flags, max_depth, func, user_data);
+      break;
+  }
+}
+
+
+/* parallel traversal */
+#define SYS_HNODE_PARALLEL_THRESHOLD 4096
+
+typedef struct _SysHNodeParallel SysHNodeParallel;
+typedef struct _SysHNodeWorker SysHNodeWorker;
+
+struct _SysHNodeParallel {
+  SysHFrozen *frozen;
+  const SysHNodeParallelFuncs *funcs;
+  SysPointer user_data;
+  /* start and end of each task, a task is a run of sibling subtrees */
+  SysUInt *tasks;
+  SysInt n_tasks;
+  SysInt next_task;
+};
+
+struct _SysHNodeWorker {
+  SysHNodeParallel *job;
+  SysPointer local;
+};
+
+/* frozen[start, end) is a forest of whole subtrees */
+static void sys_hnode_parallel_run_range(SysHNodeParallel *job,
+    SysUInt start,
+    SysUInt end,
+    SysPointer local) {
+  const SysHNodeParallelFuncs *funcs = job->funcs;
+  SysHFrozenEntry *entries = job->frozen->entries;
+  SysHFrozenEntry *entry;
+  SysUInt i;
+  SysInt p;
+
+  for (i = start; i < end; i++) {
+    entry = &entries[i];
+
+    if (funcs->pre) {
+      funcs->pre(entry->node, local, job->user_data);
+    }
+
+    if (entry->size > 1 || funcs->post == NULL) {
+      continue;
+    }
+
+    funcs->post(entry->node, local, job->user_data);
+    for (p = entry->parent; p >= (SysInt)start && p + entries[p].size <= i + 1; p = entries[p].parent) {
+      funcs->post(entries[p].node, local, job->user_data);
+    }
+  }
+}
+
+static SysPointer sys_hnode_parallel_worker(SysPointer data) {
+  SysHNodeWorker *worker = data;
+  SysHNodeParallel *job = worker->job;
+  SysInt task;
+
+  while (true) {
+    do {
+      task = sys_atomic_int_get(&job->next_task);
+      if (task >= job->n_tasks) {
+        return NULL;
+      }
+    } while (!sys_atomic_cmpxchg(&job->next_task, task, task + 1));
+
+    sys_hnode_parallel_run_range(job,
+        job->tasks[task * 2],
+        job->tasks[task * 2 + 1],
+        worker->local);
+  }
+}
+
+/*
+ * Subtrees larger than threshold are split: their hooks run on the
+ * calling thread, pre before the workers start and post after they are
+ * joined. Everything else is cut into tasks of adjacent siblings.
+ */
+static SysUInt sys_hnode_parallel_plan(SysHNodeParallel *job,
+    SysUInt threshold,
+    SysUInt *splits,
+    SysPointer local) {
+  SysHFrozenEntry *entries = job->frozen->entries;
+  SysHFrozenEntry *entry;
+  SysUInt i = 0, end, parent_end, n_splits = 0;
+
+  while (i < job->frozen->len) {
+    entry = &entries[i];
+
+    if (entry->size > threshold) {
+      if (job->funcs->pre) {
+        job->funcs->pre(entry->node, local, job->user_data);
+      }
+
+      splits[n_splits++] = i++;
+      continue;
+    }
+
+    parent_end = entries[entry->parent].size + (SysUInt)entry->parent;
+    end = i + entry->size;
+    while (end < parent_end
+        && entries[end].size <= threshold
+        && end - i + entries[end].size <= threshold) {
+      end += entries[end].size;
+    }
+
+    job->tasks[job->n_tasks * 2] = i;
+    job->tasks[job->n_tasks * 2 + 1] = end;
+    job->n_tasks++;
+    i = end;
+  }
+
+  return n_splits;
+}
+
+/**
+ * sys_hnode_parallel_traverse:
+ * @root: the root of the tree
+ * @funcs: the hooks to run
+ * @n_threads: number of workers including the caller, 0 for one per CPU
+ * @threshold: largest subtree handled by a single worker, 0 for default
+ * @user_data: passed to every hook
+ *
+ * Visits every node under @root once, fork-joining independent subtrees
+ * over worker threads. The calling thread is one of the workers and
+ * trees no larger than @threshold are walked on it alone. Hooks of
+ * unrelated subtrees may run concurrently, the tree must not change
+ * until the call returns.
+ */
+void sys_hnode_parallel_traverse(SysHNode *root,
+    const SysHNodeParallelFuncs *funcs,
+    SysUInt n_threads,
+    SysUInt threshold,
+    SysPointer user_data) {
+  SysHNodeParallel job;
+  SysHNodeWorker *workers;
+  SysThread **threads;
+  SysUInt *splits, *open;
+  SysUInt i, n_splits, n_open, s;
+
+  sys_return_if_fail(SYS_HNODE_CHECK(root));
+  sys_return_if_fail(funcs != NULL);
+
+  if (threshold == 0) {
+    threshold = SYS_HNODE_PARALLEL_THRESHOLD;
+  }
+
+  if (n_threads == 0) {
+    n_threads = max(sys_get_num_processors(), 1);
+  }
+
+  job.frozen = sys_hnode_freeze(root);
+  job.funcs = funcs;
+  job.user_data = user_data;
+  job.tasks = NULL;
+  job.n_tasks = 0;
+  job.next_task = 0;
+
+  if (job.frozen->len <= threshold) {
+    n_threads = 1;
+  }
+
+  workers = sys_new0(SysHNodeWorker, n_threads);
+  for (i = 0; i < n_threads; i++) {
+    workers[i].job = &job;
+    workers[i].local = funcs->local_new ? funcs->local_new(user_data) : NULL;
+  }
+
+  if (n_threads == 1) {
+    sys_hnode_parallel_run_range(&job, 0, job.frozen->len, workers[0].local);
+
+  } else {
+    splits = sys_new(SysUInt, job.frozen->len);
+    job.tasks = sys_new(SysUInt, job.frozen->len * 2);
+    n_splits = sys_hnode_parallel_plan(&job, threshold, splits, workers[0].local);
+
+    threads = sys_new0(SysThread *, n_threads);
+    for (i = 1; i < n_threads; i++) {
+      threads[i] = sys_thread_new("hnode-worker", sys_hnode_parallel_worker, &workers[i]);
+    }
+
+    sys_hnode_parallel_worker(&workers[0]);
+
+    for (i = 1; i < n_threads; i++) {
+      sys_thread_join(threads[i]);
+    }
+
+    /* post hooks of split nodes, a split is closed once the next one
+     * starts outside of it */
+    if (funcs->post) {
+      open = sys_new(SysUInt, n_splits);
+      n_open = 0;
+
+      for (i = 0; i <= n_splits; i++) {
+        while (n_open > 0) {
+          s = open[n_open - 1];
+          if (i < n_splits && splits[i] < s + job.frozen->entries[s].size) {
+            break;
+          }
+
+          funcs->post(job.frozen->entries[s].node, workers[0].local, user_data);
+          n_open--;
+        }
+
+        if (i < n_splits) {
+          open[n_open++] = splits[i];
+        }
+      }
+
+      sys_free(open);
+    }
+
+    sys_free(threads);
+    sys_free(job.tasks);
+    sys_free(splits);
+  }
+
+  for (i = 0; i < n_threads; i++) {
+    if (funcs->local_merge) {
+      funcs->local_merge(workers[i].local, user_data);
+    }
+  }
+
+  sys_free(workers);
+  sys_hfrozen_free(job.frozen);
+}
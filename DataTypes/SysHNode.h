@@ -16,12 +16,19 @@ SYS_BEGIN_DECLS
 #define SYS_HNODE_CHECK(o) SYS_HDATA_CHECK(o)
 
 typedef struct _SysHNode  SysHNode;
+typedef struct _SysHNodeIter SysHNodeIter;
+typedef struct _SysHFrozen SysHFrozen;
+typedef struct _SysHFrozenEntry SysHFrozenEntry;
+typedef struct _SysHNodeParallelFuncs SysHNodeParallelFuncs;
 
 typedef SysBool (*SysHNodeTraverseFunc) (SysHNode        *hnode,
        SysPointer user_data);
 typedef void  (*SysHNodeForeachFunc) (SysHNode        *hnode,
        SysPointer user_data);
 typedef SysBool (*SysHNodeFunc) (SysHNode* node, SysPointer user_data);
+typedef void (*SysHNodeVisitFunc) (SysHNode *hnode, SysPointer local, SysPointer user_data);
+typedef SysPointer (*SysHNodeLocalNewFunc) (SysPointer user_data);
+typedef void (*SysHNodeLocalMergeFunc) (SysPointer local, SysPointer user_data);
 
 struct _SysHNode
 {
@@ -35,6 +42,67 @@ struct _SysHNode
   SysInt check;
 };
 
+/**
+ * SysHNodeIter: external cursor over a SysHNode tree.
+ *
+ * Walks the tree without recursion and without allocating, so loops can
+ * stop at any point without a callback. The tree must not be changed
+ * while a cursor is in use.
+ */
+struct _SysHNodeIter
+{
+  /* <private> */
+  SysHNode *root;
+  SysHNode *node;
+  SysTraverseType order;
+  SysTraverseFlags flags;
+  SysInt max_depth;
+  SysInt depth;
+  SysInt level;
+  SysHNode **queue;
+  SysUInt queue_size;
+  SysUInt head;
+  SysUInt len;
+  SysUInt level_left;
+};
+
+/**
+ * SysHFrozen: a SysHNode tree laid out as a preorder array.
+ *
+ * entries[i + 1 .. i + size) is the subtree of entries[i], so the
+ * first child of i is i + 1 and its next sibling is i + size.
+ * It is a snapshot, any change to the original tree invalidates it.
+ */
+struct _SysHFrozenEntry {
+  SysHNode *node;
+  SysInt parent;
+  SysUInt size;
+  SysUInt depth;
+};
+
+struct _SysHFrozen {
+  SysHFrozenEntry *entries;
+  SysUInt len;
+
+  /* <private> */
+  SysUInt alloc;
+};
+
+/**
+ * SysHNodeParallelFuncs: hooks of sys_hnode_parallel_traverse().
+ *
+ * @pre is called for a node before its descendants and @post after
+ * them. Both get the accumulator of the calling worker, made by
+ * @local_new and handed back to @local_merge on the calling thread
+ * once every worker is done. All members may be %NULL.
+ */
+struct _SysHNodeParallelFuncs {
+  SysHNodeVisitFunc pre;
+  SysHNodeVisitFunc post;
+  SysHNodeLocalNewFunc local_new;
+  SysHNodeLocalMergeFunc local_merge;
+};
+
 SYS_API SysBool sys_hnode_has_one_child(SysHNode *self);
 SYS_API SysHNode*  sys_hnode_new  (void);
 SYS_API void  sys_hnode_destroy  (SysHNode    *root);
@@ -72,6 +140,15 @@ SYS_API void  sys_hnode_traverse (SysHNode    *root,
 
 SYS_API SysUInt  sys_hnode_max_height  (SysHNode *root);
 
+SYS_API void  sys_hnode_iter_init (SysHNodeIter *iter,
+     SysHNode    *root,
+     SysTraverseType    order,
+     SysTraverseFlags    flags,
+     SysInt     max_depth,
+     SysHNode    **scratch,
+     SysUInt     scratch_len);
+SYS_API SysHNode*  sys_hnode_iter_next (SysHNodeIter *iter);
+
 SYS_API void  sys_hnode_children_foreach (SysHNode    *hnode,
       SysTraverseFlags   flags,
       SysHNodeForeachFunc func,
@@ -109,6 +186,25 @@ SYS_API SysHNode* sys_hnode_next(SysHNode* self);
 SYS_API SysHNode* sys_hnode_prev(SysHNode* self);
 SYS_API void sys_hnode_init(SysHNode* node);
 
+SYS_API void sys_hnode_parallel_traverse(SysHNode *root,
+    const SysHNodeParallelFuncs *funcs,
+    SysUInt n_threads,
+    SysUInt threshold,
+    SysPointer user_data);
+
+SYS_API SysHFrozen* sys_hnode_freeze(SysHNode *root);
+SYS_API void sys_hfrozen_free(SysHFrozen *frozen);
+SYS_API SysHNode* sys_hfrozen_node(SysHFrozen *frozen, SysUInt index);
+SYS_API SysInt sys_hfrozen_parent(SysHFrozen *frozen, SysUInt index);
+SYS_API SysInt sys_hfrozen_first_child(SysHFrozen *frozen, SysUInt index);
+SYS_API SysInt sys_hfrozen_next_sibling(SysHFrozen *frozen, SysUInt index);
+SYS_API void sys_hfrozen_traverse(SysHFrozen *frozen,
+    SysTraverseType order,
+    SysTraverseFlags flags,
+    SysInt max_depth,
+    SysHNodeTraverseFunc func,
+    SysPointer user_data);
+
 SYS_END_DECLS
 
 #endif
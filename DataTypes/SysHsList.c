@@ -1,4 +1,5 @@
 #include <System/DataTypes/SysHsList.h>
+#include <System/DataTypes/SysListPrivate.h>
 
 /**
  * license under GNU Lesser General Public
@@ -394,34 +395,7 @@ static SysHSList * sys_hslist_sort_merge (SysHSList   *l1,
   return list.next;
 }
 
-static SysHSList * sys_hslist_sort_real (SysHSList   *list,
-                   SysFunc     compare_func,
-                   SysPointer  user_data) {
-  SysHSList *l1, *l2;
-
-  if (!list)
-    return NULL;
-  if (!list->next)
-    return list;
-
-  l1 = list;
-  l2 = list->next;
-
-  while ((l2 = l2->next) != NULL)
-    {
-      if ((l2 = l2->next) == NULL)
-        break;
-      l1=l1->next;
-    }
-  l2 = l1->next;
-  l1->next = NULL;
-
-  return sys_hslist_sort_merge (
-      sys_hslist_sort_real (list, compare_func, user_data),
-      sys_hslist_sort_real (l2, compare_func, user_data),
-      compare_func,
-      user_data);
-}
+SYS_LIST_DEFINE_SORT(sys_hslist_sort_real, SysHSList, sys_hslist_sort_merge)
 
 SysHSList * sys_hslist_sort (SysHSList       *list,
               SysCompareFunc  compare_func) {
@@ -434,6 +408,34 @@ SysHSList * sys_hslist_sort_with_data (SysHSList           *list,
   return sys_hslist_sort_real (list, (SysFunc) compare_func, user_data);
 }
 
+/**
+ * sys_hslist_insert_sorted_list:
+ * @list: a sorted list
+ * @batch: a list sorted with the same @func
+ *
+ * Merges @batch into @list in one pass, nodes of @list come first when
+ * they compare equal.
+ *
+ * Returns: the new start of the merged list
+ */
+SysHSList* sys_hslist_insert_sorted_list (SysHSList       *list,
+                       SysHSList       *batch,
+                       SysCompareFunc  func) {
+  sys_return_val_if_fail (func != NULL, list);
+
+  return sys_hslist_sort_merge (list, batch, (SysFunc) func, NULL);
+}
+
+SysHSList* sys_hslist_insert_sorted_list_with_data (SysHSList           *list,
+                                 SysHSList           *batch,
+                                 SysCompareDataFunc  func,
+                                 SysPointer          user_data) {
+  sys_return_val_if_fail (func != NULL, list);
+
+  return sys_hslist_sort_merge (list, batch, (SysFunc) func, user_data);
+}
+
+
 void (sys_clear_hslist) (SysHSList         **hslist_ptr,
                  SysDestroyFunc   destroy) {
   SysHSList *hslist;
@@ -50,6 +50,8 @@ SysHSList* sys_hslist_last(SysHSList *list);
 SysUInt sys_hslist_length(SysHSList *list);
 SysHSList* sys_hslist_sort(SysHSList *list, SysCompareFunc compare_func);
 SysHSList* sys_hslist_sort_with_data(SysHSList *list, SysCompareDataFunc compare_func, SysPointer user_data);
+SysHSList* sys_hslist_insert_sorted_list(SysHSList *list, SysHSList *batch, SysCompareFunc func);
+SysHSList* sys_hslist_insert_sorted_list_with_data(SysHSList *list, SysHSList *batch, SysCompareDataFunc func, SysPointer user_data);
 SysHSList* sys_hslist_nth_data (SysHSList   *list,
                   SysUInt n);
 
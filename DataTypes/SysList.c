@@ -1,4 +1,5 @@
 #include <System/DataTypes/SysList.h>
+#include <System/DataTypes/SysListPrivate.h>
 
 /**
  * this code from glib list
@@ -336,3 +337,80 @@ SysUInt sys_list_length(SysList *list) {
 
   return length;
 }
+
+/* merges on the next links only, prev links are fixed by the caller */
+static SysList* sys_list_sort_merge(SysList *l1, SysList *l2, SysFunc compare_func, SysPointer user_data) {
+  SysList list, *l;
+  SysInt cmp;
+
+  l = &list;
+
+  while (l1 && l2) {
+    cmp = ((SysCompareDataFunc) compare_func)(l1->data, l2->data, user_data);
+
+    if (cmp <= 0) {
+      l = l->next = l1;
+      l1 = l1->next;
+    } else {
+      l = l->next = l2;
+      l2 = l2->next;
+    }
+  }
+  l->next = l1 ? l1 : l2;
+
+  return list.next;
+}
+
+static SysList* sys_list_link_prev(SysList *list) {
+  SysList *prev = NULL, *l;
+
+  for (l = list; l; l = l->next) {
+    l->prev = prev;
+    prev = l;
+  }
+
+  return list;
+}
+
+SYS_LIST_DEFINE_SORT(sys_list_sort_bins, SysList, sys_list_sort_merge)
+
+static SysList* sys_list_sort_real(SysList *list, SysFunc compare_func, SysPointer user_data) {
+  return sys_list_link_prev(sys_list_sort_bins(list, compare_func, user_data));
+}
+
+SysList* sys_list_sort(SysList *list, SysCompareFunc compare_func) {
+  sys_return_val_if_fail(compare_func != NULL, list);
+
+  return sys_list_sort_real(list, (SysFunc) compare_func, NULL);
+}
+
+SysList* sys_list_sort_with_data(SysList *list, SysCompareDataFunc compare_func, SysPointer user_data) {
+  sys_return_val_if_fail(compare_func != NULL, list);
+
+  return sys_list_sort_real(list, (SysFunc) compare_func, user_data);
+}
+
+/**
+ * sys_list_insert_sorted_list:
+ * @list: a sorted list
+ * @batch: a list sorted with the same @func
+ *
+ * Merges @batch into @list in one pass, nodes of @list come first when
+ * they compare equal.
+ *
+ * Returns: the new start of the merged list
+ */
+SysList* sys_list_insert_sorted_list(SysList *list, SysList *batch, SysCompareFunc func) {
+  sys_return_val_if_fail(func != NULL, list);
+
+  return sys_list_link_prev(sys_list_sort_merge(list, batch, (SysFunc) func, NULL));
+}
+
+SysList* sys_list_insert_sorted_list_with_data(SysList *list,
+    SysList *batch,
+    SysCompareDataFunc func,
+    SysPointer user_data) {
+  sys_return_val_if_fail(func != NULL, list);
+
+  return sys_list_link_prev(sys_list_sort_merge(list, batch, (SysFunc) func, user_data));
+}
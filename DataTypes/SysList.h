@@ -39,6 +39,13 @@ SYS_API SysInt     sys_list_index(SysList *list, const SysPointer  data);
 SYS_API SysList*   sys_list_last(SysList *list);
 SYS_API SysList* sys_list_first(SysList *list);
 SYS_API SysUInt    sys_list_length(SysList            *list);
+SYS_API SysList*   sys_list_sort(SysList *list, SysCompareFunc compare_func);
+SYS_API SysList*   sys_list_sort_with_data(SysList *list, SysCompareDataFunc compare_func, SysPointer user_data);
+SYS_API SysList*   sys_list_insert_sorted_list(SysList *list, SysList *batch, SysCompareFunc func);
+SYS_API SysList*   sys_list_insert_sorted_list_with_data(SysList *list,
+    SysList *batch,
+    SysCompareDataFunc func,
+    SysPointer user_data);
 
 SYS_END_DECLS
 
@@ -0,0 +1,51 @@
+#ifndef __SYS_LIST_PRIVATE_H__
+#define __SYS_LIST_PRIVATE_H__
+
+#include <System/Fundamental/SysCommonCore.h>
+
+/* bottom-up merge sort shared by SysList, SysSList and SysHSList.
+ *
+ * bins[i] holds a sorted run of 2^i nodes, older runs in higher bins,
+ * so merging a bin in front of newer nodes stays stable. Each node
+ * taken from the input carries upwards through the occupied bins like
+ * a binary counter, the last bin takes whatever does not fit. No
+ * recursion and no length pass, the list is read once.
+ *
+ * @merge joins two %NULL terminated runs on their next links and takes
+ * from its first argument on ties. The generated function only sets
+ * next links, a doubly linked list fixes its prev links afterwards. */
+#define SYS_LIST_SORT_BINS 64
+
+#define SYS_LIST_DEFINE_SORT(name, Type, merge)                         \
+static Type * name (Type *list, SysFunc compare_func, SysPointer user_data) { \
+  Type *bins[SYS_LIST_SORT_BINS];                                       \
+  Type *run;                                                            \
+  SysInt i, n_bins = 0;                                                 \
+                                                                        \
+  while (list) {                                                        \
+    run = list;                                                         \
+    list = list->next;                                                  \
+    run->next = NULL;                                                   \
+                                                                        \
+    for (i = 0; i < n_bins && bins[i]; i++) {                           \
+      run = merge (bins[i], run, compare_func, user_data);              \
+      bins[i] = NULL;                                                   \
+    }                                                                   \
+                                                                        \
+    if (i == SYS_LIST_SORT_BINS)                                        \
+      i--;                                                              \
+    if (i == n_bins)                                                    \
+      n_bins++;                                                         \
+    bins[i] = run;                                                      \
+  }                                                                     \
+                                                                        \
+  run = NULL;                                                           \
+  for (i = 0; i < n_bins; i++) {                                        \
+    if (bins[i])                                                        \
+      run = run ? merge (bins[i], run, compare_func, user_data) : bins[i]; \
+  }                                                                     \
+                                                                        \
+  return run;                                                           \
+}
+
+#endif
@@ -729,3 +729,258 @@ void sys_node_children_foreach (SysNode    *node,
     }
   }
 }
+
+/* iterators */
+static SysBool sys_node_iter_descends (SysNodeIter *iter,
+    SysNode *node,
+    SysInt depth) {
+  return node->children != NULL && (iter->max_depth < 0 || depth + 1 < iter->max_depth);
+}
+
+static SysNode* sys_node_iter_leftmost (SysNodeIter *iter, SysNode *node) {
+  while (sys_node_iter_descends (iter, node, iter->depth)) {
+    node = node->children;
+    iter->depth++;
+  }
+
+  return node;
+}
+
+static SysNode* sys_node_iter_pre_next (SysNodeIter *iter, SysNode *node) {
+  if (sys_node_iter_descends (iter, node, iter->depth)) {
+    iter->depth++;
+    return node->children;
+  }
+
+  while (node != iter->root && node->next == NULL) {
+    node = node->parent;
+    iter->depth--;
+  }
+
+  return node == iter->root ? NULL : node->next;
+}
+
+static SysNode* sys_node_iter_post_next (SysNodeIter *iter, SysNode *node) {
+  if (node == iter->root)
+    return NULL;
+
+  if (node->next)
+    return sys_node_iter_leftmost (iter, node->next);
+
+  iter->depth--;
+  return node->parent;
+}
+
+static SysNode* sys_node_iter_in_next (SysNodeIter *iter, SysNode *node) {
+  SysNode *parent;
+
+  if (sys_node_iter_descends (iter, node, iter->depth) && node->children->next) {
+    iter->depth++;
+    return sys_node_iter_leftmost (iter, node->children->next);
+  }
+
+  /* the subtree of node is done, climb to the next unvisited node */
+  while (node != iter->root) {
+    parent = node->parent;
+
+    if (node == parent->children) {
+      iter->depth--;
+      return parent;
+    }
+
+    if (node->next)
+      return sys_node_iter_leftmost (iter, node->next);
+
+    node = parent;
+    iter->depth--;
+  }
+
+  return NULL;
+}
+
+/* level order without a queue: a pruned preorder walk per level */
+static SysNode* sys_node_iter_level_next (SysNodeIter *iter, SysNode *node) {
+  SysInt level = iter->level;
+  SysInt depth = level;
+  SysBool restarted = false;
+
+  while (true) {
+    if (depth < level && sys_node_iter_descends (iter, node, depth)) {
+      node = node->children;
+      depth++;
+
+    } else {
+      while (node != iter->root && node->next == NULL) {
+        node = node->parent;
+        depth--;
+      }
+
+      if (node == iter->root) {
+        level++;
+        if (restarted || (iter->max_depth > 0 && level >= iter->max_depth))
+          return NULL;
+
+        restarted = true;
+        depth = 0;
+        continue;
+      }
+
+      node = node->next;
+    }
+
+    if (depth == level)
+      break;
+  }
+
+  iter->level = level;
+  iter->depth = depth;
+
+  return node;
+}
+
+static SysNode* sys_node_iter_queue_next (SysNodeIter *iter) {
+  SysNode *node, *child;
+  SysUInt tail;
+
+  if (iter->len == 0)
+    return NULL;
+
+  if (iter->level_left == 0) {
+    iter->level++;
+    iter->level_left = iter->len;
+  }
+
+  node = iter->queue[iter->head];
+  iter->head = (iter->head + 1) % iter->queue_size;
+  iter->len--;
+  iter->level_left--;
+
+  if (!sys_node_iter_descends (iter, node, iter->level))
+    return node;
+
+  for (child = node->children; child; child = child->next) {
+    if (iter->len == iter->queue_size) {
+      /* scratch is too small for this level, continue without it */
+      iter->queue = NULL;
+      iter->node = sys_node_iter_level_next (iter, node);
+      return node;
+    }
+
+    tail = (iter->head + iter->len) % iter->queue_size;
+    iter->queue[tail] = child;
+    iter->len++;
+  }
+
+  return node;
+}
+
+/**
+ * sys_node_iter_init:
+ * @iter: an uninitialized #SysNodeIter
+ * @root: the root of the tree to walk
+ * @order: the order in which nodes are returned
+ * @flags: which types of children are to be returned
+ * @max_depth: maximum depth of the traversal, -1 for all
+ * @scratch: (nullable): buffer used as queue for %SYS_LEVEL_ORDER
+ * @scratch_len: number of nodes @scratch can hold
+ *
+ * Depth first orders follow the parent links and need no memory at all.
+ * Level order uses @scratch as a ring queue, it should hold the widest
+ * level plus one. Without it, or once it is full, level order falls back
+ * to one pruned walk per level, which is slower but never allocates.
+ */
+void sys_node_iter_init (SysNodeIter *iter,
+    SysNode    *root,
+    SysTraverseType    order,
+    SysTraverseFlags    flags,
+    SysInt     max_depth,
+    SysNode    **scratch,
+    SysUInt     scratch_len) {
+  sys_return_if_fail (iter != NULL);
+  sys_return_if_fail (root != NULL);
+  sys_return_if_fail (order <= SYS_LEVEL_ORDER);
+  sys_return_if_fail (flags <= SYS_TRAVERSE_MASK);
+  sys_return_if_fail (max_depth == -1 || max_depth > 0);
+
+  iter->root = root;
+  iter->node = NULL;
+  iter->order = order;
+  iter->flags = flags;
+  iter->max_depth = max_depth;
+  iter->depth = 0;
+  iter->level = 0;
+  iter->queue = NULL;
+  iter->queue_size = 0;
+  iter->head = 0;
+  iter->len = 0;
+  iter->level_left = 0;
+
+  switch (order) {
+    case SYS_PRE_ORDER:
+      iter->node = root;
+      break;
+    case SYS_POST_ORDER:
+    case SYS_IN_ORDER:
+      iter->node = sys_node_iter_leftmost (iter, root);
+      break;
+    case SYS_LEVEL_ORDER:
+      if (scratch != NULL && scratch_len > 0) {
+        iter->queue = scratch;
+        iter->queue_size = scratch_len;
+        iter->queue[0] = root;
+        iter->len = 1;
+        iter->level_left = 1;
+      } else {
+        iter->node = root;
+      }
+      break;
+  }
+}
+
+static SysNode* sys_node_iter_step (SysNodeIter *iter) {
+  SysNode *node;
+
+  if (iter->queue != NULL)
+    return sys_node_iter_queue_next (iter);
+
+  node = iter->node;
+  if (node == NULL)
+    return NULL;
+
+  switch (iter->order) {
+    case SYS_PRE_ORDER:
+      iter->node = sys_node_iter_pre_next (iter, node);
+      break;
+    case SYS_POST_ORDER:
+      iter->node = sys_node_iter_post_next (iter, node);
+      break;
+    case SYS_IN_ORDER:
+      iter->node = sys_node_iter_in_next (iter, node);
+      break;
+    case SYS_LEVEL_ORDER:
+      iter->node = sys_node_iter_level_next (iter, node);
+      break;
+  }
+
+  return node;
+}
+
+/**
+ * sys_node_iter_next:
+ * @iter: a #SysNodeIter
+ *
+ * Returns: the next node in the order given to sys_node_iter_init(),
+ *   or %NULL when the walk is done
+ */
+SysNode* sys_node_iter_next (SysNodeIter *iter) {
+  SysNode *node;
+
+  sys_return_val_if_fail (iter != NULL, NULL);
+
+  while ((node = sys_node_iter_step (iter)) != NULL) {
+    if (node->children ? (iter->flags & SYS_TRAVERSE_NON_LEAFS) : (iter->flags & SYS_TRAVERSE_LEAFS))
+      return node;
+  }
+
+  return NULL;
+}
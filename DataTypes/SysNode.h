@@ -6,6 +6,7 @@
 SYS_BEGIN_DECLS
 
 typedef struct _SysNode  SysNode;
+typedef struct _SysNodeIter  SysNodeIter;
 
 typedef SysBool (*SysNodeTraverseFunc) (SysNode        *node,
        SysPointer data);
@@ -21,6 +22,30 @@ struct _SysNode
   SysNode   *children;
 };
 
+/**
+ * SysNodeIter: external cursor over a SysNode tree.
+ *
+ * Walks the tree without recursion and without allocating, so loops can
+ * stop at any point without a callback. The tree must not be changed
+ * while a cursor is in use.
+ */
+struct _SysNodeIter
+{
+  /* <private> */
+  SysNode *root;
+  SysNode *node;
+  SysTraverseType order;
+  SysTraverseFlags flags;
+  SysInt max_depth;
+  SysInt depth;
+  SysInt level;
+  SysNode **queue;
+  SysUInt queue_size;
+  SysUInt head;
+  SysUInt len;
+  SysUInt level_left;
+};
+
 #define  SYS_NODE_IS_ROOT(node) (((SysNode*) (node))->parent == NULL && \
      ((SysNode*) (node))->prev == NULL && \
      ((SysNode*) (node))->next == NULL)
@@ -83,6 +108,15 @@ SYS_API void  sys_node_traverse (SysNode    *root,
 
 SYS_API SysUInt  sys_node_max_height  (SysNode *root);
 
+SYS_API void  sys_node_iter_init (SysNodeIter *iter,
+     SysNode    *root,
+     SysTraverseType    order,
+     SysTraverseFlags    flags,
+     SysInt     max_depth,
+     SysNode    **scratch,
+     SysUInt     scratch_len);
+SYS_API SysNode*  sys_node_iter_next (SysNodeIter *iter);
+
 SYS_API void  sys_node_children_foreach (SysNode    *node,
       SysTraverseFlags   flags,
       SysNodeForeachFunc func,
@@ -1,140 +1,195 @@
 #include <System/DataTypes/SysPQueue.h>
 
-/* pqueue api */
-static SysPNode *prio_p_node_new(SysInt prio, SysPointer data) {
-  SysPNode *plink = sys_new0(SysPNode, 1);
+#define MIN_PQUEUE_SIZE 16
+#define PQUEUE_ARITY 4
 
-  plink->parent.data = data;
-  plink->prio = prio;
+#define pqueue_parent(n) (((n) - 1) / PQUEUE_ARITY)
+#define pqueue_child(n) ((n) * PQUEUE_ARITY + 1)
 
-  return plink;
-}
+/* pqueue api */
+static SysBool pnode_less(SysPNode *a, SysPNode *b) {
+  if (a->prio != b->prio) {
+    return a->prio < b->prio;
+  }
 
-static void prio_list_free(SysPNode *plink) {
-  sys_free(plink);
+  return a->seq < b->seq;
 }
 
-SysPQueue *sys_pqueue_new(void) {
-  return sys_queue_new();
+static void pqueue_set(SysPQueue *queue, SysUInt n, SysPNode *plink) {
+  queue->nodes[n] = plink;
+  plink->index = (SysInt)n;
 }
 
-void sys_pqueue_destroy(SysPQueue *queue, SysDestroyFunc free_func) {
-  sys_pqueue_foreach(queue, node) {
-    free_func(node->data);
+static void pqueue_maybe_expand(SysPQueue *queue) {
+  if (queue->length < queue->alloc) {
+    return;
   }
-  sys_pqueue_init(queue);
+
+  queue->alloc = max(queue->alloc * 2, MIN_PQUEUE_SIZE);
+  queue->nodes = sys_renew(SysPNode *, queue->nodes, queue->alloc);
 }
 
-void sys_pqueue_init(SysPQueue *queue) {
-  sys_queue_init(queue);
+static void pqueue_bubbleup(SysPQueue *queue, SysUInt n) {
+  SysPNode *plink = queue->nodes[n];
+  SysUInt parent;
+
+  while (n > 0) {
+    parent = pqueue_parent(n);
+    if (!pnode_less(plink, queue->nodes[parent])) {
+      break;
+    }
+
+    pqueue_set(queue, n, queue->nodes[parent]);
+    n = parent;
+  }
+
+  pqueue_set(queue, n, plink);
 }
 
-static SysBool _pqueue_push_tail(SysList *tail, SysPNode *plink) {
-  SysList *nlist = SYS_LIST(plink);
+static void pqueue_sinkdown(SysPQueue *queue, SysUInt n) {
+  SysPNode *plink = queue->nodes[n];
+  SysUInt child, last, best;
 
-  for (SysList *list = tail; list; list = list->prev) {
-    SysPNode *plist = SYS_P_NODE(list);
+  while (true) {
+    child = pqueue_child(n);
+    if (child >= queue->length) {
+      break;
+    }
 
-    if (plink->prio > plist->prio) {
-      if (list->next) {
-        nlist->next = list->next;
-        nlist->next->prev = nlist;
+    last = min(child + PQUEUE_ARITY, queue->length);
+    best = child;
+    for (child = child + 1; child < last; child++) {
+      if (pnode_less(queue->nodes[child], queue->nodes[best])) {
+        best = child;
       }
+    }
 
-      list->next = nlist;
-      nlist->prev = list;
-
-      return true;
+    if (!pnode_less(queue->nodes[best], plink)) {
+      break;
     }
+
+    pqueue_set(queue, n, queue->nodes[best]);
+    n = best;
   }
 
-  return false;
+  pqueue_set(queue, n, plink);
 }
 
-static SysBool _pqueue_push_head(SysList *head, SysPNode *plink) {
-  SysList *nlist = SYS_LIST(plink);
-
-  for (SysList *list = head; list; list = list->next) {
-    SysPNode *plist = SYS_P_NODE(list);
+static void pqueue_fix(SysPQueue *queue, SysUInt n) {
+  if (n > 0 && pnode_less(queue->nodes[n], queue->nodes[pqueue_parent(n)])) {
+    pqueue_bubbleup(queue, n);
+  } else {
+    pqueue_sinkdown(queue, n);
+  }
+}
 
-    if (plink->prio <= plist->prio) {
-      if (list->prev) {
-        nlist->prev = list->prev;
-        nlist->prev->next = nlist;
-      }
+static void pqueue_insert(SysPQueue *queue, SysPNode *plink) {
+  pqueue_maybe_expand(queue);
 
-      list->prev = nlist;
-      nlist->next = list;
+  queue->nodes[queue->length] = plink;
+  queue->length++;
+  pqueue_bubbleup(queue, queue->length - 1);
+}
 
-      return true;
+static void pqueue_free_nodes(SysPQueue *queue, SysDestroyFunc free_func) {
+  for (SysUInt i = 0; i < queue->length; i++) {
+    if (free_func) {
+      free_func(queue->nodes[i]->data);
     }
+
+    sys_pnode_free(queue->nodes[i]);
   }
 
-  return false;
+  if (queue->nodes) {
+    sys_free(queue->nodes);
+  }
 }
 
-void sys_pqueue_push_head_link(SysPQueue *queue, SysPNode *plink) {
+SysPNode *sys_pnode_new(SysInt prio, SysPointer data) {
+  SysPNode *plink = sys_new0(SysPNode, 1);
+
+  plink->data = data;
+  plink->prio = prio;
+  plink->index = -1;
+
+  return plink;
+}
+
+void sys_pnode_free(SysPNode *plink) {
+  sys_free(plink);
+}
+
+SysBool sys_pnode_is_linked(SysPNode *plink) {
+  sys_return_val_if_fail(plink != NULL, false);
+
+  return plink->index >= 0;
+}
+
+SysPQueue *sys_pqueue_new(void) {
+  SysPQueue *queue = sys_slice_new(SysPQueue);
+
+  sys_pqueue_init(queue);
+
+  return queue;
+}
+
+void sys_pqueue_destroy(SysPQueue *queue, SysDestroyFunc free_func) {
   sys_return_if_fail(queue != NULL);
-  sys_return_if_fail(plink != NULL);
-  sys_return_if_fail(plink->prio > 0);
 
-  SysList *nlist = SYS_LIST(plink);
+  pqueue_free_nodes(queue, free_func);
+  sys_pqueue_init(queue);
+}
 
-  sys_return_if_fail(nlist->prev == NULL);
-  sys_return_if_fail(nlist->next == NULL);
+void sys_pqueue_init(SysPQueue *queue) {
+  sys_return_if_fail(queue != NULL);
 
-  if (!_pqueue_push_head(queue->head, plink)) {
-    if (queue->head) {
-      nlist->next = queue->head;
-      nlist->next->prev = nlist;
-    }
+  queue->nodes = NULL;
+  queue->length = 0;
+  queue->alloc = 0;
+  queue->head_seq = 0;
+  queue->tail_seq = 0;
+}
 
-    queue->head = nlist;
-  }
+SysUInt sys_pqueue_get_length(SysPQueue *queue) {
+  sys_return_val_if_fail(queue != NULL, 0);
 
-  if (!queue->tail) {
-    queue->tail = queue->head;
-  }
+  return queue->length;
 }
 
-void sys_pqueue_push_tail_link(SysPQueue *queue, SysPNode *plink) {
+SysBool sys_pqueue_is_empty(SysPQueue *queue) {
+  sys_return_val_if_fail(queue != NULL, true);
+
+  return queue->length == 0;
+}
+
+void sys_pqueue_push_head_link(SysPQueue *queue, SysPNode *plink) {
   sys_return_if_fail(queue != NULL);
   sys_return_if_fail(plink != NULL);
   sys_return_if_fail(plink->prio > 0);
+  sys_return_if_fail(plink->index < 0);
 
-  SysList *nlist = SYS_LIST(plink);
-
-  sys_return_if_fail(nlist->prev == NULL);
-  sys_return_if_fail(nlist->next == NULL);
-
-  if (!_pqueue_push_tail(queue->tail, plink)) {
-    if (queue->tail) {
-      nlist->prev = queue->tail;
-      nlist->prev->next = nlist;
-    }
+  plink->seq = --queue->head_seq;
+  pqueue_insert(queue, plink);
+}
 
-    queue->tail = nlist;
-  }
+void sys_pqueue_push_tail_link(SysPQueue *queue, SysPNode *plink) {
+  sys_return_if_fail(queue != NULL);
+  sys_return_if_fail(plink != NULL);
+  sys_return_if_fail(plink->prio > 0);
+  sys_return_if_fail(plink->index < 0);
 
-  if (!queue->head) {
-    queue->head = queue->tail;
-  }
+  plink->seq = ++queue->tail_seq;
+  pqueue_insert(queue, plink);
 }
 
 SysPNode *sys_pqueue_push_tail(SysPQueue *queue, SysInt prio, SysPointer data) {
   sys_return_val_if_fail(queue != NULL, NULL);
   sys_return_val_if_fail(prio > 0, NULL);
 
-  SysPNode *plink = prio_p_node_new(prio, data);
+  SysPNode *plink = sys_pnode_new(prio, data);
 
   sys_pqueue_push_tail_link(queue, plink);
 
-  if (queue->tail->next)
-    queue->tail = queue->tail->next;
-  else
-    queue->head = queue->tail;
-  queue->length++;
-
   return plink;
 }
 
@@ -142,14 +197,10 @@ SysPNode *sys_pqueue_push_head(SysPQueue *queue, SysInt prio, SysPointer data) {
   sys_return_val_if_fail(queue != NULL, NULL);
   sys_return_val_if_fail(prio > 0, NULL);
 
-  SysPNode *plink = prio_p_node_new(prio, data);
+  SysPNode *plink = sys_pnode_new(prio, data);
 
   sys_pqueue_push_head_link(queue, plink);
 
-  if (!queue->tail)
-    queue->tail = queue->head;
-  queue->length++;
-
   return plink;
 }
 
@@ -157,35 +208,87 @@ void sys_pqueue_unlink(SysPQueue *queue, SysPNode *plink) {
   sys_return_if_fail(queue != NULL);
   sys_return_if_fail(plink != NULL);
   sys_return_if_fail(plink->prio > 0);
+  sys_return_if_fail(plink->index >= 0 && (SysUInt)plink->index < queue->length);
+  sys_return_if_fail(queue->nodes[plink->index] == plink);
 
-  SysList *nlist = SYS_LIST(plink);
+  SysUInt n = (SysUInt)plink->index;
+  SysPNode *end = queue->nodes[--queue->length];
 
-  if (nlist == queue->tail) {
-    queue->tail = queue->tail->prev;
+  plink->index = -1;
+
+  if (end != plink) {
+    pqueue_set(queue, n, end);
+    pqueue_fix(queue, n);
   }
+}
 
-  SysList *nlink = sys_list_remove_link(queue->head, nlist);
+void sys_pqueue_update(SysPQueue *queue, SysPNode *plink, SysInt prio) {
+  sys_return_if_fail(queue != NULL);
+  sys_return_if_fail(plink != NULL);
+  sys_return_if_fail(prio > 0);
+  sys_return_if_fail(plink->index >= 0 && (SysUInt)plink->index < queue->length);
+  sys_return_if_fail(queue->nodes[plink->index] == plink);
 
-  queue->head = nlink;
-  queue->length--;
+  /* re-prioritized node goes behind existing equal nodes */
+  plink->prio = prio;
+  plink->seq = ++queue->tail_seq;
+  pqueue_fix(queue, (SysUInt)plink->index);
 }
 
-void sys_pqueue_free(SysPQueue *queue) {
-  sys_return_if_fail(queue != NULL);
+SysPNode *sys_pqueue_peek_head_link(SysPQueue *queue) {
+  sys_return_val_if_fail(queue != NULL, NULL);
+
+  return queue->length > 0 ? queue->nodes[0] : NULL;
+}
+
+SysPointer sys_pqueue_peek_head(SysPQueue *queue) {
+  sys_return_val_if_fail(queue != NULL, NULL);
+
+  return queue->length > 0 ? queue->nodes[0]->data : NULL;
+}
+
+SysPNode *sys_pqueue_pop_head_link(SysPQueue *queue) {
+  SysPNode *plink;
 
-  if (queue->head) {
-    prio_list_free(SYS_P_NODE(queue->head));
-    queue->head = NULL;
+  sys_return_val_if_fail(queue != NULL, NULL);
+
+  if (queue->length == 0) {
+    return NULL;
   }
-  sys_slice_free(SysPQueue, queue);
+
+  plink = queue->nodes[0];
+  sys_pqueue_unlink(queue, plink);
+
+  return plink;
 }
 
-void sys_pqueue_free_full(SysPQueue *queue, SysDestroyFunc free_func) {
-  for (SysList *node = queue->head; node; node = node->next) {
-    free_func(node->data);
+SysPointer sys_pqueue_pop_head(SysPQueue *queue) {
+  SysPNode *plink;
+  SysPointer data;
+
+  sys_return_val_if_fail(queue != NULL, NULL);
+
+  plink = sys_pqueue_pop_head_link(queue);
+  if (plink == NULL) {
+    return NULL;
   }
 
-  sys_pqueue_free(queue);
+  data = plink->data;
+  sys_pnode_free(plink);
+
+  return data;
+}
+
+void sys_pqueue_free(SysPQueue *queue) {
+  sys_return_if_fail(queue != NULL);
+
+  pqueue_free_nodes(queue, NULL);
+  sys_slice_free(SysPQueue, queue);
 }
 
+void sys_pqueue_free_full(SysPQueue *queue, SysDestroyFunc free_func) {
+  sys_return_if_fail(queue != NULL);
 
+  pqueue_free_nodes(queue, free_func);
+  sys_slice_free(SysPQueue, queue);
+}
@@ -1,36 +1,71 @@
 #ifndef __SYS_PQUEUE_H__
 #define __SYS_PQUEUE_H__
 
-#include <System/DataTypes/SysQueue.h>
-#include <System/DataTypes/SysList.h>
+#include <System/Fundamental/SysCommonCore.h>
 
 #define SYS_P_NODE(o) ((SysPNode *)o)
 
 SYS_BEGIN_DECLS
 
-typedef struct _SysQueue SysPQueue;
+/**
+ * SysPQueue: indexed 4-ary min heap, smallest prio at head.
+ * every SysPNode keeps its heap position, so unlink and
+ * prio update are O(log n) through the node handle.
+ * equal prio keeps push order: push_tail goes behind,
+ * push_head goes before the existing equal nodes.
+ */
+
+typedef struct _SysPQueue SysPQueue;
 typedef struct _SysPNode SysPNode;
 
 struct _SysPNode {
-  SysList parent;
+  SysPointer data;
   SysInt prio;
+
+  /* <private> */
+  SysInt index;
+  SysInt64 seq;
+};
+
+struct _SysPQueue {
+  SysPNode **nodes;
+  SysUInt length;
+
+  /* <private> */
+  SysUInt alloc;
+  SysInt64 head_seq;
+  SysInt64 tail_seq;
 };
 
-#define sys_pqueue_foreach(queue, node) sys_queue_foreach(queue, node)
-#define sys_pqueue_peek_head(queue) sys_queue_peek_head(queue)
-#define sys_pnode_next(o) ((SysPNode *)(SYS_P_NODE(o)->parent.next))
-#define sys_pnode_prev(o) ((SysPNode *)(SYS_P_NODE(o)->parent.prev))
-
-SysPQueue *sys_pqueue_new(void);
-void sys_pqueue_init(SysPQueue *queue);
-void sys_pqueue_destroy(SysPQueue *queue, SysDestroyFunc free_func);
-SysPNode *sys_pqueue_push_tail(SysPQueue *queue, SysInt prio, SysPointer data);
-SysPNode* sys_pqueue_push_head(SysPQueue* queue, SysInt prio, SysPointer data);
-
-void sys_pqueue_unlink(SysPQueue *queue, SysPNode *plink);
-void sys_pqueue_push_tail_link(SysPQueue *queue, SysPNode *plink);
-void sys_pqueue_push_head_link(SysPQueue *queue, SysPNode *plink);
-void sys_pqueue_free_full(SysPQueue *queue, SysDestroyFunc free_func);
+/* heap order, not sorted */
+#define sys_pqueue_foreach(queue, node) \
+  for(SysPNode **_pnode = (queue)->nodes, *node = (queue)->length > 0 ? *_pnode : NULL; \
+      node; \
+      node = (++_pnode < (queue)->nodes + (queue)->length) ? *_pnode : NULL)
+
+SYS_API SysPNode *sys_pnode_new(SysInt prio, SysPointer data);
+SYS_API void sys_pnode_free(SysPNode *plink);
+SYS_API SysBool sys_pnode_is_linked(SysPNode *plink);
+
+SYS_API SysPQueue *sys_pqueue_new(void);
+SYS_API void sys_pqueue_init(SysPQueue *queue);
+SYS_API void sys_pqueue_destroy(SysPQueue *queue, SysDestroyFunc free_func);
+SYS_API void sys_pqueue_free(SysPQueue *queue);
+SYS_API void sys_pqueue_free_full(SysPQueue *queue, SysDestroyFunc free_func);
+SYS_API SysUInt sys_pqueue_get_length(SysPQueue *queue);
+SYS_API SysBool sys_pqueue_is_empty(SysPQueue *queue);
+
+SYS_API SysPNode *sys_pqueue_push_tail(SysPQueue *queue, SysInt prio, SysPointer data);
+SYS_API SysPNode* sys_pqueue_push_head(SysPQueue* queue, SysInt prio, SysPointer data);
+SYS_API void sys_pqueue_push_tail_link(SysPQueue *queue, SysPNode *plink);
+SYS_API void sys_pqueue_push_head_link(SysPQueue *queue, SysPNode *plink);
+SYS_API void sys_pqueue_unlink(SysPQueue *queue, SysPNode *plink);
+SYS_API void sys_pqueue_update(SysPQueue *queue, SysPNode *plink, SysInt prio);
+
+SYS_API SysPointer sys_pqueue_peek_head(SysPQueue *queue);
+SYS_API SysPNode *sys_pqueue_peek_head_link(SysPQueue *queue);
+SYS_API SysPointer sys_pqueue_pop_head(SysPQueue *queue);
+SYS_API SysPNode *sys_pqueue_pop_head_link(SysPQueue *queue);
 
 SYS_END_DECLS
 
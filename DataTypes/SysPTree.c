@@ -0,0 +1,505 @@
+#include <System/DataTypes/SysPTree.h>
+#include <System/Platform/Common/SysRcu.h>
+
+typedef struct _SysPTreeRetired SysPTreeRetired;
+
+struct _SysPTreeNode {
+  SysPointer key;
+  SysPointer value;
+  SysPTreeNode *left;
+  SysPTreeNode *right;
+  /* write generation that created the node, only those may be modified */
+  SysUInt64 gen;
+  SysUInt size;
+  SysInt height;
+};
+
+struct _SysPTreeRetired {
+  SysPTreeRetired *next;
+  SysDestroyFunc func;
+  SysPointer data;
+};
+
+struct _SysPTree {
+  SysPTreeNode *root;
+  SysMutex lock;
+  SysCompareDataFunc key_compare;
+  SysPointer key_compare_data;
+  SysDestroyFunc key_destroy_func;
+  SysDestroyFunc value_destroy_func;
+  SysUInt64 gen;
+  /* retired by the write in progress, queued once it is published */
+  SysPTreeRetired *pending;
+};
+
+void sys_ptree_read_lock(void) {
+  sys_rcu_read_lock();
+}
+
+void sys_ptree_read_unlock(void) {
+  sys_rcu_read_unlock();
+}
+
+/* node */
+static void ptree_node_free(SysPointer data) {
+  sys_slice_free(SysPTreeNode, data);
+}
+
+static void ptree_retire(SysPTree *tree, SysDestroyFunc func, SysPointer data) {
+  SysPTreeRetired *item = sys_slice_new(SysPTreeRetired);
+
+  item->func = func;
+  item->data = data;
+  item->next = tree->pending;
+  tree->pending = item;
+}
+
+/* the replaced nodes are freed after a grace period, see SysRcu */
+static void ptree_publish(SysPTree *tree, SysPTreeNode *root) {
+  SysPTreeRetired *item, *next;
+
+  sys_rcu_assign_pointer(tree->root, root);
+
+  for (item = tree->pending; item; item = next) {
+    next = item->next;
+
+    sys_rcu_call(item->func, item->data);
+    sys_slice_free(SysPTreeRetired, item);
+  }
+  tree->pending = NULL;
+}
+
+static SysPTreeNode *ptree_node_new(SysPTree *tree, SysPointer key, SysPointer value) {
+  SysPTreeNode *node = sys_slice_new(SysPTreeNode);
+
+  node->key = key;
+  node->value = value;
+  node->left = NULL;
+  node->right = NULL;
+  node->gen = tree->gen;
+  node->size = 1;
+  node->height = 1;
+
+  return node;
+}
+
+static void ptree_node_drop(SysPTree *tree, SysPTreeNode *node) {
+  if (node->gen == tree->gen) {
+    ptree_node_free(node);
+  } else {
+    ptree_retire(tree, ptree_node_free, node);
+  }
+}
+
+/* a node of an older version is copied before it is modified */
+static SysPTreeNode *ptree_node_mut(SysPTree *tree, SysPTreeNode *node) {
+  SysPTreeNode *copy;
+
+  if (node->gen == tree->gen) {
+    return node;
+  }
+
+  copy = sys_slice_new(SysPTreeNode);
+  *copy = *node;
+  copy->gen = tree->gen;
+  ptree_retire(tree, ptree_node_free, node);
+
+  return copy;
+}
+
+static SysInt ptree_height(SysPTreeNode *node) {
+  return node ? node->height : 0;
+}
+
+static SysUInt ptree_size(SysPTreeNode *node) {
+  return node ? node->size : 0;
+}
+
+static void ptree_update(SysPTreeNode *node) {
+  node->height = max(ptree_height(node->left), ptree_height(node->right)) + 1;
+  node->size = ptree_size(node->left) + ptree_size(node->right) + 1;
+}
+
+static SysPTreeNode *ptree_rotate_right(SysPTree *tree, SysPTreeNode *node) {
+  SysPTreeNode *left = ptree_node_mut(tree, node->left);
+
+  node->left = left->right;
+  left->right = node;
+  ptree_update(node);
+  ptree_update(left);
+
+  return left;
+}
+
+static SysPTreeNode *ptree_rotate_left(SysPTree *tree, SysPTreeNode *node) {
+  SysPTreeNode *right = ptree_node_mut(tree, node->right);
+
+  node->right = right->left;
+  right->left = node;
+  ptree_update(node);
+  ptree_update(right);
+
+  return right;
+}
+
+/* @node must already belong to the current write */
+static SysPTreeNode *ptree_balance(SysPTree *tree, SysPTreeNode *node) {
+  SysInt bf;
+
+  ptree_update(node);
+  bf = ptree_height(node->right) - ptree_height(node->left);
+
+  if (bf < -1) {
+    if (ptree_height(node->left->left) < ptree_height(node->left->right)) {
+      node->left = ptree_rotate_left(tree, ptree_node_mut(tree, node->left));
+    }
+
+    return ptree_rotate_right(tree, node);
+  }
+
+  if (bf > 1) {
+    if (ptree_height(node->right->right) < ptree_height(node->right->left)) {
+      node->right = ptree_rotate_right(tree, ptree_node_mut(tree, node->right));
+    }
+
+    return ptree_rotate_left(tree, node);
+  }
+
+  return node;
+}
+
+static SysPTreeNode *ptree_insert(SysPTree *tree, SysPTreeNode *node, SysPointer key, SysPointer value) {
+  SysPTreeNode *child;
+  SysInt cmp;
+
+  if (node == NULL) {
+    return ptree_node_new(tree, key, value);
+  }
+
+  cmp = tree->key_compare(key, node->key, tree->key_compare_data);
+  if (cmp == 0) {
+    node = ptree_node_mut(tree, node);
+
+    if (tree->value_destroy_func) {
+      ptree_retire(tree, tree->value_destroy_func, node->value);
+    }
+    node->value = value;
+
+    /* the passed key was never published */
+    if (tree->key_destroy_func) {
+      tree->key_destroy_func(key);
+    }
+
+    return node;
+  }
+
+  if (cmp < 0) {
+    child = ptree_insert(tree, node->left, key, value);
+    node = ptree_node_mut(tree, node);
+    node->left = child;
+  } else {
+    child = ptree_insert(tree, node->right, key, value);
+    node = ptree_node_mut(tree, node);
+    node->right = child;
+  }
+
+  return ptree_balance(tree, node);
+}
+
+static SysPTreeNode *ptree_remove_min(SysPTree *tree, SysPTreeNode *node, SysPTreeNode **min) {
+  SysPTreeNode *child;
+
+  if (node->left == NULL) {
+    *min = node;
+    return node->right;
+  }
+
+  child = ptree_remove_min(tree, node->left, min);
+  node = ptree_node_mut(tree, node);
+  node->left = child;
+
+  return ptree_balance(tree, node);
+}
+
+static SysPTreeNode *ptree_remove(SysPTree *tree, SysPTreeNode *node, const SysPointer key, SysBool *removed) {
+  SysPTreeNode *child, *min, *right;
+  SysInt cmp;
+
+  if (node == NULL) {
+    return NULL;
+  }
+
+  cmp = tree->key_compare(key, node->key, tree->key_compare_data);
+  if (cmp < 0) {
+    child = ptree_remove(tree, node->left, key, removed);
+    if (!*removed) {
+      return node;
+    }
+
+    node = ptree_node_mut(tree, node);
+    node->left = child;
+
+    return ptree_balance(tree, node);
+  }
+
+  if (cmp > 0) {
+    child = ptree_remove(tree, node->right, key, removed);
+    if (!*removed) {
+      return node;
+    }
+
+    node = ptree_node_mut(tree, node);
+    node->right = child;
+
+    return ptree_balance(tree, node);
+  }
+
+  *removed = true;
+
+  if (tree->key_destroy_func) {
+    ptree_retire(tree, tree->key_destroy_func, node->key);
+  }
+  if (tree->value_destroy_func) {
+    ptree_retire(tree, tree->value_destroy_func, node->value);
+  }
+
+  if (node->left == NULL || node->right == NULL) {
+    child = node->left ? node->left : node->right;
+    ptree_node_drop(tree, node);
+
+    return child;
+  }
+
+  right = ptree_remove_min(tree, node->right, &min);
+  min = ptree_node_mut(tree, min);
+  min->left = node->left;
+  min->right = right;
+  ptree_node_drop(tree, node);
+
+  return ptree_balance(tree, min);
+}
+
+static void ptree_free_nodes(SysPTree *tree, SysPTreeNode *node) {
+  if (node == NULL) {
+    return;
+  }
+
+  ptree_free_nodes(tree, node->left);
+  ptree_free_nodes(tree, node->right);
+
+  if (tree->key_destroy_func) {
+    tree->key_destroy_func(node->key);
+  }
+  if (tree->value_destroy_func) {
+    tree->value_destroy_func(node->value);
+  }
+
+  ptree_node_free(node);
+}
+
+static SysBool ptree_node_foreach(SysPTreeNode *node, SysTraverseFunc func, SysPointer user_data) {
+  if (node == NULL) {
+    return false;
+  }
+
+  if (ptree_node_foreach(node->left, func, user_data)) {
+    return true;
+  }
+
+  if (func(node->key, node->value, user_data)) {
+    return true;
+  }
+
+  return ptree_node_foreach(node->right, func, user_data);
+}
+
+SysPTree *sys_ptree_new(SysCompareFunc key_compare_func) {
+  sys_return_val_if_fail(key_compare_func != NULL, NULL);
+
+  return sys_ptree_new_full((SysCompareDataFunc)key_compare_func, NULL, NULL, NULL);
+}
+
+SysPTree *sys_ptree_new_full(SysCompareDataFunc key_compare_func,
+    SysPointer key_compare_data,
+    SysDestroyFunc key_destroy_func,
+    SysDestroyFunc value_destroy_func) {
+  SysPTree *tree;
+
+  sys_return_val_if_fail(key_compare_func != NULL, NULL);
+
+  tree = sys_slice_new(SysPTree);
+  tree->root = NULL;
+  tree->key_compare = key_compare_func;
+  tree->key_compare_data = key_compare_data;
+  tree->key_destroy_func = key_destroy_func;
+  tree->value_destroy_func = value_destroy_func;
+  tree->gen = 0;
+  tree->pending = NULL;
+  sys_mutex_init(&tree->lock);
+
+  return tree;
+}
+
+/**
+ * sys_ptree_free:
+ * @tree: a #SysPTree
+ *
+ * Waits for readers of older versions, then frees every entry.
+ * No thread may use @tree any more, and the caller must not be
+ * inside a read section.
+ */
+void sys_ptree_free(SysPTree *tree) {
+  sys_return_if_fail(tree != NULL);
+
+  sys_ptree_synchronize(tree);
+
+  ptree_free_nodes(tree, tree->root);
+
+  sys_mutex_clear(&tree->lock);
+  sys_slice_free(SysPTree, tree);
+}
+
+void sys_ptree_insert(SysPTree *tree, SysPointer key, SysPointer value) {
+  SysPTreeNode *root;
+
+  sys_return_if_fail(tree != NULL);
+
+  sys_mutex_lock(&tree->lock);
+
+  tree->gen++;
+  root = ptree_insert(tree, tree->root, key, value);
+  ptree_publish(tree, root);
+
+  sys_mutex_unlock(&tree->lock);
+}
+
+SysBool sys_ptree_remove(SysPTree *tree, const SysPointer key) {
+  SysPTreeNode *root;
+  SysBool removed = false;
+
+  sys_return_val_if_fail(tree != NULL, false);
+
+  sys_mutex_lock(&tree->lock);
+
+  tree->gen++;
+  root = ptree_remove(tree, tree->root, key, &removed);
+  if (removed) {
+    ptree_publish(tree, root);
+  }
+
+  sys_mutex_unlock(&tree->lock);
+
+  return removed;
+}
+
+SysInt sys_ptree_nnodes(SysPTree *tree) {
+  SysPTreeSnapshot snap;
+  SysInt n;
+
+  sys_return_val_if_fail(tree != NULL, 0);
+
+  sys_ptree_snapshot_init(&snap, tree);
+  n = sys_ptree_snapshot_nnodes(&snap);
+  sys_ptree_snapshot_clear(&snap);
+
+  return n;
+}
+
+/**
+ * sys_ptree_synchronize:
+ * @tree: a #SysPTree
+ *
+ * Waits until no reader can still see a version replaced before the
+ * call and frees it. Must not be called inside a read section.
+ */
+void sys_ptree_synchronize(SysPTree *tree) {
+  sys_return_if_fail(tree != NULL);
+
+  sys_rcu_synchronize();
+}
+
+/**
+ * sys_ptree_snapshot_init:
+ * @snap: snapshot to fill
+ * @tree: a #SysPTree
+ *
+ * Enters a read section and pins the current version of @tree.
+ * The snapshot is unaffected by later writes and must be cleared
+ * by the same thread; holding it delays reclamation for all trees.
+ */
+void sys_ptree_snapshot_init(SysPTreeSnapshot *snap, SysPTree *tree) {
+  sys_return_if_fail(snap != NULL);
+  sys_return_if_fail(tree != NULL);
+
+  sys_ptree_read_lock();
+
+  snap->tree = tree;
+  snap->root = sys_rcu_dereference(tree->root);
+}
+
+void sys_ptree_snapshot_clear(SysPTreeSnapshot *snap) {
+  sys_return_if_fail(snap != NULL);
+  sys_return_if_fail(snap->tree != NULL);
+
+  snap->tree = NULL;
+  snap->root = NULL;
+
+  sys_ptree_read_unlock();
+}
+
+SysBool sys_ptree_snapshot_lookup_extended(SysPTreeSnapshot *snap,
+    const SysPointer lookup_key,
+    SysPointer *orig_key,
+    SysPointer *value) {
+  SysPTreeNode *node;
+  SysPTree *tree;
+  SysInt cmp;
+
+  sys_return_val_if_fail(snap != NULL, false);
+  sys_return_val_if_fail(snap->tree != NULL, false);
+
+  tree = snap->tree;
+  node = snap->root;
+
+  while (node) {
+    cmp = tree->key_compare(lookup_key, node->key, tree->key_compare_data);
+
+    if (cmp == 0) {
+      if (orig_key) {
+        *orig_key = node->key;
+      }
+      if (value) {
+        *value = node->value;
+      }
+
+      return true;
+    }
+
+    node = cmp < 0 ? node->left : node->right;
+  }
+
+  return false;
+}
+
+SysPointer sys_ptree_snapshot_lookup(SysPTreeSnapshot *snap, const SysPointer key) {
+  SysPointer value = NULL;
+
+  sys_ptree_snapshot_lookup_extended(snap, key, NULL, &value);
+
+  return value;
+}
+
+void sys_ptree_snapshot_foreach(SysPTreeSnapshot *snap, SysTraverseFunc func, SysPointer user_data) {
+  sys_return_if_fail(snap != NULL);
+  sys_return_if_fail(snap->tree != NULL);
+  sys_return_if_fail(func != NULL);
+
+  ptree_node_foreach(snap->root, func, user_data);
+}
+
+SysInt sys_ptree_snapshot_nnodes(SysPTreeSnapshot *snap) {
+  sys_return_val_if_fail(snap != NULL, 0);
+  sys_return_val_if_fail(snap->tree != NULL, 0);
+
+  return (SysInt)ptree_size(snap->root);
+}
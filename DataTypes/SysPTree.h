@@ -0,0 +1,62 @@
+#ifndef __SYS_PTREE_H__
+#define __SYS_PTREE_H__
+
+#include <System/DataTypes/SysTree.h>
+#include <System/Platform/Common/SysThread.h>
+
+SYS_BEGIN_DECLS
+
+/**
+ * SysPTree: persistent (copy-on-write) AVL tree.
+ *
+ * Published nodes are never modified. A writer copies the path from
+ * the root to the changed node, links the copies to the untouched
+ * subtrees and swaps the root pointer, so every root ever published
+ * stays a consistent snapshot and a write costs O(log n) new nodes.
+ *
+ * Writers are serialized by a mutex in the tree. Readers take no lock,
+ * they enter an RCU read section (sys_ptree_read_lock() or a
+ * SysPTreeSnapshot) and nodes replaced by writers go through
+ * sys_rcu_call(), so they are only freed once every reader that could
+ * have seen them has left its section.
+ * Keys and values returned to a reader stay valid until it leaves.
+ */
+
+typedef struct _SysPTree SysPTree;
+typedef struct _SysPTreeNode SysPTreeNode;
+typedef struct _SysPTreeSnapshot SysPTreeSnapshot;
+
+struct _SysPTreeSnapshot {
+  /* <private> */
+  SysPTree *tree;
+  SysPTreeNode *root;
+};
+
+SYS_API SysPTree *sys_ptree_new(SysCompareFunc key_compare_func);
+SYS_API SysPTree *sys_ptree_new_full(SysCompareDataFunc key_compare_func,
+    SysPointer key_compare_data,
+    SysDestroyFunc key_destroy_func,
+    SysDestroyFunc value_destroy_func);
+SYS_API void sys_ptree_free(SysPTree *tree);
+
+SYS_API void sys_ptree_insert(SysPTree *tree, SysPointer key, SysPointer value);
+SYS_API SysBool sys_ptree_remove(SysPTree *tree, const SysPointer key);
+SYS_API SysInt sys_ptree_nnodes(SysPTree *tree);
+SYS_API void sys_ptree_synchronize(SysPTree *tree);
+
+SYS_API void sys_ptree_read_lock(void);
+SYS_API void sys_ptree_read_unlock(void);
+
+SYS_API void sys_ptree_snapshot_init(SysPTreeSnapshot *snap, SysPTree *tree);
+SYS_API void sys_ptree_snapshot_clear(SysPTreeSnapshot *snap);
+SYS_API SysPointer sys_ptree_snapshot_lookup(SysPTreeSnapshot *snap, const SysPointer key);
+SYS_API SysBool sys_ptree_snapshot_lookup_extended(SysPTreeSnapshot *snap,
+    const SysPointer lookup_key,
+    SysPointer *orig_key,
+    SysPointer *value);
+SYS_API void sys_ptree_snapshot_foreach(SysPTreeSnapshot *snap, SysTraverseFunc func, SysPointer user_data);
+SYS_API SysInt sys_ptree_snapshot_nnodes(SysPTreeSnapshot *snap);
+
+SYS_END_DECLS
+
+#endif
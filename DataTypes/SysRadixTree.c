@@ -0,0 +1,954 @@
+#include <System/DataTypes/SysRadixTree.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* prefix bytes kept in the node, longer prefixes are checked at a leaf */
+#define ART_MAX_PREFIX 10
+
+#define ART_IS_LEAF(p) (((SysUIntPtr)(p)) & 1)
+#define ART_LEAF(p) ((SysArtLeaf *)((SysUIntPtr)(p) & ~(SysUIntPtr)1))
+#define ART_TAG_LEAF(l) ((SysArtNode *)((SysUIntPtr)(l) | 1))
+
+typedef struct _SysArtNode SysArtNode;
+typedef struct _SysArtNode4 SysArtNode4;
+typedef struct _SysArtNode16 SysArtNode16;
+typedef struct _SysArtNode48 SysArtNode48;
+typedef struct _SysArtNode256 SysArtNode256;
+typedef struct _SysArtLeaf SysArtLeaf;
+
+typedef enum _SysArtType {
+  ART_NODE4,
+  ART_NODE16,
+  ART_NODE48,
+  ART_NODE256
+} SysArtType;
+
+struct _SysArtNode {
+  SysUInt8 type;
+  SysUInt16 nchildren;
+  SysUInt32 prefix_len;
+  SysUChar prefix[ART_MAX_PREFIX];
+};
+
+/* node4 and node16 keep their keys sorted */
+struct _SysArtNode4 {
+  SysArtNode n;
+  SysUChar keys[4];
+  SysArtNode *children[4];
+};
+
+struct _SysArtNode16 {
+  SysArtNode n;
+  SysUChar keys[16];
+  SysArtNode *children[16];
+};
+
+/* index holds slot + 1, 0 means no child */
+struct _SysArtNode48 {
+  SysArtNode n;
+  SysUChar index[256];
+  SysArtNode *children[48];
+};
+
+struct _SysArtNode256 {
+  SysArtNode n;
+  SysArtNode *children[256];
+};
+
+/* key includes the terminating nul, so no key is a prefix of another */
+struct _SysArtLeaf {
+  SysPointer value;
+  SysUInt32 len;
+  SysUChar key[];
+};
+
+struct _SysRadixTree {
+  SysArtNode *root;
+  SysUInt nnodes;
+  SysDestroyFunc value_destroy_func;
+};
+
+static SysArtLeaf *art_leaf_new(const SysUChar *key, SysUInt32 len, SysPointer value) {
+  SysArtLeaf *leaf = sys_malloc(sizeof(SysArtLeaf) + len);
+
+  leaf->value = value;
+  leaf->len = len;
+  memcpy(leaf->key, key, len);
+
+  return leaf;
+}
+
+static SysBool art_leaf_matches(SysArtLeaf *leaf, const SysUChar *key, SysUInt32 len) {
+  return leaf->len == len && memcmp(leaf->key, key, len) == 0;
+}
+
+static SysArtNode *art_node_new(SysArtType type) {
+  SysArtNode *n;
+
+  switch (type) {
+    case ART_NODE4:
+      n = sys_malloc0(sizeof(SysArtNode4));
+      break;
+    case ART_NODE16:
+      n = sys_malloc0(sizeof(SysArtNode16));
+      break;
+    case ART_NODE48:
+      n = sys_malloc0(sizeof(SysArtNode48));
+      break;
+    default:
+      n = sys_malloc0(sizeof(SysArtNode256));
+      break;
+  }
+
+  n->type = (SysUInt8)type;
+
+  return n;
+}
+
+static void art_copy_header(SysArtNode *dst, SysArtNode *src) {
+  dst->nchildren = src->nchildren;
+  dst->prefix_len = src->prefix_len;
+  memcpy(dst->prefix, src->prefix, min(ART_MAX_PREFIX, src->prefix_len));
+}
+
+static SysArtNode **art_find_child(SysArtNode *n, SysUChar c) {
+  switch (n->type) {
+    case ART_NODE4:
+      {
+        SysArtNode4 *p = (SysArtNode4 *)n;
+
+        for (SysUInt i = 0; i < n->nchildren; i++) {
+          if (p->keys[i] == c) {
+            return &p->children[i];
+          }
+        }
+      }
+      break;
+    case ART_NODE16:
+      {
+        SysArtNode16 *p = (SysArtNode16 *)n;
+#if defined(__SSE2__)
+        __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char)c),
+            _mm_loadu_si128((const __m128i *)p->keys));
+        SysUInt bits = (SysUInt)_mm_movemask_epi8(cmp) & ((1U << n->nchildren) - 1);
+
+        if (bits) {
+          return &p->children[__builtin_ctz(bits)];
+        }
+#else
+        SysUInt lo = 0, hi = n->nchildren, mid;
+
+        while (lo < hi) {
+          mid = (lo + hi) / 2;
+
+          if (p->keys[mid] < c) {
+            lo = mid + 1;
+          } else if (p->keys[mid] > c) {
+            hi = mid;
+          } else {
+            return &p->children[mid];
+          }
+        }
+#endif
+      }
+      break;
+    case ART_NODE48:
+      {
+        SysArtNode48 *p = (SysArtNode48 *)n;
+
+        if (p->index[c]) {
+          return &p->children[p->index[c] - 1];
+        }
+      }
+      break;
+    default:
+      {
+        SysArtNode256 *p = (SysArtNode256 *)n;
+
+        if (p->children[c]) {
+          return &p->children[c];
+        }
+      }
+      break;
+  }
+
+  return NULL;
+}
+
+static SysArtLeaf *art_minimum(SysArtNode *n) {
+  SysUInt i;
+
+  while (n && !ART_IS_LEAF(n)) {
+    switch (n->type) {
+      case ART_NODE4:
+        n = ((SysArtNode4 *)n)->children[0];
+        break;
+      case ART_NODE16:
+        n = ((SysArtNode16 *)n)->children[0];
+        break;
+      case ART_NODE48:
+        for (i = 0; !((SysArtNode48 *)n)->index[i]; i++);
+        n = ((SysArtNode48 *)n)->children[((SysArtNode48 *)n)->index[i] - 1];
+        break;
+      default:
+        for (i = 0; !((SysArtNode256 *)n)->children[i]; i++);
+        n = ((SysArtNode256 *)n)->children[i];
+        break;
+    }
+  }
+
+  return n ? ART_LEAF(n) : NULL;
+}
+
+/* optimistic: only the bytes stored in the node are compared */
+static SysUInt32 art_check_prefix(SysArtNode *n, const SysUChar *key, SysUInt32 len, SysUInt32 depth) {
+  SysUInt32 max_cmp = min(min(n->prefix_len, ART_MAX_PREFIX), len - depth);
+  SysUInt32 idx;
+
+  for (idx = 0; idx < max_cmp; idx++) {
+    if (n->prefix[idx] != key[depth + idx]) {
+      return idx;
+    }
+  }
+
+  return idx;
+}
+
+/* exact: bytes past ART_MAX_PREFIX are taken from the smallest leaf */
+static SysUInt32 art_prefix_mismatch(SysArtNode *n, const SysUChar *key, SysUInt32 len, SysUInt32 depth) {
+  SysUInt32 max_cmp = min(min(n->prefix_len, ART_MAX_PREFIX), len - depth);
+  SysArtLeaf *leaf;
+  SysUInt32 idx;
+
+  for (idx = 0; idx < max_cmp; idx++) {
+    if (n->prefix[idx] != key[depth + idx]) {
+      return idx;
+    }
+  }
+
+  if (n->prefix_len > ART_MAX_PREFIX) {
+    leaf = art_minimum(n);
+    max_cmp = min(min(leaf->len, len) - depth, n->prefix_len);
+
+    for (; idx < max_cmp; idx++) {
+      if (leaf->key[depth + idx] != key[depth + idx]) {
+        return idx;
+      }
+    }
+  }
+
+  return idx;
+}
+
+static SysUInt32 art_common_prefix(SysArtLeaf *leaf, const SysUChar *key, SysUInt32 len, SysUInt32 depth) {
+  SysUInt32 max_cmp = min(leaf->len, len) - depth;
+  SysUInt32 idx;
+
+  for (idx = 0; idx < max_cmp; idx++) {
+    if (leaf->key[depth + idx] != key[depth + idx]) {
+      return idx;
+    }
+  }
+
+  return idx;
+}
+
+/* add child */
+static void art_add_child256(SysArtNode256 *n, SysUChar c, SysArtNode *child) {
+  n->children[c] = child;
+  n->n.nchildren++;
+}
+
+static void art_add_child48(SysArtNode48 *n, SysArtNode **ref, SysUChar c, SysArtNode *child) {
+  SysArtNode256 *nn;
+  SysUInt pos;
+
+  if (n->n.nchildren < 48) {
+    for (pos = 0; n->children[pos]; pos++);
+
+    n->children[pos] = child;
+    n->index[c] = (SysUChar)(pos + 1);
+    n->n.nchildren++;
+
+    return;
+  }
+
+  nn = (SysArtNode256 *)art_node_new(ART_NODE256);
+  art_copy_header(&nn->n, &n->n);
+  for (SysUInt i = 0; i < 256; i++) {
+    if (n->index[i]) {
+      nn->children[i] = n->children[n->index[i] - 1];
+    }
+  }
+
+  *ref = (SysArtNode *)nn;
+  sys_free(n);
+
+  art_add_child256(nn, c, child);
+}
+
+static void art_add_child16(SysArtNode16 *n, SysArtNode **ref, SysUChar c, SysArtNode *child) {
+  SysArtNode48 *nn;
+  SysUInt pos, count = n->n.nchildren;
+
+  if (count < 16) {
+    for (pos = 0; pos < count && n->keys[pos] < c; pos++);
+
+    memmove(&n->keys[pos + 1], &n->keys[pos], count - pos);
+    memmove(&n->children[pos + 1], &n->children[pos], (count - pos) * sizeof(SysArtNode *));
+    n->keys[pos] = c;
+    n->children[pos] = child;
+    n->n.nchildren++;
+
+    return;
+  }
+
+  nn = (SysArtNode48 *)art_node_new(ART_NODE48);
+  art_copy_header(&nn->n, &n->n);
+  memcpy(nn->children, n->children, 16 * sizeof(SysArtNode *));
+  for (SysUInt i = 0; i < 16; i++) {
+    nn->index[n->keys[i]] = (SysUChar)(i + 1);
+  }
+
+  *ref = (SysArtNode *)nn;
+  sys_free(n);
+
+  art_add_child48(nn, ref, c, child);
+}
+
+static void art_add_child4(SysArtNode4 *n, SysArtNode **ref, SysUChar c, SysArtNode *child) {
+  SysArtNode16 *nn;
+  SysUInt pos, count = n->n.nchildren;
+
+  if (count < 4) {
+    for (pos = 0; pos < count && n->keys[pos] < c; pos++);
+
+    memmove(&n->keys[pos + 1], &n->keys[pos], count - pos);
+    memmove(&n->children[pos + 1], &n->children[pos], (count - pos) * sizeof(SysArtNode *));
+    n->keys[pos] = c;
+    n->children[pos] = child;
+    n->n.nchildren++;
+
+    return;
+  }
+
+  nn = (SysArtNode16 *)art_node_new(ART_NODE16);
+  art_copy_header(&nn->n, &n->n);
+  memcpy(nn->keys, n->keys, 4);
+  memcpy(nn->children, n->children, 4 * sizeof(SysArtNode *));
+
+  *ref = (SysArtNode *)nn;
+  sys_free(n);
+
+  art_add_child16(nn, ref, c, child);
+}
+
+static void art_add_child(SysArtNode *n, SysArtNode **ref, SysUChar c, SysArtNode *child) {
+  switch (n->type) {
+    case ART_NODE4:
+      art_add_child4((SysArtNode4 *)n, ref, c, child);
+      break;
+    case ART_NODE16:
+      art_add_child16((SysArtNode16 *)n, ref, c, child);
+      break;
+    case ART_NODE48:
+      art_add_child48((SysArtNode48 *)n, ref, c, child);
+      break;
+    default:
+      art_add_child256((SysArtNode256 *)n, c, child);
+      break;
+  }
+}
+
+/* remove child, nodes shrink with some hysteresis */
+static void art_remove_child256(SysArtNode256 *n, SysArtNode **ref, SysUChar c) {
+  SysArtNode48 *nn;
+  SysUInt pos = 0;
+
+  n->children[c] = NULL;
+  n->n.nchildren--;
+
+  if (n->n.nchildren != 37) {
+    return;
+  }
+
+  nn = (SysArtNode48 *)art_node_new(ART_NODE48);
+  art_copy_header(&nn->n, &n->n);
+  for (SysUInt i = 0; i < 256; i++) {
+    if (n->children[i]) {
+      nn->children[pos] = n->children[i];
+      nn->index[i] = (SysUChar)(pos + 1);
+      pos++;
+    }
+  }
+
+  *ref = (SysArtNode *)nn;
+  sys_free(n);
+}
+
+static void art_remove_child48(SysArtNode48 *n, SysArtNode **ref, SysUChar c) {
+  SysArtNode16 *nn;
+  SysUInt pos = n->index[c], child = 0;
+
+  n->index[c] = 0;
+  n->children[pos - 1] = NULL;
+  n->n.nchildren--;
+
+  if (n->n.nchildren != 12) {
+    return;
+  }
+
+  nn = (SysArtNode16 *)art_node_new(ART_NODE16);
+  art_copy_header(&nn->n, &n->n);
+  for (SysUInt i = 0; i < 256; i++) {
+    pos = n->index[i];
+
+    if (pos) {
+      nn->keys[child] = (SysUChar)i;
+      nn->children[child] = n->children[pos - 1];
+      child++;
+    }
+  }
+
+  *ref = (SysArtNode *)nn;
+  sys_free(n);
+}
+
+static void art_remove_child16(SysArtNode16 *n, SysArtNode **ref, SysArtNode **slot) {
+  SysArtNode4 *nn;
+  SysUInt pos = (SysUInt)(slot - n->children);
+  SysUInt count = --n->n.nchildren;
+
+  memmove(&n->keys[pos], &n->keys[pos + 1], count - pos);
+  memmove(&n->children[pos], &n->children[pos + 1], (count - pos) * sizeof(SysArtNode *));
+
+  if (count != 3) {
+    return;
+  }
+
+  nn = (SysArtNode4 *)art_node_new(ART_NODE4);
+  art_copy_header(&nn->n, &n->n);
+  memcpy(nn->keys, n->keys, 3);
+  memcpy(nn->children, n->children, 3 * sizeof(SysArtNode *));
+
+  *ref = (SysArtNode *)nn;
+  sys_free(n);
+}
+
+static void art_remove_child4(SysArtNode4 *n, SysArtNode **ref, SysArtNode **slot) {
+  SysUInt pos = (SysUInt)(slot - n->children);
+  SysUInt count = --n->n.nchildren;
+  SysArtNode *child;
+  SysUInt32 prefix, sub;
+
+  memmove(&n->keys[pos], &n->keys[pos + 1], count - pos);
+  memmove(&n->children[pos], &n->children[pos + 1], (count - pos) * sizeof(SysArtNode *));
+
+  if (count != 1) {
+    return;
+  }
+
+  /* a single child takes over the node, prefixes are concatenated */
+  child = n->children[0];
+  if (!ART_IS_LEAF(child)) {
+    prefix = n->n.prefix_len;
+
+    if (prefix < ART_MAX_PREFIX) {
+      n->n.prefix[prefix] = n->keys[0];
+      prefix++;
+    }
+
+    if (prefix < ART_MAX_PREFIX) {
+      sub = min(child->prefix_len, ART_MAX_PREFIX - prefix);
+      memcpy(&n->n.prefix[prefix], child->prefix, sub);
+      prefix += sub;
+    }
+
+    memcpy(child->prefix, n->n.prefix, min(prefix, ART_MAX_PREFIX));
+    child->prefix_len += n->n.prefix_len + 1;
+  }
+
+  *ref = child;
+  sys_free(n);
+}
+
+static void art_remove_child(SysArtNode *n, SysArtNode **ref, SysUChar c, SysArtNode **slot) {
+  switch (n->type) {
+    case ART_NODE4:
+      art_remove_child4((SysArtNode4 *)n, ref, slot);
+      break;
+    case ART_NODE16:
+      art_remove_child16((SysArtNode16 *)n, ref, slot);
+      break;
+    case ART_NODE48:
+      art_remove_child48((SysArtNode48 *)n, ref, c);
+      break;
+    default:
+      art_remove_child256((SysArtNode256 *)n, ref, c);
+      break;
+  }
+}
+
+/* returns the existing leaf for @key, or NULL when a leaf was added */
+static SysArtLeaf *art_insert(SysArtNode *n,
+    SysArtNode **ref,
+    const SysUChar *key,
+    SysUInt32 len,
+    SysUInt32 depth,
+    SysPointer value) {
+  SysArtLeaf *leaf, *nleaf;
+  SysArtNode4 *nn;
+  SysArtNode **child;
+  SysUInt32 lcp, diff;
+
+  if (n == NULL) {
+    *ref = ART_TAG_LEAF(art_leaf_new(key, len, value));
+    return NULL;
+  }
+
+  if (ART_IS_LEAF(n)) {
+    leaf = ART_LEAF(n);
+    if (art_leaf_matches(leaf, key, len)) {
+      return leaf;
+    }
+
+    nn = (SysArtNode4 *)art_node_new(ART_NODE4);
+    nleaf = art_leaf_new(key, len, value);
+
+    lcp = art_common_prefix(leaf, key, len, depth);
+    nn->n.prefix_len = lcp;
+    memcpy(nn->n.prefix, key + depth, min(ART_MAX_PREFIX, lcp));
+
+    *ref = (SysArtNode *)nn;
+    art_add_child4(nn, ref, leaf->key[depth + lcp], n);
+    art_add_child4(nn, ref, key[depth + lcp], ART_TAG_LEAF(nleaf));
+
+    return NULL;
+  }
+
+  if (n->prefix_len) {
+    diff = art_prefix_mismatch(n, key, len, depth);
+
+    if (diff < n->prefix_len) {
+      nn = (SysArtNode4 *)art_node_new(ART_NODE4);
+      nn->n.prefix_len = diff;
+      memcpy(nn->n.prefix, n->prefix, min(ART_MAX_PREFIX, diff));
+      *ref = (SysArtNode *)nn;
+
+      if (n->prefix_len <= ART_MAX_PREFIX) {
+        art_add_child4(nn, ref, n->prefix[diff], n);
+        n->prefix_len -= diff + 1;
+        memmove(n->prefix, n->prefix + diff + 1, min(ART_MAX_PREFIX, n->prefix_len));
+      } else {
+        n->prefix_len -= diff + 1;
+        leaf = art_minimum(n);
+        art_add_child4(nn, ref, leaf->key[depth + diff], n);
+        memcpy(n->prefix, leaf->key + depth + diff + 1, min(ART_MAX_PREFIX, n->prefix_len));
+      }
+
+      nleaf = art_leaf_new(key, len, value);
+      art_add_child4(nn, ref, key[depth + diff], ART_TAG_LEAF(nleaf));
+
+      return NULL;
+    }
+
+    depth += n->prefix_len;
+  }
+
+  child = art_find_child(n, key[depth]);
+  if (child) {
+    return art_insert(*child, child, key, len, depth + 1, value);
+  }
+
+  nleaf = art_leaf_new(key, len, value);
+  art_add_child(n, ref, key[depth], ART_TAG_LEAF(nleaf));
+
+  return NULL;
+}
+
+static SysArtLeaf *art_delete(SysArtNode *n,
+    SysArtNode **ref,
+    const SysUChar *key,
+    SysUInt32 len,
+    SysUInt32 depth) {
+  SysArtNode **child;
+  SysArtLeaf *leaf;
+
+  while (n) {
+    if (ART_IS_LEAF(n)) {
+      leaf = ART_LEAF(n);
+      if (!art_leaf_matches(leaf, key, len)) {
+        return NULL;
+      }
+
+      *ref = NULL;
+      return leaf;
+    }
+
+    if (n->prefix_len) {
+      if (art_check_prefix(n, key, len, depth) != min(ART_MAX_PREFIX, n->prefix_len)) {
+        return NULL;
+      }
+
+      depth += n->prefix_len;
+    }
+
+    if (depth >= len) {
+      return NULL;
+    }
+
+    child = art_find_child(n, key[depth]);
+    if (child == NULL) {
+      return NULL;
+    }
+
+    if (ART_IS_LEAF(*child)) {
+      leaf = ART_LEAF(*child);
+      if (!art_leaf_matches(leaf, key, len)) {
+        return NULL;
+      }
+
+      art_remove_child(n, ref, key[depth], child);
+      return leaf;
+    }
+
+    ref = child;
+    n = *child;
+    depth++;
+  }
+
+  return NULL;
+}
+
+static SysArtLeaf *art_search(SysArtNode *n, const SysUChar *key, SysUInt32 len) {
+  SysArtNode **child;
+  SysUInt32 depth = 0;
+  SysArtLeaf *leaf;
+
+  while (n) {
+    if (ART_IS_LEAF(n)) {
+      leaf = ART_LEAF(n);
+
+      return art_leaf_matches(leaf, key, len) ? leaf : NULL;
+    }
+
+    if (n->prefix_len) {
+      if (art_check_prefix(n, key, len, depth) != min(ART_MAX_PREFIX, n->prefix_len)) {
+        return NULL;
+      }
+
+      depth += n->prefix_len;
+    }
+
+    if (depth >= len) {
+      return NULL;
+    }
+
+    child = art_find_child(n, key[depth]);
+    n = child ? *child : NULL;
+    depth++;
+  }
+
+  return NULL;
+}
+
+static SysBool art_foreach(SysArtNode *n, SysTraverseFunc func, SysPointer user_data) {
+  SysArtLeaf *leaf;
+  SysUInt i;
+
+  if (n == NULL) {
+    return false;
+  }
+
+  if (ART_IS_LEAF(n)) {
+    leaf = ART_LEAF(n);
+
+    return func((SysPointer)leaf->key, leaf->value, user_data);
+  }
+
+  switch (n->type) {
+    case ART_NODE4:
+      for (i = 0; i < n->nchildren; i++) {
+        if (art_foreach(((SysArtNode4 *)n)->children[i], func, user_data)) {
+          return true;
+        }
+      }
+      break;
+    case ART_NODE16:
+      for (i = 0; i < n->nchildren; i++) {
+        if (art_foreach(((SysArtNode16 *)n)->children[i], func, user_data)) {
+          return true;
+        }
+      }
+      break;
+    case ART_NODE48:
+      for (i = 0; i < 256; i++) {
+        SysUInt pos = ((SysArtNode48 *)n)->index[i];
+
+        if (pos && art_foreach(((SysArtNode48 *)n)->children[pos - 1], func, user_data)) {
+          return true;
+        }
+      }
+      break;
+    default:
+      for (i = 0; i < 256; i++) {
+        if (art_foreach(((SysArtNode256 *)n)->children[i], func, user_data)) {
+          return true;
+        }
+      }
+      break;
+  }
+
+  return false;
+}
+
+static void art_free(SysRadixTree *tree, SysArtNode *n) {
+  SysArtLeaf *leaf;
+  SysUInt i;
+
+  if (n == NULL) {
+    return;
+  }
+
+  if (ART_IS_LEAF(n)) {
+    leaf = ART_LEAF(n);
+
+    if (tree->value_destroy_func) {
+      tree->value_destroy_func(leaf->value);
+    }
+
+    sys_free(leaf);
+    return;
+  }
+
+  switch (n->type) {
+    case ART_NODE4:
+      for (i = 0; i < n->nchildren; i++) {
+        art_free(tree, ((SysArtNode4 *)n)->children[i]);
+      }
+      break;
+    case ART_NODE16:
+      for (i = 0; i < n->nchildren; i++) {
+        art_free(tree, ((SysArtNode16 *)n)->children[i]);
+      }
+      break;
+    case ART_NODE48:
+      for (i = 0; i < 48; i++) {
+        art_free(tree, ((SysArtNode48 *)n)->children[i]);
+      }
+      break;
+    default:
+      for (i = 0; i < 256; i++) {
+        art_free(tree, ((SysArtNode256 *)n)->children[i]);
+      }
+      break;
+  }
+
+  sys_free(n);
+}
+
+SysRadixTree *sys_radix_tree_new(void) {
+  return sys_radix_tree_new_full(NULL);
+}
+
+SysRadixTree *sys_radix_tree_new_full(SysDestroyFunc value_destroy_func) {
+  SysRadixTree *tree = sys_slice_new(SysRadixTree);
+
+  tree->root = NULL;
+  tree->nnodes = 0;
+  tree->value_destroy_func = value_destroy_func;
+
+  return tree;
+}
+
+void sys_radix_tree_remove_all(SysRadixTree *tree) {
+  sys_return_if_fail(tree != NULL);
+
+  art_free(tree, tree->root);
+  tree->root = NULL;
+  tree->nnodes = 0;
+}
+
+void sys_radix_tree_free(SysRadixTree *tree) {
+  sys_return_if_fail(tree != NULL);
+
+  sys_radix_tree_remove_all(tree);
+  sys_slice_free(SysRadixTree, tree);
+}
+
+/**
+ * sys_radix_tree_insert:
+ * @tree: a #SysRadixTree
+ * @key: the key, copied into the tree
+ * @value: the value
+ *
+ * Inserts or replaces, an old value is freed with the value destroy func.
+ */
+void sys_radix_tree_insert(SysRadixTree *tree, const SysChar *key, SysPointer value) {
+  SysArtLeaf *leaf;
+
+  sys_return_if_fail(tree != NULL);
+  sys_return_if_fail(key != NULL);
+
+  leaf = art_insert(tree->root, &tree->root, (const SysUChar *)key, (SysUInt32)strlen(key) + 1, 0, value);
+  if (leaf == NULL) {
+    tree->nnodes++;
+    return;
+  }
+
+  if (tree->value_destroy_func) {
+    tree->value_destroy_func(leaf->value);
+  }
+  leaf->value = value;
+}
+
+SysBool sys_radix_tree_steal(SysRadixTree *tree, const SysChar *key, SysPointer *value) {
+  SysArtLeaf *leaf;
+
+  sys_return_val_if_fail(tree != NULL, false);
+  sys_return_val_if_fail(key != NULL, false);
+
+  leaf = art_delete(tree->root, &tree->root, (const SysUChar *)key, (SysUInt32)strlen(key) + 1, 0);
+  if (leaf == NULL) {
+    return false;
+  }
+
+  if (value) {
+    *value = leaf->value;
+  }
+
+  sys_free(leaf);
+  tree->nnodes--;
+
+  return true;
+}
+
+SysBool sys_radix_tree_remove(SysRadixTree *tree, const SysChar *key) {
+  SysPointer value;
+
+  if (!sys_radix_tree_steal(tree, key, &value)) {
+    return false;
+  }
+
+  if (tree->value_destroy_func) {
+    tree->value_destroy_func(value);
+  }
+
+  return true;
+}
+
+SysBool sys_radix_tree_lookup_extended(SysRadixTree *tree,
+    const SysChar *lookup_key,
+    const SysChar **orig_key,
+    SysPointer *value) {
+  SysArtLeaf *leaf;
+
+  sys_return_val_if_fail(tree != NULL, false);
+  sys_return_val_if_fail(lookup_key != NULL, false);
+
+  leaf = art_search(tree->root, (const SysUChar *)lookup_key, (SysUInt32)strlen(lookup_key) + 1);
+  if (leaf == NULL) {
+    return false;
+  }
+
+  if (orig_key) {
+    *orig_key = (const SysChar *)leaf->key;
+  }
+  if (value) {
+    *value = leaf->value;
+  }
+
+  return true;
+}
+
+SysPointer sys_radix_tree_lookup(SysRadixTree *tree, const SysChar *key) {
+  SysPointer value = NULL;
+
+  sys_radix_tree_lookup_extended(tree, key, NULL, &value);
+
+  return value;
+}
+
+/**
+ * sys_radix_tree_foreach:
+ * @tree: a #SysRadixTree
+ * @func: called with each key and value in strcmp() order,
+ *        returns true to stop
+ * @user_data: passed to @func
+ */
+void sys_radix_tree_foreach(SysRadixTree *tree, SysTraverseFunc func, SysPointer user_data) {
+  sys_return_if_fail(tree != NULL);
+  sys_return_if_fail(func != NULL);
+
+  art_foreach(tree->root, func, user_data);
+}
+
+/**
+ * sys_radix_tree_foreach_prefix:
+ * @tree: a #SysRadixTree
+ * @prefix: keys starting with @prefix are visited
+ * @func: called in strcmp() order, returns true to stop
+ * @user_data: passed to @func
+ *
+ * Descends to the subtree of @prefix once, then walks it.
+ */
+void sys_radix_tree_foreach_prefix(SysRadixTree *tree,
+    const SysChar *prefix,
+    SysTraverseFunc func,
+    SysPointer user_data) {
+  const SysUChar *key = (const SysUChar *)prefix;
+  SysUInt32 len, depth = 0, match;
+  SysArtNode **child;
+  SysArtNode *n;
+  SysArtLeaf *leaf;
+
+  sys_return_if_fail(tree != NULL);
+  sys_return_if_fail(prefix != NULL);
+  sys_return_if_fail(func != NULL);
+
+  len = (SysUInt32)strlen(prefix);
+  n = tree->root;
+
+  while (n) {
+    if (ART_IS_LEAF(n)) {
+      leaf = ART_LEAF(n);
+
+      if (leaf->len > len && memcmp(leaf->key, key, len) == 0) {
+        func((SysPointer)leaf->key, leaf->value, user_data);
+      }
+      return;
+    }
+
+    if (depth == len) {
+      art_foreach(n, func, user_data);
+      return;
+    }
+
+    if (n->prefix_len) {
+      match = art_prefix_mismatch(n, key, len, depth);
+
+      if (depth + match == len) {
+        art_foreach(n, func, user_data);
+        return;
+      }
+
+      if (match < n->prefix_len) {
+        return;
+      }
+
+      depth += n->prefix_len;
+    }
+
+    child = art_find_child(n, key[depth]);
+    n = child ? *child : NULL;
+    depth++;
+  }
+}
+
+SysInt sys_radix_tree_nnodes(SysRadixTree *tree) {
+  sys_return_val_if_fail(tree != NULL, 0);
+
+  return (SysInt)tree->nnodes;
+}
@@ -0,0 +1,44 @@
+#ifndef __SYS_RADIX_TREE_H__
+#define __SYS_RADIX_TREE_H__
+
+#include <System/DataTypes/SysTree.h>
+
+SYS_BEGIN_DECLS
+
+/**
+ * SysRadixTree: adaptive radix tree (ART) keyed by strings.
+ *
+ * Inner nodes grow through 4, 16, 48 and 256 children as needed and
+ * store the compressed path prefix, so lookup cost depends on the key
+ * length only, not on the number of keys. Keys are copied into the
+ * leaves, iteration is in strcmp() order.
+ */
+
+typedef struct _SysRadixTree SysRadixTree;
+
+SYS_API SysRadixTree *sys_radix_tree_new(void);
+SYS_API SysRadixTree *sys_radix_tree_new_full(SysDestroyFunc value_destroy_func);
+SYS_API void sys_radix_tree_free(SysRadixTree *tree);
+SYS_API void sys_radix_tree_remove_all(SysRadixTree *tree);
+
+SYS_API void sys_radix_tree_insert(SysRadixTree *tree, const SysChar *key, SysPointer value);
+SYS_API SysBool sys_radix_tree_remove(SysRadixTree *tree, const SysChar *key);
+SYS_API SysBool sys_radix_tree_steal(SysRadixTree *tree, const SysChar *key, SysPointer *value);
+
+SYS_API SysPointer sys_radix_tree_lookup(SysRadixTree *tree, const SysChar *key);
+SYS_API SysBool sys_radix_tree_lookup_extended(SysRadixTree *tree,
+    const SysChar *lookup_key,
+    const SysChar **orig_key,
+    SysPointer *value);
+
+SYS_API void sys_radix_tree_foreach(SysRadixTree *tree, SysTraverseFunc func, SysPointer user_data);
+SYS_API void sys_radix_tree_foreach_prefix(SysRadixTree *tree,
+    const SysChar *prefix,
+    SysTraverseFunc func,
+    SysPointer user_data);
+
+SYS_API SysInt sys_radix_tree_nnodes(SysRadixTree *tree);
+
+SYS_END_DECLS
+
+#endif
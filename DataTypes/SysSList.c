@@ -1,4 +1,5 @@
 #include <System/DataTypes/SysSList.h>
+#include <System/DataTypes/SysListPrivate.h>
 
 
 /**
@@ -474,34 +475,7 @@ static SysSList * sys_slist_sort_merge (SysSList   *l1,
   return list.next;
 }
 
-static SysSList * sys_slist_sort_real (SysSList   *list,
-                   SysFunc     compare_func,
-                   SysPointer  user_data) {
-  SysSList *l1, *l2;
-
-  if (!list)
-    return NULL;
-  if (!list->next)
-    return list;
-
-  l1 = list;
-  l2 = list->next;
-
-  while ((l2 = l2->next) != NULL)
-    {
-      if ((l2 = l2->next) == NULL)
-        break;
-      l1=l1->next;
-    }
-  l2 = l1->next;
-  l1->next = NULL;
-
-  return sys_slist_sort_merge (
-      sys_slist_sort_real (list, compare_func, user_data),
-      sys_slist_sort_real (l2, compare_func, user_data),
-      compare_func,
-      user_data);
-}
+SYS_LIST_DEFINE_SORT(sys_slist_sort_real, SysSList, sys_slist_sort_merge)
 
 SysSList * sys_slist_sort (SysSList       *list,
               SysCompareFunc  compare_func) {
@@ -514,6 +488,34 @@ SysSList * sys_slist_sort_with_data (SysSList           *list,
   return sys_slist_sort_real (list, (SysFunc) compare_func, user_data);
 }
 
+/**
+ * sys_slist_insert_sorted_list:
+ * @list: a sorted list
+ * @batch: a list sorted with the same @func
+ *
+ * Merges @batch into @list in one pass, nodes of @list come first when
+ * they compare equal.
+ *
+ * Returns: the new start of the merged list
+ */
+SysSList* sys_slist_insert_sorted_list (SysSList       *list,
+                       SysSList       *batch,
+                       SysCompareFunc  func) {
+  sys_return_val_if_fail (func != NULL, list);
+
+  return sys_slist_sort_merge (list, batch, (SysFunc) func, NULL);
+}
+
+SysSList* sys_slist_insert_sorted_list_with_data (SysSList           *list,
+                                 SysSList           *batch,
+                                 SysCompareDataFunc  func,
+                                 SysPointer          user_data) {
+  sys_return_val_if_fail (func != NULL, list);
+
+  return sys_slist_sort_merge (list, batch, (SysFunc) func, user_data);
+}
+
+
 void (sys_clear_slist) (SysSList         **slist_ptr,
                  SysDestroyFunc   destroy) {
   SysSList *slist;
@@ -46,6 +46,8 @@ SysSList* sys_slist_last(SysSList *list);
 SysUInt sys_slist_length(SysSList *list);
 SysSList* sys_slist_sort(SysSList *list, SysCompareFunc compare_func);
 SysSList* sys_slist_sort_with_data(SysSList *list, SysCompareDataFunc compare_func, SysPointer user_data);
+SysSList* sys_slist_insert_sorted_list(SysSList *list, SysSList *batch, SysCompareFunc func);
+SysSList* sys_slist_insert_sorted_list_with_data(SysSList *list, SysSList *batch, SysCompareDataFunc func, SysPointer user_data);
 SysPointer sys_slist_nth_data(SysSList *list, SysUInt n);
 
 void sys_clear_slist(SysSList **slist_ptr, SysDestroyFunc destroy);
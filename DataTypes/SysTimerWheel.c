@@ -0,0 +1,435 @@
+#include <System/DataTypes/SysTimerWheel.h>
+
+/**
+ * layout follows the classic cascading timer wheel:
+ * level n slot holds timers expiring within 64^(n+1) ticks,
+ * when level 0 wraps the next slot of level 1 is cascaded down.
+ * per level bitmaps let advance and next_deadline skip empty slots.
+ */
+
+#define WHEEL_SPAN(level) (((SysUInt64)1) << (SYS_TIMER_WHEEL_BITS * ((level) + 1)))
+#define WHEEL_INDEX(tick, level) (((tick) >> (SYS_TIMER_WHEEL_BITS * (level))) & SYS_TIMER_WHEEL_MASK)
+
+static SysUInt wheel_ctz(SysUInt64 bits) {
+#if defined(__GNUC__)
+  return (SysUInt)__builtin_ctzll(bits);
+#else
+  SysUInt n = 0;
+
+  while ((bits & 1) == 0) {
+    bits >>= 1;
+    n++;
+  }
+
+  return n;
+#endif
+}
+
+static void timer_link(SysTimer **slot, SysTimer *timer) {
+  timer->slot = slot;
+  timer->prev = NULL;
+  timer->next = *slot;
+
+  if (*slot) {
+    (*slot)->prev = timer;
+  }
+
+  *slot = timer;
+}
+
+static void wheel_unlink(SysTimerWheel *wheel, SysTimer *timer) {
+  SysTimer **slot = timer->slot;
+  SysSize offset;
+
+  if (timer->prev) {
+    timer->prev->next = timer->next;
+  } else {
+    *slot = timer->next;
+  }
+
+  if (timer->next) {
+    timer->next->prev = timer->prev;
+  }
+
+  timer->next = NULL;
+  timer->prev = NULL;
+  timer->slot = NULL;
+  wheel->count--;
+
+  if (slot != &wheel->expired && *slot == NULL) {
+    offset = slot - &wheel->slots[0][0];
+    wheel->bitmap[offset / SYS_TIMER_WHEEL_SIZE] &= ~(((SysUInt64)1) << (offset % SYS_TIMER_WHEEL_SIZE));
+  }
+}
+
+static void wheel_internal_add(SysTimerWheel *wheel, SysTimer *timer) {
+  SysUInt64 expires = timer->expires;
+  SysUInt64 delta;
+  SysUInt level;
+  SysUInt index;
+
+  if (expires < wheel->current) {
+    expires = wheel->current;
+  }
+
+  delta = expires - wheel->current;
+  if (delta >= WHEEL_SPAN(SYS_TIMER_WHEEL_LEVELS - 1)) {
+    /* too far away, park at the top level and re-add on cascade */
+    expires = wheel->current + WHEEL_SPAN(SYS_TIMER_WHEEL_LEVELS - 1) - 1;
+    delta = expires - wheel->current;
+  }
+
+  for (level = 0; level < SYS_TIMER_WHEEL_LEVELS - 1; level++) {
+    if (delta < WHEEL_SPAN(level)) {
+      break;
+    }
+  }
+
+  index = (SysUInt)WHEEL_INDEX(expires, level);
+  timer_link(&wheel->slots[level][index], timer);
+  wheel->bitmap[level] |= ((SysUInt64)1) << index;
+  wheel->count++;
+}
+
+static SysUInt wheel_cascade(SysTimerWheel *wheel, SysUInt level, SysUInt index) {
+  SysTimer *timer = wheel->slots[level][index];
+  SysTimer *next;
+
+  wheel->slots[level][index] = NULL;
+  wheel->bitmap[level] &= ~(((SysUInt64)1) << index);
+
+  while (timer) {
+    next = timer->next;
+    wheel->count--;
+    wheel_internal_add(wheel, timer);
+    timer = next;
+  }
+
+  return index;
+}
+
+static SysBool wheel_is_idle(SysTimerWheel *wheel) {
+  for (SysUInt i = 0; i < SYS_TIMER_WHEEL_LEVELS; i++) {
+    if (wheel->bitmap[i] != 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static SysUInt64 wheel_time_to_tick(SysTimerWheel *wheel, SysInt64 time) {
+  if (time <= (SysInt64)wheel->start_time) {
+    return 0;
+  }
+
+  return ((SysUInt64)time - wheel->start_time + wheel->resolution - 1) / wheel->resolution;
+}
+
+static SysInt64 wheel_tick_to_time(SysTimerWheel *wheel, SysUInt64 tick) {
+  return (SysInt64)(wheel->start_time + tick * wheel->resolution);
+}
+
+/* move all timers due at or before target tick into the expired list */
+static void wheel_collect(SysTimerWheel *wheel, SysUInt64 target) {
+  SysUInt64 tick;
+  SysUInt64 bits;
+  SysUInt index;
+  SysTimer *timer;
+
+  while (wheel->current <= target) {
+    if (wheel_is_idle(wheel)) {
+      wheel->current = target + 1;
+      break;
+    }
+
+    index = (SysUInt)(wheel->current & SYS_TIMER_WHEEL_MASK);
+    if (index == 0) {
+      for (SysUInt level = 1; level < SYS_TIMER_WHEEL_LEVELS; level++) {
+        if (wheel_cascade(wheel, level, (SysUInt)WHEEL_INDEX(wheel->current, level)) != 0) {
+          break;
+        }
+      }
+    }
+
+    bits = wheel->bitmap[0] >> index;
+    if (bits == 0) {
+      wheel->current = min((wheel->current | SYS_TIMER_WHEEL_MASK) + 1, target + 1);
+      continue;
+    }
+
+    index += wheel_ctz(bits);
+    tick = (wheel->current & ~((SysUInt64)SYS_TIMER_WHEEL_MASK)) + index;
+    if (tick > target) {
+      wheel->current = target + 1;
+      break;
+    }
+
+    while ((timer = wheel->slots[0][index]) != NULL) {
+      wheel_unlink(wheel, timer);
+      timer_link(&wheel->expired, timer);
+      wheel->count++;
+    }
+
+    wheel->current = tick + 1;
+  }
+}
+
+/* callbacks run unlocked, timers are taken one by one so cancel still works */
+static SysUInt wheel_run_expired(SysTimerWheel *wheel) {
+  SysTimer *timer;
+  SysUInt fired = 0;
+
+  while ((timer = wheel->expired) != NULL) {
+    wheel_unlink(wheel, timer);
+
+    sys_mutex_unlock(&wheel->mutex);
+    timer->func(timer, timer->user_data);
+    sys_mutex_lock(&wheel->mutex);
+
+    fired++;
+  }
+
+  return fired;
+}
+
+static SysInt64 wheel_next_deadline_unlocked(SysTimerWheel *wheel) {
+  SysUInt64 bits;
+  SysUInt index;
+
+  if (wheel->expired != NULL) {
+    return (SysInt64)wheel->start_time;
+  }
+
+  if (wheel_is_idle(wheel)) {
+    return -1;
+  }
+
+  index = (SysUInt)(wheel->current & SYS_TIMER_WHEEL_MASK);
+  if (index == 0) {
+    /* cascade pending, wake up to pull upper levels down */
+    return wheel_tick_to_time(wheel, wheel->current);
+  }
+
+  bits = wheel->bitmap[0] >> index;
+  if (bits == 0) {
+    return wheel_tick_to_time(wheel, (wheel->current | SYS_TIMER_WHEEL_MASK) + 1);
+  }
+
+  return wheel_tick_to_time(wheel, wheel->current + wheel_ctz(bits));
+}
+
+void sys_timer_init(SysTimer *timer, SysTimerFunc func, SysPointer user_data) {
+  sys_return_if_fail(timer != NULL);
+
+  timer->func = func;
+  timer->user_data = user_data;
+  timer->next = NULL;
+  timer->prev = NULL;
+  timer->slot = NULL;
+  timer->expires = 0;
+}
+
+SysBool sys_timer_is_pending(SysTimer *timer) {
+  sys_return_val_if_fail(timer != NULL, false);
+
+  return timer->slot != NULL;
+}
+
+SysTimerWheel *sys_timer_wheel_new(SysUInt64 resolution) {
+  SysTimerWheel *wheel = sys_new(SysTimerWheel, 1);
+
+  sys_timer_wheel_init(wheel, resolution);
+
+  return wheel;
+}
+
+void sys_timer_wheel_free(SysTimerWheel *wheel) {
+  sys_return_if_fail(wheel != NULL);
+
+  sys_timer_wheel_clear(wheel);
+  sys_free(wheel);
+}
+
+void sys_timer_wheel_init(SysTimerWheel *wheel, SysUInt64 resolution) {
+  sys_return_if_fail(wheel != NULL);
+  sys_return_if_fail(resolution > 0);
+
+  memset(wheel, 0, sizeof(SysTimerWheel));
+  sys_mutex_init(&wheel->mutex);
+  sys_cond_init(&wheel->cond);
+  wheel->resolution = resolution;
+  wheel->start_time = sys_get_monotonic_time();
+}
+
+void sys_timer_wheel_clear(SysTimerWheel *wheel) {
+  sys_return_if_fail(wheel != NULL);
+  sys_return_if_fail(wheel->waiting_threads == 0);
+
+  sys_mutex_lock(&wheel->mutex);
+
+  while (wheel->expired) {
+    wheel_unlink(wheel, wheel->expired);
+  }
+
+  for (SysUInt level = 0; level < SYS_TIMER_WHEEL_LEVELS; level++) {
+    for (SysUInt i = 0; i < SYS_TIMER_WHEEL_SIZE; i++) {
+      while (wheel->slots[level][i]) {
+        wheel_unlink(wheel, wheel->slots[level][i]);
+      }
+    }
+  }
+
+  sys_mutex_unlock(&wheel->mutex);
+
+  sys_mutex_clear(&wheel->mutex);
+  sys_cond_clear(&wheel->cond);
+}
+
+SysUInt sys_timer_wheel_get_length(SysTimerWheel *wheel) {
+  SysUInt count;
+
+  sys_return_val_if_fail(wheel != NULL, 0);
+
+  sys_mutex_lock(&wheel->mutex);
+  count = wheel->count;
+  sys_mutex_unlock(&wheel->mutex);
+
+  return count;
+}
+
+void sys_timer_wheel_add(SysTimerWheel *wheel, SysTimer *timer, SysInt64 end_time) {
+  sys_return_if_fail(wheel != NULL);
+  sys_return_if_fail(timer != NULL);
+  sys_return_if_fail(timer->func != NULL);
+
+  sys_mutex_lock(&wheel->mutex);
+
+  if (timer->slot) {
+    wheel_unlink(wheel, timer);
+  }
+
+  timer->expires = wheel_time_to_tick(wheel, end_time);
+  wheel_internal_add(wheel, timer);
+
+  /* the new timer may be earlier than what waiters sleep for */
+  if (wheel->waiting_threads > 0) {
+    sys_cond_broadcast(&wheel->cond);
+  }
+
+  sys_mutex_unlock(&wheel->mutex);
+}
+
+void sys_timer_wheel_add_timeout(SysTimerWheel *wheel, SysTimer *timer, SysUInt64 timeout) {
+  sys_timer_wheel_add(wheel, timer, (SysInt64)(sys_get_monotonic_time() + timeout));
+}
+
+SysBool sys_timer_wheel_cancel(SysTimerWheel *wheel, SysTimer *timer) {
+  SysBool pending;
+
+  sys_return_val_if_fail(wheel != NULL, false);
+  sys_return_val_if_fail(timer != NULL, false);
+
+  sys_mutex_lock(&wheel->mutex);
+
+  pending = timer->slot != NULL;
+  if (pending) {
+    wheel_unlink(wheel, timer);
+  }
+
+  sys_mutex_unlock(&wheel->mutex);
+
+  return pending;
+}
+
+SysInt64 sys_timer_wheel_next_deadline(SysTimerWheel *wheel) {
+  SysInt64 deadline;
+
+  sys_return_val_if_fail(wheel != NULL, -1);
+
+  sys_mutex_lock(&wheel->mutex);
+  deadline = wheel_next_deadline_unlocked(wheel);
+  sys_mutex_unlock(&wheel->mutex);
+
+  return deadline;
+}
+
+SysUInt sys_timer_wheel_advance(SysTimerWheel *wheel, SysInt64 now) {
+  SysUInt fired;
+
+  sys_return_val_if_fail(wheel != NULL, 0);
+
+  sys_mutex_lock(&wheel->mutex);
+
+  if (now >= (SysInt64)wheel->start_time) {
+    wheel_collect(wheel, ((SysUInt64)now - wheel->start_time) / wheel->resolution);
+  }
+
+  fired = wheel_run_expired(wheel);
+
+  sys_mutex_unlock(&wheel->mutex);
+
+  return fired;
+}
+
+/**
+ * sys_timer_wheel_wait:
+ * @wheel: a #SysTimerWheel
+ * @end_time: monotonic time to give up at, -1 waits without limit
+ *
+ * Sleeps until the next timer is due, @end_time has passed or
+ * sys_timer_wheel_wakeup() was called, then runs expired callbacks.
+ *
+ * Returns: number of callbacks that ran
+ */
+SysUInt sys_timer_wheel_wait(SysTimerWheel *wheel, SysInt64 end_time) {
+  SysInt64 now;
+  SysInt64 wake;
+  SysUInt fired;
+
+  sys_return_val_if_fail(wheel != NULL, 0);
+
+  sys_mutex_lock(&wheel->mutex);
+
+  while (true) {
+    now = (SysInt64)sys_get_monotonic_time();
+    wheel_collect(wheel, ((SysUInt64)now - wheel->start_time) / wheel->resolution);
+
+    if (wheel->expired != NULL || wheel->interrupted) {
+      break;
+    }
+
+    if (end_time >= 0 && now >= end_time) {
+      break;
+    }
+
+    wake = wheel_next_deadline_unlocked(wheel);
+    if (wake < 0 || (end_time >= 0 && end_time < wake)) {
+      wake = end_time;
+    }
+
+    wheel->waiting_threads++;
+    if (wake < 0) {
+      sys_cond_wait(&wheel->cond, &wheel->mutex);
+    } else {
+      sys_cond_wait_until(&wheel->cond, &wheel->mutex, wake);
+    }
+    wheel->waiting_threads--;
+  }
+
+  wheel->interrupted = false;
+  fired = wheel_run_expired(wheel);
+
+  sys_mutex_unlock(&wheel->mutex);
+
+  return fired;
+}
+
+void sys_timer_wheel_wakeup(SysTimerWheel *wheel) {
+  sys_return_if_fail(wheel != NULL);
+
+  sys_mutex_lock(&wheel->mutex);
+  wheel->interrupted = true;
+  sys_cond_broadcast(&wheel->cond);
+  sys_mutex_unlock(&wheel->mutex);
+}
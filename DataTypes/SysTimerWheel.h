@@ -0,0 +1,77 @@
+#ifndef __SYS_TIMER_WHEEL_H__
+#define __SYS_TIMER_WHEEL_H__
+
+#include <System/Fundamental/SysCommonCore.h>
+#include <System/Platform/Common/SysThread.h>
+
+SYS_BEGIN_DECLS
+
+/**
+ * SysTimerWheel:
+ *
+ * Hierarchical hashed timer wheel, SYS_TIMER_WHEEL_LEVELS levels of
+ * SYS_TIMER_WHEEL_SIZE slots, time is counted in ticks of @resolution
+ * microseconds on the sys_get_monotonic_time() clock.
+ *
+ * add and cancel are O(1). Expired timers are collected lazily when
+ * the wheel is advanced, callbacks run without the wheel lock held so
+ * they may add or cancel timers. All functions are MT safe.
+ */
+
+#define SYS_TIMER_WHEEL_BITS 6
+#define SYS_TIMER_WHEEL_SIZE (1 << SYS_TIMER_WHEEL_BITS)
+#define SYS_TIMER_WHEEL_MASK (SYS_TIMER_WHEEL_SIZE - 1)
+#define SYS_TIMER_WHEEL_LEVELS 4
+
+typedef struct _SysTimer SysTimer;
+typedef struct _SysTimerWheel SysTimerWheel;
+
+typedef void (*SysTimerFunc) (SysTimer *timer, SysPointer user_data);
+
+struct _SysTimer {
+  SysTimerFunc func;
+  SysPointer user_data;
+
+  /* <private> */
+  SysTimer *next;
+  SysTimer *prev;
+  SysTimer **slot;
+  SysUInt64 expires;
+};
+
+struct _SysTimerWheel {
+  /* <private> */
+  SysMutex mutex;
+  SysCond cond;
+  SysUInt64 resolution;
+  SysUInt64 start_time;
+  SysUInt64 current;
+  SysUInt count;
+  SysUInt waiting_threads;
+  SysBool interrupted;
+  SysTimer *expired;
+  SysUInt64 bitmap[SYS_TIMER_WHEEL_LEVELS];
+  SysTimer *slots[SYS_TIMER_WHEEL_LEVELS][SYS_TIMER_WHEEL_SIZE];
+};
+
+SYS_API void sys_timer_init(SysTimer *timer, SysTimerFunc func, SysPointer user_data);
+SYS_API SysBool sys_timer_is_pending(SysTimer *timer);
+
+SYS_API SysTimerWheel *sys_timer_wheel_new(SysUInt64 resolution);
+SYS_API void sys_timer_wheel_free(SysTimerWheel *wheel);
+SYS_API void sys_timer_wheel_init(SysTimerWheel *wheel, SysUInt64 resolution);
+SYS_API void sys_timer_wheel_clear(SysTimerWheel *wheel);
+SYS_API SysUInt sys_timer_wheel_get_length(SysTimerWheel *wheel);
+
+SYS_API void sys_timer_wheel_add(SysTimerWheel *wheel, SysTimer *timer, SysInt64 end_time);
+SYS_API void sys_timer_wheel_add_timeout(SysTimerWheel *wheel, SysTimer *timer, SysUInt64 timeout);
+SYS_API SysBool sys_timer_wheel_cancel(SysTimerWheel *wheel, SysTimer *timer);
+
+SYS_API SysInt64 sys_timer_wheel_next_deadline(SysTimerWheel *wheel);
+SYS_API SysUInt sys_timer_wheel_advance(SysTimerWheel *wheel, SysInt64 now);
+SYS_API SysUInt sys_timer_wheel_wait(SysTimerWheel *wheel, SysInt64 end_time);
+SYS_API void sys_timer_wheel_wakeup(SysTimerWheel *wheel);
+
+SYS_END_DECLS
+
+#endif
@@ -15,6 +15,7 @@ struct _SysTree {
   SysPointer          key_compare_data;
   SysUInt             nnodes;
   SysInt              ref_count;
+  SysBool             counted;
 };
 
 struct _SysTreeNode {
@@ -25,6 +26,7 @@ struct _SysTreeNode {
   SysInt8      balance;
   SysUInt8     left_child;
   SysUInt8     right_child;
+  SysUInt      size;
 };
 
 
@@ -54,6 +56,11 @@ static SysTreeNode *sys_tree_node_search (SysTreeNode *node,
                                       const SysPointer data);
 static SysTreeNode* sys_tree_node_rotate_left           (SysTreeNode     *node);
 static SysTreeNode* sys_tree_node_rotate_right          (SysTreeNode     *node);
+static SysUInt      sys_tree_node_count                 (SysTreeNode     *node);
+static SysUInt      sys_tree_node_recount               (SysTreeNode     *node);
+static void         sys_tree_link_sorted                (SysTree         *tree,
+                                                     SysTreeNode    **nodes,
+                                                     SysUInt          n);
 
 static SysTreeNode* sys_tree_node_new (SysPointer key,
                  SysPointer value) {
@@ -66,6 +73,7 @@ static SysTreeNode* sys_tree_node_new (SysPointer key,
   node->right_child = false;
   node->key = key;
   node->value = value;
+  node->size = 1;
 
   return node;
 }
@@ -101,10 +109,69 @@ SysTree* sys_tree_new_full (SysCompareDataFunc key_compare_func,
   tree->key_compare_data   = key_compare_data;
   tree->nnodes             = 0;
   tree->ref_count          = 1;
+  tree->counted            = false;
   
   return tree;
 }
 
+/**
+ * sys_tree_new_from_sorted:
+ * @key_compare_func: qsort()-style comparison function
+ * @key_compare_data: data to pass to comparison function
+ * @key_destroy_func: (nullable): a function to free the memory allocated for the key
+ * @value_destroy_func: (nullable): a function to free the memory allocated for the value
+ * @keys: @n keys in strictly ascending order
+ * @values: (nullable): @n values, or %NULL for all %NULL values
+ * @n: number of entries
+ *
+ * Creates a perfectly balanced tree in O(n) without any comparison
+ * beyond checking the order of @keys. If @keys are not strictly
+ * ascending the entries are inserted one by one instead.
+ *
+ * Returns: a newly allocated #SysTree
+ */
+SysTree* sys_tree_new_from_sorted (SysCompareDataFunc key_compare_func,
+                 SysPointer         key_compare_data,
+                 SysDestroyFunc   key_destroy_func,
+                 SysDestroyFunc   value_destroy_func,
+                 SysPointer        *keys,
+                 SysPointer        *values,
+                 SysUInt            n) {
+  SysTree *tree;
+  SysTreeNode **nodes;
+  SysUInt i;
+
+  sys_return_val_if_fail (key_compare_func != NULL, NULL);
+  sys_return_val_if_fail (keys != NULL || n == 0, NULL);
+
+  tree = sys_tree_new_full (key_compare_func, key_compare_data,
+                          key_destroy_func, value_destroy_func);
+
+  for (i = 1; i < n; i++) {
+      if (key_compare_func (keys[i - 1], keys[i], key_compare_data) >= 0)
+        break;
+    }
+
+  if (i < n) {
+      for (i = 0; i < n; i++)
+        sys_tree_insert_internal (tree, keys[i], values ? values[i] : NULL, false);
+
+      return tree;
+    }
+
+  if (n == 0)
+    return tree;
+
+  nodes = sys_new (SysTreeNode *, n);
+  for (i = 0; i < n; i++)
+    nodes[i] = sys_tree_node_new (keys[i], values ? values[i] : NULL);
+
+  sys_tree_link_sorted (tree, nodes, n);
+  sys_free (nodes);
+
+  return tree;
+}
+
 SysTreeNode* sys_tree_node_first (SysTree *tree) {
   SysTreeNode *tmp;
 
@@ -232,6 +299,80 @@ void sys_tree_remove_all (SysTree *tree) {
 #endif
 }
 
+/**
+ * sys_tree_merge:
+ * @tree: a #SysTree
+ * @other: a #SysTree using the same comparison and destroy functions
+ *
+ * Moves every entry of @other into @tree, leaving @other empty.
+ * The nodes are merged linearly and relinked into a balanced tree,
+ * O(n + m) instead of inserting @other key by key. For keys present
+ * in both trees the value from @other wins and its key is freed,
+ * as sys_tree_insert() would do.
+ */
+void sys_tree_merge (SysTree *tree,
+              SysTree *other) {
+  SysTreeNode **nodes;
+  SysTreeNode *a, *b, *next;
+  SysUInt n;
+  SysInt cmp;
+
+  sys_return_if_fail (tree != NULL);
+  sys_return_if_fail (other != NULL);
+  sys_return_if_fail (tree != other);
+
+  if (!other->root)
+    return;
+
+  nodes = sys_new (SysTreeNode *, tree->nnodes + other->nnodes);
+  a = sys_tree_node_first (tree);
+  b = sys_tree_node_first (other);
+  n = 0;
+
+  while (a && b) {
+      cmp = tree->key_compare (a->key, b->key, tree->key_compare_data);
+
+      if (cmp < 0) {
+          nodes[n++] = a;
+          a = sys_tree_node_next (a);
+        }
+      else if (cmp > 0) {
+          nodes[n++] = b;
+          b = sys_tree_node_next (b);
+        }
+      else {
+          next = sys_tree_node_next (b);
+
+          if (tree->value_destroy_func)
+            tree->value_destroy_func (a->value);
+          if (tree->key_destroy_func)
+            tree->key_destroy_func (b->key);
+
+          a->value = b->value;
+          sys_slice_free (SysTreeNode, b);
+
+          nodes[n++] = a;
+          a = sys_tree_node_next (a);
+          b = next;
+        }
+    }
+
+  for (; a; a = sys_tree_node_next (a))
+    nodes[n++] = a;
+  for (; b; b = sys_tree_node_next (b))
+    nodes[n++] = b;
+
+  other->root = NULL;
+  other->nnodes = 0;
+
+  sys_tree_link_sorted (tree, nodes, n);
+  sys_free (nodes);
+
+#ifdef SYS_TREE_DEBUG
+  sys_tree_node_check (tree->root);
+#endif
+}
+
 SysTree* sys_tree_ref (SysTree *tree) {
   sys_return_val_if_fail (tree != NULL, NULL);
 
@@ -303,7 +444,7 @@ static SysTreeNode* sys_tree_insert_internal (SysTree    *tree,
                         SysBool  replace) {
   SysTreeNode *node, *retnode;
   SysTreeNode *path[MAX_SYSTREE_HEIGHT];
-  SysInt idx;
+  SysInt idx, i;
 
   sys_return_val_if_fail (tree != NULL, NULL);
 
@@ -382,6 +523,12 @@ static SysTreeNode* sys_tree_insert_internal (SysTree    *tree,
         }
     }
 
+  if (tree->counted) {
+      node->size++;
+      for (i = 1; i < idx; i++)
+        path[i]->size++;
+    }
+
   /* Restore balance. This is the goodness of a non-recursive
    * implementation, when we are done with balancing we 'break'
    * the loop and we are done.
@@ -450,7 +597,7 @@ static SysBool sys_tree_remove_internal (SysTree         *tree,
                         SysBool       steal) {
   SysTreeNode *node, *parent, *balance;
   SysTreeNode *path[MAX_SYSTREE_HEIGHT];
-  SysInt idx;
+  SysInt idx, i;
   SysBool left_node;
 
   sys_return_val_if_fail (tree != NULL, false);
@@ -483,6 +630,11 @@ static SysBool sys_tree_remove_internal (SysTree         *tree,
         }
     }
 
+  if (tree->counted) {
+      for (i = 1; i < idx; i++)
+        path[i]->size--;
+    }
+
   /* The following code is almost equal to sys_tree_remove_node,
    * except that we do not have to call sys_tree_node_parent.
    */
@@ -547,6 +699,8 @@ static SysBool sys_tree_remove_internal (SysTree         *tree,
           /* path[idx] == parent */
           /* find the immediately next node (and its parent) */
           while (next->left_child) {
+              if (tree->counted)
+                next->size--;
               path[++idx] = nextp = next;
               next = next->left;
             }
@@ -577,6 +731,7 @@ static SysBool sys_tree_remove_internal (SysTree         *tree,
           next->left_child = true;
           next->left = node->left;
           next->balance = node->balance;
+          next->size = node->size - 1;
 
           if (!parent)
             tree->root = next;
@@ -857,6 +1012,123 @@ SysInt sys_tree_nnodes (SysTree *tree) {
   return tree->nnodes;
 }
 
+/**
+ * sys_tree_set_order_statistics:
+ * @tree: a #SysTree
+ * @enabled: whether to maintain subtree sizes
+ *
+ * Subtree sizes live in padding of #SysTreeNode, so they cost no
+ * memory, only a counter update per level on insert and remove.
+ * Enabling recounts the whole tree once, O(n). Required by
+ * sys_tree_nth(), sys_tree_rank() and sys_tree_count_range().
+ */
+void sys_tree_set_order_statistics (SysTree *tree,
+                             SysBool  enabled) {
+  sys_return_if_fail (tree != NULL);
+
+  if (enabled && !tree->counted && tree->root)
+    sys_tree_node_recount (tree->root);
+
+  tree->counted = enabled;
+}
+
+/**
+ * sys_tree_nth:
+ * @tree: a #SysTree with order statistics enabled
+ * @n: zero based position in key order
+ *
+ * Finds the @n-th smallest key in O(log n).
+ *
+ * Returns: (nullable) (transfer none): the node, or %NULL if @n is out of range
+ */
+SysTreeNode* sys_tree_nth (SysTree *tree,
+            SysUInt  n) {
+  SysTreeNode *node;
+  SysUInt lsize;
+
+  sys_return_val_if_fail (tree != NULL, NULL);
+  sys_return_val_if_fail (tree->counted, NULL);
+
+  if (n >= tree->nnodes)
+    return NULL;
+
+  node = tree->root;
+  while (1) {
+      lsize = node->left_child ? node->left->size : 0;
+
+      if (n < lsize)
+        node = node->left;
+      else if (n == lsize)
+        return node;
+      else {
+          n -= lsize + 1;
+          node = node->right;
+        }
+    }
+}
+
+/**
+ * sys_tree_rank:
+ * @tree: a #SysTree with order statistics enabled
+ * @key: the key to rank, need not be in the tree
+ *
+ * Returns: the number of keys smaller than @key, O(log n)
+ */
+SysUInt sys_tree_rank (SysTree         *tree,
+             const SysPointer  key) {
+  SysTreeNode *node;
+  SysUInt rank;
+  SysInt cmp;
+
+  sys_return_val_if_fail (tree != NULL, 0);
+  sys_return_val_if_fail (tree->counted, 0);
+
+  node = tree->root;
+  if (!node)
+    return 0;
+
+  rank = 0;
+  while (1) {
+      cmp = tree->key_compare (key, node->key, tree->key_compare_data);
+      if (cmp <= 0) {
+          if (!node->left_child)
+            return rank;
+
+          node = node->left;
+        }
+      else {
+          rank += (node->left_child ? node->left->size : 0) + 1;
+
+          if (!node->right_child)
+            return rank;
+
+          node = node->right;
+        }
+    }
+}
+
+/**
+ * sys_tree_count_range:
+ * @tree: a #SysTree with order statistics enabled
+ * @lo: lower bound, inclusive
+ * @hi: upper bound, exclusive
+ *
+ * Returns: the number of keys in [@lo, @hi), O(log n)
+ */
+SysUInt sys_tree_count_range (SysTree         *tree,
+                    const SysPointer  lo,
+                    const SysPointer  hi) {
+  SysUInt rlo, rhi;
+
+  sys_return_val_if_fail (tree != NULL, 0);
+  sys_return_val_if_fail (tree->counted, 0);
+
+  rlo = sys_tree_rank (tree, lo);
+  rhi = sys_tree_rank (tree, hi);
+
+  return rhi > rlo ? rhi - rlo : 0;
+}
+
 static SysTreeNode* sys_tree_node_balance (SysTreeNode *node) {
   if (node->balance < -1) {
       if (node->left->balance > 0)
@@ -900,6 +1172,81 @@ static SysTreeNode* sys_tree_find_node (SysTree        *tree,
     }
 }
 
+/* subtree size from the children, which must already be up to date */
+static SysUInt sys_tree_node_count (SysTreeNode *node) {
+  SysUInt size = 1;
+
+  if (node->left_child)
+    size += node->left->size;
+  if (node->right_child)
+    size += node->right->size;
+
+  return size;
+}
+
+static SysUInt sys_tree_node_recount (SysTreeNode *node) {
+  node->size = 1;
+
+  if (node->left_child)
+    node->size += sys_tree_node_recount (node->left);
+  if (node->right_child)
+    node->size += sys_tree_node_recount (node->right);
+
+  return node->size;
+}
+
+static SysTreeNode* sys_tree_node_build (SysTreeNode **nodes,
+                   SysUInt       lo,
+                   SysUInt       hi,
+                   SysInt       *height) {
+  SysTreeNode *node, *left, *right;
+  SysInt lheight, rheight;
+  SysUInt mid;
+
+  if (lo >= hi) {
+      *height = 0;
+      return NULL;
+    }
+
+  mid = lo + (hi - lo) / 2;
+  node = nodes[mid];
+
+  left = sys_tree_node_build (nodes, lo, mid, &lheight);
+  right = sys_tree_node_build (nodes, mid + 1, hi, &rheight);
+
+  node->left_child = left != NULL;
+  if (left)
+    node->left = left;
+
+  node->right_child = right != NULL;
+  if (right)
+    node->right = right;
+
+  node->balance = (SysInt8)(rheight - lheight);
+  node->size = hi - lo;
+  *height = max(lheight, rheight) + 1;
+
+  return node;
+}
+
+/* relinks @n nodes in key order into a balanced tree, threads included */
+static void sys_tree_link_sorted (SysTree      *tree,
+                   SysTreeNode **nodes,
+                   SysUInt       n) {
+  SysInt height;
+  SysUInt i;
+
+  tree->root = sys_tree_node_build (nodes, 0, n, &height);
+  tree->nnodes = n;
+
+  for (i = 0; i < n; i++) {
+      if (!nodes[i]->left_child)
+        nodes[i]->left = i > 0 ? nodes[i - 1] : NULL;
+      if (!nodes[i]->right_child)
+        nodes[i]->right = i + 1 < n ? nodes[i + 1] : NULL;
+    }
+}
+
 static SysInt sys_tree_node_pre_order (SysTreeNode     *node,
                        SysTraverseFunc  traverse_func,
                        SysPointer       data) {
@@ -999,6 +1346,9 @@ static SysTreeNode* sys_tree_node_rotate_left (SysTreeNode *node) {
     }
   right->left = node;
 
+  node->size = sys_tree_node_count (node);
+  right->size = sys_tree_node_count (right);
+
   a_bal = node->balance;
   b_bal = right->balance;
 
@@ -1036,6 +1386,9 @@ static SysTreeNode* sys_tree_node_rotate_right (SysTreeNode *node) {
   }
   left->right = node;
 
+  node->size = sys_tree_node_count (node);
+  left->size = sys_tree_node_count (left);
+
   a_bal = node->balance;
   b_bal = left->balance;
 
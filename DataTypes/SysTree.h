@@ -23,6 +23,13 @@ SYS_API SysTree*   sys_tree_new_full        (SysCompareDataFunc  key_compare_fun
                                  SysPointer          key_compare_data,
                                  SysDestroyFunc    key_destroy_func,
                                  SysDestroyFunc    value_destroy_func);
+SYS_API SysTree*   sys_tree_new_from_sorted (SysCompareDataFunc  key_compare_func,
+                                 SysPointer          key_compare_data,
+                                 SysDestroyFunc    key_destroy_func,
+                                 SysDestroyFunc    value_destroy_func,
+                                 SysPointer         *keys,
+                                 SysPointer         *values,
+                                 SysUInt             n);
 SYS_API SysTreeNode *sys_tree_node_first (SysTree *tree);
 SYS_API SysTreeNode *sys_tree_node_last (SysTree *tree);
 SYS_API SysTreeNode *sys_tree_node_previous (SysTreeNode *node);
@@ -46,6 +53,8 @@ SYS_API SysBool sys_tree_remove          (SysTree            *tree,
                                  const SysPointer     key);
 
 SYS_API void     sys_tree_remove_all      (SysTree            *tree);
+SYS_API void     sys_tree_merge           (SysTree            *tree,
+                                 SysTree            *other);
 
 SYS_API SysBool sys_tree_steal           (SysTree            *tree,
                                  const SysPointer     key);
@@ -79,6 +88,16 @@ SYS_API SysTreeNode *sys_tree_upper_bound (SysTree *tree,
 SYS_API SysInt     sys_tree_height          (SysTree            *tree);
 SYS_API SysInt     sys_tree_nnodes          (SysTree            *tree);
 
+SYS_API void     sys_tree_set_order_statistics (SysTree       *tree,
+                                 SysBool             enabled);
+SYS_API SysTreeNode *sys_tree_nth (SysTree *tree,
+                               SysUInt n);
+SYS_API SysUInt    sys_tree_rank            (SysTree            *tree,
+                                 const SysPointer     key);
+SYS_API SysUInt    sys_tree_count_range     (SysTree            *tree,
+                                 const SysPointer     lo,
+                                 const SysPointer     hi);
+
 SYS_END_DECLS
 
 #endif
@@ -0,0 +1,474 @@
+#include <System/DataTypes/SysUQueue.h>
+
+/**
+ * unrolled queue: head block fills from back to front,
+ * tail block fills from front to back, one empty block is
+ * kept in spare to avoid malloc when length oscillates
+ * around a block boundary.
+ */
+
+static SysUQueueBlock *uqueue_block_new(SysUQueue *queue, SysUInt pos) {
+  SysUQueueBlock *block = queue->spare;
+
+  if (block) {
+    queue->spare = NULL;
+  } else {
+    block = sys_slice_new(SysUQueueBlock);
+  }
+
+  block->next = NULL;
+  block->prev = NULL;
+  block->begin = pos;
+  block->end = pos;
+
+  return block;
+}
+
+static void uqueue_block_release(SysUQueue *queue, SysUQueueBlock *block) {
+  if (block->prev) {
+    block->prev->next = block->next;
+  } else {
+    queue->head = block->next;
+  }
+
+  if (block->next) {
+    block->next->prev = block->prev;
+  } else {
+    queue->tail = block->prev;
+  }
+
+  if (queue->spare == NULL) {
+    queue->spare = block;
+  } else {
+    sys_slice_free(SysUQueueBlock, block);
+  }
+}
+
+static void uqueue_block_insert_after(SysUQueue *queue, SysUQueueBlock *sibling, SysUQueueBlock *block) {
+  block->prev = sibling;
+
+  if (sibling) {
+    block->next = sibling->next;
+    sibling->next = block;
+  } else {
+    block->next = queue->head;
+    queue->head = block;
+  }
+
+  if (block->next) {
+    block->next->prev = block;
+  } else {
+    queue->tail = block;
+  }
+}
+
+static void uqueue_free_blocks(SysUQueue *queue) {
+  SysUQueueBlock *block = queue->head;
+  SysUQueueBlock *next;
+
+  while (block) {
+    next = block->next;
+    sys_slice_free(SysUQueueBlock, block);
+    block = next;
+  }
+
+  if (queue->spare) {
+    sys_slice_free(SysUQueueBlock, queue->spare);
+  }
+}
+
+/* find block holding nth element, walk from the nearest end */
+static SysUQueueBlock *uqueue_locate(SysUQueue *queue, SysUInt n, SysUInt *offset) {
+  SysUQueueBlock *block;
+  SysUInt count;
+
+  if (n > queue->length / 2) {
+    n = queue->length - n - 1;
+
+    for (block = queue->tail; block; block = block->prev) {
+      count = block->end - block->begin;
+      if (n < count) {
+        *offset = block->end - n - 1;
+        return block;
+      }
+
+      n -= count;
+    }
+  } else {
+    for (block = queue->head; block; block = block->next) {
+      count = block->end - block->begin;
+      if (n < count) {
+        *offset = block->begin + n;
+        return block;
+      }
+
+      n -= count;
+    }
+  }
+
+  sys_assert(false && "uqueue length out of sync.");
+  return NULL;
+}
+
+static void uqueue_remove_at(SysUQueue *queue, SysUQueueBlock *block, SysUInt offset) {
+  if (offset - block->begin < block->end - offset - 1) {
+    memmove(&block->data[block->begin + 1], &block->data[block->begin],
+        (offset - block->begin) * sizeof(SysPointer));
+    block->begin++;
+
+  } else {
+    memmove(&block->data[offset], &block->data[offset + 1],
+        (block->end - offset - 1) * sizeof(SysPointer));
+    block->end--;
+  }
+
+  if (block->begin == block->end) {
+    uqueue_block_release(queue, block);
+  }
+
+  queue->length--;
+}
+
+SysUQueue* sys_uqueue_new(void) {
+  return sys_slice_new0(SysUQueue);
+}
+
+void sys_uqueue_free(SysUQueue *queue) {
+  sys_return_if_fail(queue != NULL);
+
+  uqueue_free_blocks(queue);
+  sys_slice_free(SysUQueue, queue);
+}
+
+void sys_uqueue_free_full(SysUQueue *queue, SysDestroyFunc free_func) {
+  sys_return_if_fail(queue != NULL);
+
+  sys_uqueue_foreach(queue, block, i) {
+    free_func(block->data[i]);
+  }
+
+  sys_uqueue_free(queue);
+}
+
+void sys_uqueue_init(SysUQueue *queue) {
+  sys_return_if_fail(queue != NULL);
+
+  queue->head = queue->tail = NULL;
+  queue->spare = NULL;
+  queue->length = 0;
+}
+
+void sys_uqueue_clear(SysUQueue *queue) {
+  sys_return_if_fail(queue != NULL);
+
+  uqueue_free_blocks(queue);
+  sys_uqueue_init(queue);
+}
+
+SysBool sys_uqueue_is_empty(SysUQueue *queue) {
+  sys_return_val_if_fail(queue != NULL, true);
+
+  return queue->length == 0;
+}
+
+SysUInt sys_uqueue_get_length(SysUQueue *queue) {
+  sys_return_val_if_fail(queue != NULL, 0);
+
+  return queue->length;
+}
+
+void sys_uqueue_reverse(SysUQueue *queue) {
+  SysUQueueBlock *block;
+  SysUQueueBlock *tmp;
+  SysPointer data;
+  SysUInt i, j;
+
+  sys_return_if_fail(queue != NULL);
+
+  block = queue->head;
+  while (block) {
+    for (i = block->begin, j = block->end - 1; i < j; i++, j--) {
+      data = block->data[i];
+      block->data[i] = block->data[j];
+      block->data[j] = data;
+    }
+
+    tmp = block->next;
+    block->next = block->prev;
+    block->prev = tmp;
+    block = tmp;
+  }
+
+  tmp = queue->head;
+  queue->head = queue->tail;
+  queue->tail = tmp;
+}
+
+SysUQueue *sys_uqueue_copy(SysUQueue *queue) {
+  SysUQueue *result;
+
+  sys_return_val_if_fail(queue != NULL, NULL);
+
+  result = sys_uqueue_new();
+
+  sys_uqueue_foreach(queue, block, i) {
+    sys_uqueue_push_tail(result, block->data[i]);
+  }
+
+  return result;
+}
+
+void sys_uqueue_foreach_func(SysUQueue *queue, SysFunc func, SysPointer user_data) {
+  sys_return_if_fail(queue != NULL);
+  sys_return_if_fail(func != NULL);
+
+  sys_uqueue_foreach(queue, block, i) {
+    func(block->data[i], user_data);
+  }
+}
+
+SysInt sys_uqueue_find_custom(SysUQueue *queue,
+    const SysPointer  data,
+    SysCompareFunc   func) {
+  SysInt n = 0;
+
+  sys_return_val_if_fail(queue != NULL, -1);
+  sys_return_val_if_fail(func != NULL, -1);
+
+  sys_uqueue_foreach(queue, block, i) {
+    if (!func(block->data[i], data)) {
+      return n;
+    }
+
+    n++;
+  }
+
+  return -1;
+}
+
+void sys_uqueue_push_head(SysUQueue *queue, SysPointer  data) {
+  SysUQueueBlock *block;
+
+  sys_return_if_fail(queue != NULL);
+
+  block = queue->head;
+  if (block == NULL || block->begin == 0) {
+    block = uqueue_block_new(queue, SYS_UQUEUE_BLOCK_SIZE);
+    uqueue_block_insert_after(queue, NULL, block);
+  }
+
+  block->data[--block->begin] = data;
+  queue->length++;
+}
+
+void sys_uqueue_push_tail(SysUQueue *queue, SysPointer  data) {
+  SysUQueueBlock *block;
+
+  sys_return_if_fail(queue != NULL);
+
+  block = queue->tail;
+  if (block == NULL || block->end == SYS_UQUEUE_BLOCK_SIZE) {
+    block = uqueue_block_new(queue, 0);
+    uqueue_block_insert_after(queue, queue->tail, block);
+  }
+
+  block->data[block->end++] = data;
+  queue->length++;
+}
+
+void sys_uqueue_push_nth(SysUQueue *queue, SysPointer  data, SysUInt n) {
+  SysUQueueBlock *block;
+  SysUQueueBlock *nblock;
+  SysUInt offset;
+  SysUInt half;
+
+  sys_return_if_fail(queue != NULL);
+
+  if (n >= queue->length) {
+    sys_uqueue_push_tail(queue, data);
+    return;
+  }
+
+  if (n == 0) {
+    sys_uqueue_push_head(queue, data);
+    return;
+  }
+
+  block = uqueue_locate(queue, n, &offset);
+
+  if (block->end - block->begin == SYS_UQUEUE_BLOCK_SIZE) {
+    /* split full block, upper half moves to a new block */
+    half = SYS_UQUEUE_BLOCK_SIZE / 2;
+    nblock = uqueue_block_new(queue, 0);
+    memcpy(nblock->data, &block->data[half], (SYS_UQUEUE_BLOCK_SIZE - half) * sizeof(SysPointer));
+    nblock->end = SYS_UQUEUE_BLOCK_SIZE - half;
+    block->end = half;
+    uqueue_block_insert_after(queue, block, nblock);
+
+    if (offset >= half) {
+      block = nblock;
+      offset -= half;
+    }
+  }
+
+  if (block->end < SYS_UQUEUE_BLOCK_SIZE) {
+    memmove(&block->data[offset + 1], &block->data[offset],
+        (block->end - offset) * sizeof(SysPointer));
+    block->end++;
+
+  } else {
+    memmove(&block->data[block->begin - 1], &block->data[block->begin],
+        (offset - block->begin) * sizeof(SysPointer));
+    block->begin--;
+    offset--;
+  }
+
+  block->data[offset] = data;
+  queue->length++;
+}
+
+SysPointer sys_uqueue_pop_head(SysUQueue *queue) {
+  SysUQueueBlock *block;
+  SysPointer data;
+
+  sys_return_val_if_fail(queue != NULL, NULL);
+
+  block = queue->head;
+  if (block == NULL) {
+    return NULL;
+  }
+
+  data = block->data[block->begin++];
+  if (block->begin == block->end) {
+    uqueue_block_release(queue, block);
+  }
+  queue->length--;
+
+  return data;
+}
+
+SysPointer sys_uqueue_pop_tail(SysUQueue *queue) {
+  SysUQueueBlock *block;
+  SysPointer data;
+
+  sys_return_val_if_fail(queue != NULL, NULL);
+
+  block = queue->tail;
+  if (block == NULL) {
+    return NULL;
+  }
+
+  data = block->data[--block->end];
+  if (block->begin == block->end) {
+    uqueue_block_release(queue, block);
+  }
+  queue->length--;
+
+  return data;
+}
+
+SysPointer sys_uqueue_pop_nth(SysUQueue *queue, SysUInt n) {
+  SysUQueueBlock *block;
+  SysUInt offset;
+  SysPointer data;
+
+  sys_return_val_if_fail(queue != NULL, NULL);
+
+  if (n >= queue->length)
+    return NULL;
+
+  block = uqueue_locate(queue, n, &offset);
+  data = block->data[offset];
+  uqueue_remove_at(queue, block, offset);
+
+  return data;
+}
+
+SysPointer sys_uqueue_peek_head(SysUQueue *queue) {
+  sys_return_val_if_fail(queue != NULL, NULL);
+
+  return queue->head ? queue->head->data[queue->head->begin] : NULL;
+}
+
+SysPointer sys_uqueue_peek_tail(SysUQueue *queue) {
+  sys_return_val_if_fail(queue != NULL, NULL);
+
+  return queue->tail ? queue->tail->data[queue->tail->end - 1] : NULL;
+}
+
+SysPointer sys_uqueue_peek_nth(SysUQueue *queue, SysUInt n) {
+  SysUQueueBlock *block;
+  SysUInt offset;
+
+  sys_return_val_if_fail(queue != NULL, NULL);
+
+  if (n >= queue->length)
+    return NULL;
+
+  block = uqueue_locate(queue, n, &offset);
+
+  return block->data[offset];
+}
+
+SysInt sys_uqueue_index(SysUQueue *queue, const SysPointer  data) {
+  SysInt n = 0;
+
+  sys_return_val_if_fail(queue != NULL, -1);
+
+  sys_uqueue_foreach(queue, block, i) {
+    if (block->data[i] == data) {
+      return n;
+    }
+
+    n++;
+  }
+
+  return -1;
+}
+
+SysBool sys_uqueue_remove(SysUQueue *queue, const SysPointer  data) {
+  sys_return_val_if_fail(queue != NULL, false);
+
+  sys_uqueue_foreach(queue, block, i) {
+    if (block->data[i] == data) {
+      uqueue_remove_at(queue, block, i);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+SysUInt sys_uqueue_remove_all(SysUQueue *queue, const SysPointer  data) {
+  SysUQueueBlock *block;
+  SysUQueueBlock *next;
+  SysUInt old_length;
+  SysUInt w;
+
+  sys_return_val_if_fail(queue != NULL, 0);
+
+  old_length = queue->length;
+
+  block = queue->head;
+  while (block) {
+    next = block->next;
+
+    w = block->begin;
+    for (SysUInt r = block->begin; r < block->end; r++) {
+      if (block->data[r] != data) {
+        block->data[w++] = block->data[r];
+      }
+    }
+
+    queue->length -= block->end - w;
+    block->end = w;
+
+    if (block->begin == block->end) {
+      uqueue_block_release(queue, block);
+    }
+
+    block = next;
+  }
+
+  return (old_length - queue->length);
+}
@@ -0,0 +1,69 @@
+#ifndef __SYS_UQUEUE_H__
+#define __SYS_UQUEUE_H__
+
+#include <System/Fundamental/SysCommonCore.h>
+
+SYS_BEGIN_DECLS
+
+/**
+ * SysUQueue: unrolled queue, same push/pop/peek surface as SysQueue
+ * but elements are stored in linked blocks of SYS_UQUEUE_BLOCK_SIZE
+ * pointers, so iteration is mostly linear and allocation is amortized.
+ * link based api is only available on SysQueue.
+ */
+
+#define SYS_UQUEUE_BLOCK_SIZE 32
+
+#define sys_uqueue_foreach(queue, block, i) \
+  for(SysUQueueBlock *block = (queue)->head; block; block = block->next) \
+    for(SysUInt i = block->begin; i < block->end; i++)
+
+typedef struct _SysUQueue SysUQueue;
+typedef struct _SysUQueueBlock SysUQueueBlock;
+
+struct _SysUQueueBlock {
+  SysUQueueBlock *next;
+  SysUQueueBlock *prev;
+
+  /* valid data in [begin, end) */
+  SysUInt begin;
+  SysUInt end;
+  SysPointer data[SYS_UQUEUE_BLOCK_SIZE];
+};
+
+struct _SysUQueue {
+  SysUQueueBlock *head;
+  SysUQueueBlock *tail;
+  SysUInt  length;
+
+  /* <private> */
+  SysUQueueBlock *spare;
+};
+
+SYS_API SysUQueue* sys_uqueue_new(void);
+SYS_API void  sys_uqueue_free(SysUQueue *queue);
+SYS_API void  sys_uqueue_free_full(SysUQueue *queue, SysDestroyFunc free_func);
+SYS_API void  sys_uqueue_init(SysUQueue *queue);
+SYS_API void  sys_uqueue_clear(SysUQueue *queue);
+SYS_API SysBool sys_uqueue_is_empty(SysUQueue *queue);
+SYS_API SysUInt  sys_uqueue_get_length(SysUQueue *queue);
+SYS_API void  sys_uqueue_reverse(SysUQueue *queue);
+SYS_API SysUQueue * sys_uqueue_copy(SysUQueue *queue);
+SYS_API void  sys_uqueue_foreach_func(SysUQueue *queue, SysFunc func, SysPointer user_data);
+SYS_API SysInt  sys_uqueue_find_custom(SysUQueue *queue, const SysPointer  data, SysCompareFunc   func);
+SYS_API void  sys_uqueue_push_head(SysUQueue *queue, SysPointer  data);
+SYS_API void  sys_uqueue_push_tail(SysUQueue *queue, SysPointer  data);
+SYS_API void  sys_uqueue_push_nth(SysUQueue *queue, SysPointer  data, SysUInt      n);
+SYS_API SysPointer  sys_uqueue_pop_head(SysUQueue *queue);
+SYS_API SysPointer  sys_uqueue_pop_tail(SysUQueue *queue);
+SYS_API SysPointer  sys_uqueue_pop_nth(SysUQueue *queue, SysUInt   n);
+SYS_API SysPointer  sys_uqueue_peek_head(SysUQueue *queue);
+SYS_API SysPointer  sys_uqueue_peek_tail(SysUQueue *queue);
+SYS_API SysPointer  sys_uqueue_peek_nth(SysUQueue *queue, SysUInt   n);
+SYS_API SysInt  sys_uqueue_index(SysUQueue *queue, const SysPointer  data);
+SYS_API SysBool  sys_uqueue_remove(SysUQueue *queue, const SysPointer  data);
+SYS_API SysUInt  sys_uqueue_remove_all(SysUQueue *queue, const SysPointer  data);
+
+SYS_END_DECLS
+
+#endif
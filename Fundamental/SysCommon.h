@@ -41,6 +41,19 @@
 
 #define UNUSED(o) ((void)o)
 #define SYS_INLINE inline
+
+/* static TLS storage class, left undefined where the compiler has none.
+ * initial-exec keeps shared library TLS off __tls_get_addr (), it comes
+ * from the small static TLS reserve so only put pointers there */
+#if defined(_MSC_VER)
+# define SYS_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) && defined(__ELF__)
+# define SYS_THREAD_LOCAL __thread __attribute__((tls_model ("initial-exec")))
+#elif defined(__GNUC__)
+# define SYS_THREAD_LOCAL __thread
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+# define SYS_THREAD_LOCAL _Thread_local
+#endif
 typedef bool SysBool;
 typedef int SysRef;
 typedef void* SysPointer;
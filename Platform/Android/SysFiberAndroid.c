@@ -0,0 +1,77 @@
+#include <System/Platform/Common/SysFiberSwitch.h>
+#include <System/Platform/Common/SysMem.h>
+
+#include <sys/mman.h>
+
+struct _SysFiberContext {
+  SysPointer sp;
+  /* mapping of the stack with its guard page, NULL for a thread */
+  SysPointer map;
+  SysSize map_size;
+};
+
+/* bionic has no makecontext(), the hand written switch covers arm64,
+ * armv7 and x86_64, the remaining ABIs have no fibers */
+#if !defined(SYS_FIBER_ASM_SWITCH)
+SysFiberContext *sys_real_fiber_context_new(SysSize stack_size, SysFiberEntry entry) {
+  UNUSED(stack_size);
+  UNUSED(entry);
+  sys_warning_N("%s", "fibers are not supported on this architecture");
+
+  return NULL;
+}
+#else
+SysFiberContext *sys_real_fiber_context_new(SysSize stack_size, SysFiberEntry entry) {
+  SysFiberContext *ctx;
+  SysSize page = (SysSize)sysconf(_SC_PAGESIZE);
+  SysSize size = (stack_size + page - 1) & ~(page - 1);
+  SysPointer map;
+  SysInt flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#if defined(MAP_STACK)
+  flags |= MAP_STACK;
+#endif
+
+  map = mmap(NULL, size + page, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (map == MAP_FAILED) {
+    sys_warning_N("fiber stack mmap failed: %s", sys_strerror(errno));
+    return NULL;
+  }
+
+  /* stacks grow down, the lowest page traps overflows */
+  if (mprotect(map, page, PROT_NONE) != 0) {
+    sys_warning_N("fiber guard page failed: %s", sys_strerror(errno));
+    munmap(map, size + page);
+    return NULL;
+  }
+
+  ctx = sys_new0(SysFiberContext, 1);
+  ctx->map = map;
+  ctx->map_size = size + page;
+
+  ctx->sp = sys_real_fiber_switch_prepare((SysChar *)map + page + size, entry);
+
+  return ctx;
+}
+#endif
+
+SysFiberContext *sys_real_fiber_context_main(void) {
+  return sys_new0(SysFiberContext, 1);
+}
+
+void sys_real_fiber_context_free(SysFiberContext *ctx) {
+  if (ctx->map != NULL) {
+    munmap(ctx->map, ctx->map_size);
+  }
+
+  sys_free(ctx);
+}
+
+void sys_real_fiber_context_switch(SysFiberContext *from, SysFiberContext *to) {
+#if defined(SYS_FIBER_ASM_SWITCH)
+  sys_real_fiber_switch(&from->sp, to->sp);
+#else
+  UNUSED(from);
+  UNUSED(to);
+#endif
+}
@@ -1,6 +1,8 @@
 #include <System/Utils/SysString.h>
 #include <System/Platform/Common/SysThreadPrivate.h>
 
+#include <sys/resource.h>
+
 /**
  * this code from glib SysThread
  * see: ftp://ftp.gtk.org/pub/gtk/
@@ -149,15 +151,43 @@ sys_mutex_clear (SysMutex *mutex)
  * already been locked by the same thread results in undefined behaviour
  * (including but not limited to deadlocks).
  */
+/* only touched on contention */
+static SysUInt64 sys_mutex_contended;
+
 void
 sys_mutex_lock (SysMutex *mutex)
 {
+  pthread_mutex_t *impl = sys_mutex_get_impl (mutex);
   SysInt status;
 
-  if SYS_UNLIKELY ((status = pthread_mutex_lock (sys_mutex_get_impl (mutex))) != 0)
+  if SYS_LIKELY ((status = pthread_mutex_trylock (impl)) == 0)
+    return;
+
+  if SYS_UNLIKELY (status != EBUSY)
+    sys_thread_abort (status, "pthread_mutex_trylock");
+
+  __atomic_fetch_add (&sys_mutex_contended, 1, __ATOMIC_RELAXED);
+
+  if SYS_UNLIKELY ((status = pthread_mutex_lock (impl)) != 0)
     sys_thread_abort (status, "pthread_mutex_lock");
 }
 
+void
+sys_mutex_get_stats (SysMutexStats *stats)
+{
+  sys_return_if_fail (stats != NULL);
+
+  stats->contended = __atomic_load_n (&sys_mutex_contended, __ATOMIC_RELAXED);
+  stats->spin_acquired = 0;
+  stats->parked = stats->contended;
+}
+
+void
+sys_mutex_reset_stats (void)
+{
+  __atomic_store_n (&sys_mutex_contended, 0, __ATOMIC_RELAXED);
+}
+
 /**
  * sys_mutex_unlock:
  * @mutex: a #SysMutex
@@ -448,6 +478,24 @@ sys_rw_lock_init (SysRWLock *rw_lock)
   rw_lock->p = sys_rw_lock_impl_new ();
 }
 
+/**
+ * sys_rw_lock_init_full:
+ * @rw_lock: an uninitialized #SysRWLock
+ * @flags: #SysRWLockFlags for the lock
+ *
+ * Same as sys_rw_lock_init() on this backend, %SYS_RW_LOCK_PREFER_WRITER
+ * is a no-op and the lock keeps the reader preference of bionic's
+ * default pthread_rwlock_t.
+ */
+void
+sys_rw_lock_init_full (SysRWLock      *rw_lock,
+                       SysRWLockFlags  flags)
+{
+  UNUSED (flags);
+
+  sys_rw_lock_init (rw_lock);
+}
+
 /**
  * sys_rw_lock_clear:
  * @rw_lock: an initialized #SysRWLock
@@ -969,7 +1017,7 @@ sys_private_get_impl (SysPrivate *key)
 }
 
 /**
- * sys_private_get:
+ * sys_system_private_get:
  * @key: a #SysPrivate
  *
  * Returns the current value of the thread local variable @key.
@@ -981,14 +1029,14 @@ sys_private_get_impl (SysPrivate *key)
  * Returns: the thread-local value
  */
 SysPointer
-sys_private_get (SysPrivate *key)
+sys_system_private_get (SysPrivate *key)
 {
   /* quote POSIX: No errors are returned from pthread_getspecific(). */
   return pthread_getspecific (*sys_private_get_impl (key));
 }
 
 /**
- * sys_private_set:
+ * sys_system_private_set:
  * @key: a #SysPrivate
  * @value: the new value
  *
@@ -999,8 +1047,8 @@ sys_private_get (SysPrivate *key)
  * the #SysDestroyFunc for @key is not called on the old value.
  */
 void
-sys_private_set (SysPrivate *key,
-               SysPointer  value)
+sys_system_private_set (SysPrivate *key,
+                      SysPointer  value)
 {
   SysInt status;
 
@@ -1009,7 +1057,7 @@ sys_private_set (SysPrivate *key,
 }
 
 /**
- * sys_private_replace:
+ * sys_system_private_replace:
  * @key: a #SysPrivate
  * @value: the new value
  *
@@ -1023,8 +1071,8 @@ sys_private_set (SysPrivate *key,
  * Since: 2.32
  **/
 void
-sys_private_replace (SysPrivate *key,
-                   SysPointer  value)
+sys_system_private_replace (SysPrivate *key,
+                          SysPointer  value)
 {
   pthread_key_t *impl = sys_private_get_impl (key);
   SysPointer old;
@@ -1059,6 +1107,11 @@ typedef struct
   SysMutex    lock;
 
   void *(*proxy) (void *);
+
+  /* applied by the thread itself before it runs proxy */
+  SysCpuSet *cpus;
+  SysBool renice;
+  SysInt nice;
 } SysThreadPosix;
 
 void
@@ -1074,9 +1127,51 @@ sys_system_thread_free (SysRealThread *thread)
   sys_slice_free (SysThreadPosix, pt);
 }
 
+#if defined(__linux__)
+static void
+sys_cpu_set_to_posix (const SysCpuSet *cpus, cpu_set_t *set)
+{
+  SysInt cpu;
+
+  CPU_ZERO (set);
+  for (cpu = 0; cpu < SYS_CPU_SET_MAX && cpu < CPU_SETSIZE; cpu++)
+    if (sys_cpu_set_contains (cpus, cpu))
+      CPU_SET (cpu, set);
+}
+#endif
+
+static void *
+sys_thread_posix_proxy (void *data)
+{
+  SysThreadPosix *thread = data;
+
+#if defined(__linux__)
+  if (thread->cpus)
+    {
+      cpu_set_t set;
+
+      sys_cpu_set_to_posix (thread->cpus, &set);
+      if (sched_setaffinity (0, sizeof (set), &set) != 0)
+        sys_warning_N ("sched_setaffinity: %s", sys_strerror (errno));
+
+      sys_free (thread->cpus);
+      thread->cpus = NULL;
+    }
+
+  /* nice is per thread on linux, the tid stands for the thread */
+  if (thread->renice && setpriority (PRIO_PROCESS, (id_t) syscall (SYS_gettid), thread->nice) != 0)
+    sys_warning_N ("setpriority: %s", sys_strerror (errno));
+#else
+  if (thread->renice && setpriority (PRIO_PROCESS, 0, thread->nice) != 0)
+    sys_warning_N ("setpriority: %s", sys_strerror (errno));
+#endif
+
+  return thread->proxy (thread);
+}
+
 SysRealThread *
 sys_system_thread_new (SysThreadFunc proxy,
-                     SysULong stack_size,
+                     const SysThreadOptions *options,
                      const SysChar *name,
                      SysThreadFunc func,
                      SysPointer data,
@@ -1095,39 +1190,73 @@ sys_system_thread_new (SysThreadFunc proxy,
   base_thread->thread.func = func;
   base_thread->thread.data = data;
   base_thread->name = sys_strdup (name);
-  thread->proxy = proxy;
+  thread->proxy = (void *(*) (void *)) proxy;
 
   posix_check_cmd (pthread_attr_init (&attr));
 
-#ifdef HAVE_PTHREAD_ATTR_SETSTACKSIZE
-  if (stack_size)
+  if (options && options->stack_size)
     {
+      SysSize stack_size = options->stack_size;
 #ifdef _SC_THREAD_STACK_MIN
       long min_stack_size = sysconf (_SC_THREAD_STACK_MIN);
-      if (min_stack_size >= 0)
-        stack_size = MAX ((SysULong) min_stack_size, stack_size);
+      if (min_stack_size >= 0 && stack_size < (SysSize) min_stack_size)
+        stack_size = (SysSize) min_stack_size;
 #endif /* _SC_THREAD_STACK_MIN */
       /* No error check here, because some systems can't do it and
        * we simply don't want threads to fail because of that. */
       pthread_attr_setstacksize (&attr, stack_size);
     }
-#endif /* HAVE_PTHREAD_ATTR_SETSTACKSIZE */
 
-#ifdef HAVE_PTHREAD_ATTR_SETINHERITSCHED
+  if (options && options->guard_size)
+    pthread_attr_setguardsize (&attr, options->guard_size);
+
+  if (options && options->cpus)
     {
-      /* While this is the default, better be explicit about it */
-      pthread_attr_setinheritsched (&attr, PTHREAD_INHERIT_SCHED);
+      thread->cpus = sys_new (SysCpuSet, 1);
+      *thread->cpus = *options->cpus;
     }
-#endif /* HAVE_PTHREAD_ATTR_SETINHERITSCHED */
 
-  ret = pthread_create (&thread->system_thread, &attr, (void* (*)(void*))proxy, thread);
+  if (options && options->sched != SYS_THREAD_SCHED_INHERIT)
+    {
+      struct sched_param param;
+      SysInt policy;
+
+      memset (&param, 0, sizeof (param));
+      switch (options->sched)
+        {
+        case SYS_THREAD_SCHED_FIFO:
+          policy = SCHED_FIFO;
+          param.sched_priority = options->priority;
+          break;
+        case SYS_THREAD_SCHED_RR:
+          policy = SCHED_RR;
+          param.sched_priority = options->priority;
+          break;
+        default:
+          policy = SCHED_OTHER;
+          thread->renice = true;
+          thread->nice = options->priority;
+          break;
+        }
+
+      pthread_attr_setinheritsched (&attr, PTHREAD_EXPLICIT_SCHED);
+      pthread_attr_setschedpolicy (&attr, policy);
+      pthread_attr_setschedparam (&attr, &param);
+    }
+
+  ret = pthread_create (&thread->system_thread, &attr, sys_thread_posix_proxy, thread);
 
   posix_check_cmd (pthread_attr_destroy (&attr));
 
-  if (ret == EAGAIN)
+  /* EPERM and EINVAL come from a real time policy or priority the
+   * caller may not use, they are the caller's to handle */
+  if (ret == EAGAIN || ret == EPERM || ret == EINVAL)
     {
       sys_error_set_N (error, "Error creating thread: %s", sys_strerror (ret));
-      sys_free (thread->thread.name);
+      if (thread->cpus)
+        sys_free (thread->cpus);
+      if (base_thread->name)
+        sys_free (base_thread->name);
       sys_slice_free (SysThreadPosix, thread);
       return NULL;
     }
@@ -1178,7 +1307,13 @@ sys_system_thread_exit (void)
 void
 sys_system_thread_set_name (const SysChar *name)
 {
-#if defined(HAVE_PTHREAD_SETNAME_NP_WITHOUT_TID)
+#if defined(__linux__)
+  SysChar buf[16];
+
+  /* the kernel limit is 15 bytes, longer names are refused outright */
+  sys_snprintf (buf, sizeof (buf), "%s", name);
+  pthread_setname_np (pthread_self (), buf);
+#elif defined(HAVE_PTHREAD_SETNAME_NP_WITHOUT_TID) || defined(__APPLE__)
   pthread_setname_np (name); /* on OS X and iOS */
 #elif defined(HAVE_PTHREAD_SETNAME_NP_WITH_TID)
   pthread_setname_np (pthread_self (), name); /* on Linux and Solaris */
@@ -1189,6 +1324,25 @@ sys_system_thread_set_name (const SysChar *name)
 #endif
 }
 
+SysBool
+sys_system_thread_set_affinity (SysRealThread *thread, const SysCpuSet *cpus)
+{
+  cpu_set_t set;
+  pid_t tid = 0;
+
+  sys_cpu_set_to_posix (cpus, &set);
+  if (thread != NULL)
+    tid = pthread_gettid_np (((SysThreadPosix *) thread)->system_thread);
+
+  if (sched_setaffinity (tid, sizeof (set), &set) != 0)
+    {
+      sys_warning_N ("sched_setaffinity: %s", sys_strerror (errno));
+      return false;
+    }
+
+  return true;
+}
+
 /* {{{1 SysMutex and SysCond futex implementation */
 
 #if defined(USE_NATIVE_MUTEX)
@@ -1500,5 +1654,69 @@ sys_cond_wait_until (SysCond  *cond,
 
 #endif
 
+#if defined(sys_futex_simple)
+/* {{{1 Address wait and wake */
+
+SysBool
+sys_system_futex_wait (SysUInt  *address,
+                       SysUInt   expected,
+                       SysInt64  end_time)
+{
+  SysInt res;
+
+  if (end_time < 0)
+    {
+      sys_futex_simple (address, (SysSize) FUTEX_WAIT_PRIVATE, (SysSize) expected, NULL);
+      return true;
+    }
+
+  /* FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC time, the two
+   * timespec layouts are explained in sys_cond_wait_until() */
+#ifdef __NR_futex_time64
+  {
+    struct
+    {
+      SysInt64 tv_sec;
+      SysInt64 tv_nsec;
+    } abs_arg;
+
+    abs_arg.tv_sec = end_time / 1000000;
+    abs_arg.tv_nsec = (end_time % 1000000) * 1000;
+
+    res = syscall (__NR_futex_time64, address, (SysSize) FUTEX_WAIT_BITSET_PRIVATE,
+                   (SysSize) expected, &abs_arg, NULL, (SysSize) FUTEX_BITSET_MATCH_ANY);
+#  ifdef __NR_futex
+    if (res >= 0 || errno != ENOSYS)
+#  endif /* defined(__NR_futex) */
+      return !(res < 0 && errno == ETIMEDOUT);
+  }
+#endif
+
+#ifdef __NR_futex
+  {
+    struct
+    {
+      __kernel_long_t tv_sec;
+      __kernel_long_t tv_nsec;
+    } abs_arg;
+
+    abs_arg.tv_sec = end_time / 1000000;
+    abs_arg.tv_nsec = (end_time % 1000000) * 1000;
+
+    res = syscall (__NR_futex, address, (SysSize) FUTEX_WAIT_BITSET_PRIVATE,
+                   (SysSize) expected, &abs_arg, NULL, (SysSize) FUTEX_BITSET_MATCH_ANY);
+    return !(res < 0 && errno == ETIMEDOUT);
+  }
+#endif /* defined(__NR_futex) */
+}
+
+void
+sys_system_futex_wake (SysUInt *address,
+                       SysBool  all)
+{
+  sys_futex_simple (address, (SysSize) FUTEX_WAKE_PRIVATE, (SysSize) (all ? INT_MAX : 1), NULL);
+}
+#endif /* defined(sys_futex_simple) */
+
   /* {{{1 Epilogue */
 /* vim:set foldmethod=marker: */
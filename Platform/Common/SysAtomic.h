@@ -3,13 +3,229 @@
 
 #include <System/Fundamental/SysCommon.h>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 SYS_BEGIN_DECLS
 
 #define MAX_REF_NODE 0xffffff
 
-#define sys_atomic_int_get(x) _sys_atomic_int_get((const volatile SysInt *)(x))
-#define sys_atomic_int_set(x, n) _sys_atomic_int_set((volatile SysInt *)(x), n)
+/**
+ * SysAtomicOrder: memory order of the inline atomics, same meaning as
+ * the C11 memory_order values.
+ *
+ * Loads take RELAXED, ACQUIRE or SEQ_CST, stores RELAXED, RELEASE or
+ * SEQ_CST, read-modify-write calls any of them. On MSVC every
+ * read-modify-write is a full barrier whatever the order asked.
+ */
+#if defined(__GNUC__)
+typedef enum {
+  SYS_ATOMIC_RELAXED = __ATOMIC_RELAXED,
+  SYS_ATOMIC_ACQUIRE = __ATOMIC_ACQUIRE,
+  SYS_ATOMIC_RELEASE = __ATOMIC_RELEASE,
+  SYS_ATOMIC_ACQ_REL = __ATOMIC_ACQ_REL,
+  SYS_ATOMIC_SEQ_CST = __ATOMIC_SEQ_CST
+} SysAtomicOrder;
+
+#define SYS_ATOMIC_DEFINE_OPS(name, type) \
+  static inline type sys_atomic_##name##_load(const type *x, SysAtomicOrder order) { \
+    return __atomic_load_n(x, order); \
+  } \
+  static inline void sys_atomic_##name##_store(type *x, type n, SysAtomicOrder order) { \
+    __atomic_store_n(x, n, order); \
+  } \
+  static inline type sys_atomic_##name##_exchange(type *x, type n, SysAtomicOrder order) { \
+    return __atomic_exchange_n(x, n, order); \
+  } \
+  static inline SysBool sys_atomic_##name##_compare_exchange(type *x, type *expected, type n, SysAtomicOrder order) { \
+    return __atomic_compare_exchange_n(x, expected, n, false, order, \
+        order == SYS_ATOMIC_ACQ_REL ? SYS_ATOMIC_ACQUIRE \
+        : order == SYS_ATOMIC_RELEASE ? SYS_ATOMIC_RELAXED : order); \
+  }
+
+#define SYS_ATOMIC_DEFINE_ARITH(name, type) \
+  static inline type sys_atomic_##name##_fetch_add(type *x, type n, SysAtomicOrder order) { \
+    return __atomic_fetch_add(x, n, order); \
+  } \
+  static inline type sys_atomic_##name##_fetch_sub(type *x, type n, SysAtomicOrder order) { \
+    return __atomic_fetch_sub(x, n, order); \
+  } \
+  static inline type sys_atomic_##name##_fetch_or(type *x, type n, SysAtomicOrder order) { \
+    return __atomic_fetch_or(x, n, order); \
+  } \
+  static inline type sys_atomic_##name##_fetch_and(type *x, type n, SysAtomicOrder order) { \
+    return __atomic_fetch_and(x, n, order); \
+  }
+
+static inline void sys_atomic_thread_fence(SysAtomicOrder order) {
+  __atomic_thread_fence(order);
+}
+
+#elif defined(_MSC_VER)
+typedef enum {
+  SYS_ATOMIC_RELAXED,
+  SYS_ATOMIC_ACQUIRE,
+  SYS_ATOMIC_RELEASE,
+  SYS_ATOMIC_ACQ_REL,
+  SYS_ATOMIC_SEQ_CST
+} SysAtomicOrder;
+
+#if defined(_M_ARM64)
+#define SYS_ATOMIC_MSVC_BARRIER() __dmb(_ARM64_BARRIER_ISH)
+#else
+#define SYS_ATOMIC_MSVC_BARRIER() _ReadWriteBarrier()
+#endif
+
+/* @itype is the type taken by the Interlocked family, @sfx its suffix */
+#define SYS_ATOMIC_DEFINE_OPS_MSVC(name, type, itype, sfx) \
+  static inline type sys_atomic_##name##_load(const type *x, SysAtomicOrder order) { \
+    type r = *(const volatile type *)x; \
+    if (order != SYS_ATOMIC_RELAXED) SYS_ATOMIC_MSVC_BARRIER(); \
+    return r; \
+  } \
+  static inline void sys_atomic_##name##_store(type *x, type n, SysAtomicOrder order) { \
+    if (order == SYS_ATOMIC_SEQ_CST) { \
+      InterlockedExchange##sfx((volatile itype *)x, (itype)n); \
+      return; \
+    } \
+    if (order != SYS_ATOMIC_RELAXED) SYS_ATOMIC_MSVC_BARRIER(); \
+    *(volatile type *)x = n; \
+  } \
+  static inline type sys_atomic_##name##_exchange(type *x, type n, SysAtomicOrder order) { \
+    return (type)InterlockedExchange##sfx((volatile itype *)x, (itype)n); \
+  } \
+  static inline SysBool sys_atomic_##name##_compare_exchange(type *x, type *expected, type n, SysAtomicOrder order) { \
+    type o = *expected; \
+    *expected = (type)InterlockedCompareExchange##sfx((volatile itype *)x, (itype)n, (itype)o); \
+    return *expected == o; \
+  }
+
+#define SYS_ATOMIC_DEFINE_ARITH_MSVC(name, type, itype, sfx) \
+  static inline type sys_atomic_##name##_fetch_add(type *x, type n, SysAtomicOrder order) { \
+    return (type)InterlockedExchangeAdd##sfx((volatile itype *)x, (itype)n); \
+  } \
+  static inline type sys_atomic_##name##_fetch_sub(type *x, type n, SysAtomicOrder order) { \
+    return (type)InterlockedExchangeAdd##sfx((volatile itype *)x, -(itype)n); \
+  } \
+  static inline type sys_atomic_##name##_fetch_or(type *x, type n, SysAtomicOrder order) { \
+    return (type)InterlockedOr##sfx((volatile itype *)x, (itype)n); \
+  } \
+  static inline type sys_atomic_##name##_fetch_and(type *x, type n, SysAtomicOrder order) { \
+    return (type)InterlockedAnd##sfx((volatile itype *)x, (itype)n); \
+  }
+
+static inline void sys_atomic_thread_fence(SysAtomicOrder order) {
+  if (order == SYS_ATOMIC_SEQ_CST) {
+    MemoryBarrier();
+  } else if (order != SYS_ATOMIC_RELAXED) {
+    SYS_ATOMIC_MSVC_BARRIER();
+  }
+}
+
+#else
+#error "no atomic operations for this compiler"
+#endif
+
+#if !defined(__GNUC__)
+SYS_ATOMIC_DEFINE_OPS_MSVC(int, SysInt, long, )
+SYS_ATOMIC_DEFINE_ARITH_MSVC(int, SysInt, long, )
+SYS_ATOMIC_DEFINE_OPS_MSVC(uint, SysUInt, long, )
+SYS_ATOMIC_DEFINE_ARITH_MSVC(uint, SysUInt, long, )
+SYS_ATOMIC_DEFINE_OPS_MSVC(int64, SysInt64, LONG64, 64)
+SYS_ATOMIC_DEFINE_ARITH_MSVC(int64, SysInt64, LONG64, 64)
+SYS_ATOMIC_DEFINE_OPS_MSVC(uint64, SysUInt64, LONG64, 64)
+SYS_ATOMIC_DEFINE_ARITH_MSVC(uint64, SysUInt64, LONG64, 64)
+SYS_ATOMIC_DEFINE_OPS_MSVC(pointer, SysPointer, PVOID, Pointer)
+#else
+SYS_ATOMIC_DEFINE_OPS(int, SysInt)
+SYS_ATOMIC_DEFINE_ARITH(int, SysInt)
+SYS_ATOMIC_DEFINE_OPS(uint, SysUInt)
+SYS_ATOMIC_DEFINE_ARITH(uint, SysUInt)
+SYS_ATOMIC_DEFINE_OPS(int64, SysInt64)
+SYS_ATOMIC_DEFINE_ARITH(int64, SysInt64)
+SYS_ATOMIC_DEFINE_OPS(uint64, SysUInt64)
+SYS_ATOMIC_DEFINE_ARITH(uint64, SysUInt64)
+SYS_ATOMIC_DEFINE_OPS(pointer, SysPointer)
+#endif
+
+/**
+ * SysAtomicPair: two words swapped together by sys_atomic_pair_cmpxchg(),
+ * typically a pointer and a tag against ABA. Only available when
+ * SYS_ATOMIC_HAVE_DCAS is defined.
+ */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SYS_ATOMIC_HAVE_DCAS 1
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define SYS_ATOMIC_HAVE_DCAS 1
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#define SYS_ATOMIC_HAVE_DCAS 1
+#endif
+
+#if defined(SYS_ATOMIC_HAVE_DCAS)
+typedef struct _SysAtomicPair SysAtomicPair;
+
+#if defined(_MSC_VER)
+__declspec(align(16))
+#endif
+struct _SysAtomicPair {
+  SysPointer lo;
+  SysPointer hi;
+}
+#if defined(__GNUC__)
+__attribute__((aligned(16)))
+#endif
+;
+
+/* sequentially consistent, @expected receives the current value on failure */
+static inline SysBool sys_atomic_pair_cmpxchg(SysAtomicPair *x, SysAtomicPair *expected, SysAtomicPair n) {
+#if defined(__GNUC__) && defined(__x86_64__)
+  /* cmpxchg16b inline, __atomic on 16 bytes would need libatomic */
+  SysBool ok;
+
+  __asm__ __volatile__("lock cmpxchg16b %1\n\tsete %0"
+      : "=q"(ok), "+m"(*x), "+a"(expected->lo), "+d"(expected->hi)
+      : "b"(n.lo), "c"(n.hi)
+      : "memory", "cc");
+
+  return ok;
+#elif defined(__GNUC__)
+  /* ldaxp/stlxp loop inline, for the same reason. A mismatch stores the
+   * old pair back, only a successful store proves the load was not torn */
+  SysPointer lo, hi;
+  SysUInt32 failed;
+  SysBool ok;
 
+  __asm__ __volatile__("1: ldaxp %[lo], %[hi], %[mem]\n\t"
+      "cmp %[lo], %[elo]\n\t"
+      "ccmp %[hi], %[ehi], #0, eq\n\t"
+      "b.ne 2f\n\t"
+      "stlxp %w[failed], %[nlo], %[nhi], %[mem]\n\t"
+      "cbnz %w[failed], 1b\n\t"
+      "b 3f\n"
+      "2: stlxp %w[failed], %[lo], %[hi], %[mem]\n\t"
+      "cbnz %w[failed], 1b\n"
+      "3:"
+      : [lo] "=&r"(lo), [hi] "=&r"(hi), [failed] "=&r"(failed), [mem] "+Q"(*x)
+      : [elo] "r"(expected->lo), [ehi] "r"(expected->hi), [nlo] "r"(n.lo), [nhi] "r"(n.hi)
+      : "memory", "cc");
+
+  ok = lo == expected->lo && hi == expected->hi;
+  expected->lo = lo;
+  expected->hi = hi;
+
+  return ok;
+#else
+  return _InterlockedCompareExchange128((volatile __int64 *)x,
+      (__int64)n.hi, (__int64)n.lo, (__int64 *)expected) != 0;
+#endif
+}
+#endif
+
+#define sys_atomic_int_get(x) sys_atomic_int_load((const SysInt *)(x), SYS_ATOMIC_SEQ_CST)
+#define sys_atomic_int_set(x, n) sys_atomic_int_store((SysInt *)(x), (n), SYS_ATOMIC_SEQ_CST)
+
+/* the out-of-line calls below are sequentially consistent */
 SYS_API SysInt _sys_atomic_int_get(const volatile SysInt *x);
 SYS_API void _sys_atomic_int_set(volatile SysInt *x, SysInt n);
 SYS_API void sys_atomic_int_inc(SysInt *x);
@@ -19,22 +235,36 @@ SYS_API SysBool sys_atomic_cmpxchg(SysInt *x, SysInt o, SysInt n);
 SYS_API SysBool sys_atomic_pointer_cmpxchg(volatile SysPointer* x, SysPointer o, SysPointer n);
 SYS_API SysPointer sys_atomic_pointer_get(const volatile SysPointer x);
 SYS_API void sys_atomic_pointer_set(SysPointer o, SysPointer n);
+SYS_API void sys_atomic_fence(void);
+
+/* hint for busy-wait loops, lets the sibling hyperthread run */
+static inline void sys_cpu_relax(void) {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  __builtin_ia32_pause();
+#elif defined(__GNUC__) && (defined(__aarch64__) || (defined(__ARM_ARCH) && __ARM_ARCH >= 7))
+  __asm__ __volatile__("yield" ::: "memory");
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+  _mm_pause();
+#endif
+}
 
+/* new references only need the object to be alive, the release that
+ * drops the last one must see every write made through the others */
 #define SYS_REF_INIT_VALUE 1
 #define sys_ref_count_check(o, max_ref) \
-  (_sys_atomic_int_get(&(o)->ref_count) >= 0 \
-   && _sys_atomic_int_get(&(o)->ref_count) < (max_ref))
+  (sys_atomic_int_load(&(o)->ref_count, SYS_ATOMIC_RELAXED) >= 0 \
+   && sys_atomic_int_load(&(o)->ref_count, SYS_ATOMIC_RELAXED) < (max_ref))
 
 #define sys_ref_count_valid_check(o, max_ref) \
-  (_sys_atomic_int_get(&(o)->ref_count) > 0 \
-   && _sys_atomic_int_get(&(o)->ref_count) < (max_ref))
+  (sys_atomic_int_load(&(o)->ref_count, SYS_ATOMIC_RELAXED) > 0 \
+   && sys_atomic_int_load(&(o)->ref_count, SYS_ATOMIC_RELAXED) < (max_ref))
 
 #define sys_ref_count_init(o) ((o)->ref_count = (SYS_REF_INIT_VALUE))
-#define sys_ref_count_inc(o) sys_atomic_int_inc(&((o)->ref_count))
-#define sys_ref_count_get(o) sys_atomic_int_get(&((o)->ref_count))
-#define sys_ref_count_dec(o) sys_atomic_int_dec_and_test(&((o)->ref_count))
-#define sys_ref_count_cmp(o, n) (_sys_atomic_int_get(&((o)->ref_count)) == n)
-#define sys_ref_count_set(o, n) _sys_atomic_int_set(&((o)->ref_count), 0)
+#define sys_ref_count_inc(o) ((void)sys_atomic_int_fetch_add(&((o)->ref_count), 1, SYS_ATOMIC_RELAXED))
+#define sys_ref_count_get(o) sys_atomic_int_load(&((o)->ref_count), SYS_ATOMIC_ACQUIRE)
+#define sys_ref_count_dec(o) (sys_atomic_int_fetch_sub(&((o)->ref_count), 1, SYS_ATOMIC_ACQ_REL) == 1)
+#define sys_ref_count_cmp(o, n) (sys_atomic_int_load(&((o)->ref_count), SYS_ATOMIC_ACQUIRE) == (n))
+#define sys_ref_count_set(o, n) sys_atomic_int_store(&((o)->ref_count), (n), SYS_ATOMIC_RELEASE)
 
 SYS_END_DECLS
 
@@ -0,0 +1,399 @@
+#include <System/Platform/Common/SysFiberPrivate.h>
+#include <System/Platform/Common/SysThread.h>
+#include <System/Platform/Common/SysAtomic.h>
+#include <System/DataTypes/SysHList.h>
+#include <System/DataTypes/SysQueue.h>
+#include <System/DataTypes/SysAsyncQueue.h>
+
+typedef struct _SysFiberSched SysFiberSched;
+
+typedef enum {
+  SYS_FIBER_READY,
+  SYS_FIBER_RUNNING,
+  SYS_FIBER_SUSPENDED,
+  /* waiting in a channel, only the channel wakes it */
+  SYS_FIBER_BLOCKED,
+  SYS_FIBER_DEAD
+} SysFiberState;
+
+struct _SysFiber {
+  /* in the ready list or in the waiters of a channel */
+  SysHList link;
+  SysFiberFunc func;
+  SysPointer data;
+  SysFiberContext *ctx;
+  SysFiberSched *sched;
+  SysInt state;
+};
+
+struct _SysFiberSched {
+  SysHList ready;
+  /* fibers resumed by other threads */
+  SysAsyncQueue *remote;
+  SysInt n_remote;
+  SysFiberContext *main_ctx;
+  SysFiber *current;
+  /* fiber that just returned, freed once off its stack */
+  SysFiber *dead;
+  SysUInt n_fibers;
+};
+
+struct _SysFiberChannel {
+  SysMutex lock;
+  SysQueue items;
+  /* fibers blocked in sys_fiber_channel_pop() */
+  SysHList waiters;
+};
+
+static void fiber_sched_free(SysPointer data);
+
+SYS_THREAD_LOCAL_DEFINE_STATIC(fiber_sched_private, fiber_sched_free);
+
+static void fiber_sched_free(SysPointer data) {
+  SysFiberSched *sched = data;
+
+  if (sched->n_fibers > 0) {
+    sys_warning_N("thread exits with %u fibers never finished", sched->n_fibers);
+  }
+
+  sys_async_queue_unref(sched->remote);
+  sys_real_fiber_context_free(sched->main_ctx);
+  sys_slice_free(SysFiberSched, sched);
+}
+
+static SysFiberSched *fiber_sched_get(void) {
+  SysFiberSched *sched = sys_thread_local_get(&fiber_sched_private);
+
+  if (sched != NULL) {
+    return sched;
+  }
+
+  sched = sys_slice_new0(SysFiberSched);
+  sys_hlist_init(&sched->ready);
+  sched->remote = sys_async_queue_new();
+  sched->main_ctx = sys_real_fiber_context_main();
+
+  sys_thread_local_set(&fiber_sched_private, sched);
+
+  return sched;
+}
+
+static void fiber_entry(void) {
+  SysFiberSched *sched = sys_thread_local_get(&fiber_sched_private);
+  SysFiber *fiber = sched->current;
+
+  fiber->func(fiber->data);
+
+  sys_atomic_int_store(&fiber->state, SYS_FIBER_DEAD, SYS_ATOMIC_RELAXED);
+  sched->dead = fiber;
+  sys_real_fiber_context_switch(fiber->ctx, sched->main_ctx);
+
+  sys_assert_not_reached();
+}
+
+/* back to sys_fiber_run() of the current thread */
+static void fiber_switch_out(SysFiberSched *sched, SysFiber *fiber) {
+  sys_real_fiber_context_switch(fiber->ctx, sched->main_ctx);
+}
+
+static void fiber_sched_drain_remote(SysFiberSched *sched, SysBool block) {
+  SysFiber *fiber;
+
+  if (block) {
+    fiber = sys_async_queue_pop(sched->remote);
+  } else {
+    if (sys_atomic_int_load(&sched->n_remote, SYS_ATOMIC_ACQUIRE) == 0) {
+      return;
+    }
+
+    fiber = sys_async_queue_try_pop(sched->remote);
+  }
+
+  while (fiber != NULL) {
+    sys_atomic_int_fetch_sub(&sched->n_remote, 1, SYS_ATOMIC_RELAXED);
+    sys_hlist_add_tail(&sched->ready, &fiber->link);
+
+    fiber = sys_async_queue_try_pop(sched->remote);
+  }
+}
+
+/**
+ * sys_fiber_new:
+ * @func: body of the fiber
+ * @data: argument of @func
+ * @stack_size: stack size in bytes, 0 for %SYS_FIBER_STACK_SIZE
+ *
+ * Creates a fiber on the scheduler of the calling thread, it starts
+ * at the next switch in sys_fiber_run().
+ *
+ * Returns: (transfer none): the fiber, valid until @func returns, or
+ *   %NULL if no stack could be made
+ */
+SysFiber *sys_fiber_new(SysFiberFunc func, SysPointer data, SysSize stack_size) {
+  SysFiberSched *sched;
+  SysFiberContext *ctx;
+  SysFiber *fiber;
+
+  sys_return_val_if_fail(func != NULL, NULL);
+
+  sched = fiber_sched_get();
+
+  ctx = sys_real_fiber_context_new(stack_size > 0 ? stack_size : SYS_FIBER_STACK_SIZE, fiber_entry);
+  if (ctx == NULL) {
+    return NULL;
+  }
+
+  fiber = sys_slice_new(SysFiber);
+  sys_hlist_init(&fiber->link);
+  fiber->func = func;
+  fiber->data = data;
+  fiber->ctx = ctx;
+  fiber->sched = sched;
+  fiber->state = SYS_FIBER_READY;
+
+  sys_hlist_add_tail(&sched->ready, &fiber->link);
+  sched->n_fibers++;
+
+  return fiber;
+}
+
+/**
+ * sys_fiber_self:
+ *
+ * Returns: (nullable): the running fiber, %NULL outside of fibers
+ */
+SysFiber *sys_fiber_self(void) {
+  SysFiberSched *sched = sys_thread_local_get(&fiber_sched_private);
+
+  return sched ? sched->current : NULL;
+}
+
+/**
+ * sys_fiber_run:
+ *
+ * Runs the fibers of the calling thread until all of them returned.
+ * When every fiber is suspended the thread sleeps until another thread
+ * resumes one. Must not be called from a fiber.
+ */
+void sys_fiber_run(void) {
+  SysFiberSched *sched = fiber_sched_get();
+  SysFiber *fiber;
+
+  sys_return_if_fail(sched->current == NULL);
+
+  while (sched->n_fibers > 0) {
+    fiber_sched_drain_remote(sched, sys_hlist_is_empty(&sched->ready));
+
+    fiber = SYS_HLIST_CAST_TO(sys_hlist_first(&sched->ready), SysFiber, link);
+    sys_hlist_unlink(&fiber->link);
+
+    sys_atomic_int_store(&fiber->state, SYS_FIBER_RUNNING, SYS_ATOMIC_RELAXED);
+    sched->current = fiber;
+    sys_real_fiber_context_switch(sched->main_ctx, fiber->ctx);
+    sched->current = NULL;
+
+    if (sched->dead != NULL) {
+      sys_real_fiber_context_free(sched->dead->ctx);
+      sys_slice_free(SysFiber, sched->dead);
+      sched->dead = NULL;
+      sched->n_fibers--;
+    }
+  }
+}
+
+/**
+ * sys_fiber_yield:
+ *
+ * Lets the other ready fibers of this thread run, the caller is
+ * queued behind them.
+ */
+void sys_fiber_yield(void) {
+  SysFiberSched *sched = sys_thread_local_get(&fiber_sched_private);
+  SysFiber *fiber;
+
+  sys_return_if_fail(sched != NULL && sched->current != NULL);
+
+  fiber = sched->current;
+  sys_atomic_int_store(&fiber->state, SYS_FIBER_READY, SYS_ATOMIC_RELAXED);
+  sys_hlist_add_tail(&sched->ready, &fiber->link);
+
+  fiber_switch_out(sched, fiber);
+}
+
+/**
+ * sys_fiber_suspend:
+ *
+ * Parks the running fiber until sys_fiber_resume() is called on it.
+ */
+void sys_fiber_suspend(void) {
+  SysFiberSched *sched = sys_thread_local_get(&fiber_sched_private);
+  SysFiber *fiber;
+
+  sys_return_if_fail(sched != NULL && sched->current != NULL);
+
+  fiber = sched->current;
+  sys_atomic_int_store(&fiber->state, SYS_FIBER_SUSPENDED, SYS_ATOMIC_RELEASE);
+
+  fiber_switch_out(sched, fiber);
+}
+
+/* queues @fiber on its scheduler if it is parked in @state */
+static void fiber_wake(SysFiber *fiber, SysInt state) {
+  SysFiberSched *sched;
+
+  if (!sys_atomic_int_compare_exchange(&fiber->state, &state, SYS_FIBER_READY, SYS_ATOMIC_ACQ_REL)) {
+    return;
+  }
+
+  sched = fiber->sched;
+  if (sched == sys_thread_local_get(&fiber_sched_private)) {
+    sys_hlist_add_tail(&sched->ready, &fiber->link);
+    return;
+  }
+
+  sys_atomic_int_fetch_add(&sched->n_remote, 1, SYS_ATOMIC_RELEASE);
+  sys_async_queue_push(sched->remote, fiber);
+}
+
+/**
+ * sys_fiber_resume:
+ * @fiber: a suspended #SysFiber
+ *
+ * Makes @fiber ready again, it runs on its own thread. May be called
+ * from any thread, resuming a fiber that is not suspended does nothing,
+ * a fiber blocked in sys_fiber_channel_pop() only wakes up for an item.
+ */
+void sys_fiber_resume(SysFiber *fiber) {
+  sys_return_if_fail(fiber != NULL);
+
+  fiber_wake(fiber, SYS_FIBER_SUSPENDED);
+}
+
+/* channel */
+SysFiberChannel *sys_fiber_channel_new(void) {
+  SysFiberChannel *channel = sys_slice_new(SysFiberChannel);
+
+  sys_mutex_init(&channel->lock);
+  sys_queue_init(&channel->items);
+  sys_hlist_init(&channel->waiters);
+
+  return channel;
+}
+
+/**
+ * sys_fiber_channel_free:
+ * @channel: a #SysFiberChannel
+ *
+ * Frees @channel, no fiber may be waiting on it. Items still queued
+ * are not freed.
+ */
+void sys_fiber_channel_free(SysFiberChannel *channel) {
+  sys_return_if_fail(channel != NULL);
+  sys_return_if_fail(sys_hlist_is_empty(&channel->waiters));
+
+  sys_queue_clear(&channel->items);
+  sys_mutex_clear(&channel->lock);
+  sys_slice_free(SysFiberChannel, channel);
+}
+
+/**
+ * sys_fiber_channel_push:
+ * @channel: a #SysFiberChannel
+ * @data: item to queue
+ *
+ * Queues @data and wakes the oldest fiber waiting in pop. May be called
+ * from any thread, fiber or not.
+ */
+void sys_fiber_channel_push(SysFiberChannel *channel, SysPointer data) {
+  SysFiber *waiter = NULL;
+  SysHList *node;
+
+  sys_return_if_fail(channel != NULL);
+
+  sys_mutex_lock(&channel->lock);
+  sys_queue_push_tail(&channel->items, data);
+
+  if (!sys_hlist_is_empty(&channel->waiters)) {
+    node = sys_hlist_first(&channel->waiters);
+    sys_hlist_unlink(node);
+    waiter = SYS_HLIST_CAST_TO(node, SysFiber, link);
+  }
+  sys_mutex_unlock(&channel->lock);
+
+  if (waiter != NULL) {
+    fiber_wake(waiter, SYS_FIBER_BLOCKED);
+  }
+}
+
+/**
+ * sys_fiber_channel_pop:
+ * @channel: a #SysFiberChannel
+ *
+ * Takes the oldest item, suspending the running fiber while @channel
+ * is empty. Must be called from a fiber.
+ *
+ * Returns: the item
+ */
+SysPointer sys_fiber_channel_pop(SysFiberChannel *channel) {
+  SysFiberSched *sched = sys_thread_local_get(&fiber_sched_private);
+  SysFiber *fiber, *waiter = NULL;
+  SysHList *node;
+  SysPointer data;
+
+  sys_return_val_if_fail(channel != NULL, NULL);
+  sys_return_val_if_fail(sched != NULL && sched->current != NULL, NULL);
+
+  fiber = sched->current;
+
+  sys_mutex_lock(&channel->lock);
+  while (sys_queue_is_empty(&channel->items)) {
+    /* suspended before the lock is dropped, so a push cannot miss us */
+    sys_atomic_int_store(&fiber->state, SYS_FIBER_BLOCKED, SYS_ATOMIC_RELEASE);
+    sys_hlist_add_tail(&channel->waiters, &fiber->link);
+    sys_mutex_unlock(&channel->lock);
+
+    fiber_switch_out(sched, fiber);
+
+    sys_mutex_lock(&channel->lock);
+  }
+
+  data = sys_queue_pop_head(&channel->items);
+
+  /* items left behind go to the next waiter */
+  if (!sys_queue_is_empty(&channel->items) && !sys_hlist_is_empty(&channel->waiters)) {
+    node = sys_hlist_first(&channel->waiters);
+    sys_hlist_unlink(node);
+    waiter = SYS_HLIST_CAST_TO(node, SysFiber, link);
+  }
+  sys_mutex_unlock(&channel->lock);
+
+  if (waiter != NULL) {
+    fiber_wake(waiter, SYS_FIBER_BLOCKED);
+  }
+
+  return data;
+}
+
+SysPointer sys_fiber_channel_try_pop(SysFiberChannel *channel) {
+  SysPointer data;
+
+  sys_return_val_if_fail(channel != NULL, NULL);
+
+  sys_mutex_lock(&channel->lock);
+  data = sys_queue_pop_head(&channel->items);
+  sys_mutex_unlock(&channel->lock);
+
+  return data;
+}
+
+SysUInt sys_fiber_channel_length(SysFiberChannel *channel) {
+  SysUInt len;
+
+  sys_return_val_if_fail(channel != NULL, 0);
+
+  sys_mutex_lock(&channel->lock);
+  len = sys_queue_get_length(&channel->items);
+  sys_mutex_unlock(&channel->lock);
+
+  return len;
+}
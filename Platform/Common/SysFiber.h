@@ -0,0 +1,49 @@
+#ifndef __SYS_FIBER_H__
+#define __SYS_FIBER_H__
+
+#include <System/Fundamental/SysCommonCore.h>
+
+SYS_BEGIN_DECLS
+
+/**
+ * SysFiber: cooperative task with its own small stack.
+ *
+ * Fibers belong to the scheduler of the thread that created them and
+ * only run inside sys_fiber_run() on that thread, switching when they
+ * call sys_fiber_yield(), sys_fiber_suspend() or block on a
+ * #SysFiberChannel. A switch is a user space register swap, no kernel
+ * call, so tens of thousands of mostly idle tasks cost a stack each
+ * and nothing else.
+ *
+ * Stacks are mapped with a guard page below them, an overflow faults
+ * instead of corrupting the neighbour. A fiber is freed when its
+ * function returns.
+ *
+ * Android has no ucontext, fibers there need arm64, armv7 with VFP or
+ * x86_64; on other ABIs sys_fiber_new() warns and returns %NULL.
+ */
+
+typedef struct _SysFiber SysFiber;
+typedef struct _SysFiberChannel SysFiberChannel;
+
+typedef void (*SysFiberFunc)(SysPointer data);
+
+#define SYS_FIBER_STACK_SIZE (64 * 1024)
+
+SYS_API SysFiber *sys_fiber_new(SysFiberFunc func, SysPointer data, SysSize stack_size);
+SYS_API SysFiber *sys_fiber_self(void);
+SYS_API void sys_fiber_run(void);
+SYS_API void sys_fiber_yield(void);
+SYS_API void sys_fiber_suspend(void);
+SYS_API void sys_fiber_resume(SysFiber *fiber);
+
+SYS_API SysFiberChannel *sys_fiber_channel_new(void);
+SYS_API void sys_fiber_channel_free(SysFiberChannel *channel);
+SYS_API void sys_fiber_channel_push(SysFiberChannel *channel, SysPointer data);
+SYS_API SysPointer sys_fiber_channel_pop(SysFiberChannel *channel);
+SYS_API SysPointer sys_fiber_channel_try_pop(SysFiberChannel *channel);
+SYS_API SysUInt sys_fiber_channel_length(SysFiberChannel *channel);
+
+SYS_END_DECLS
+
+#endif
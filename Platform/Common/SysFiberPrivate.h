@@ -0,0 +1,16 @@
+#ifndef __SYS_FIBER_PRIVATE_H__
+#define __SYS_FIBER_PRIVATE_H__
+
+#include <System/Platform/Common/SysFiber.h>
+
+typedef struct _SysFiberContext SysFiberContext;
+typedef void (*SysFiberEntry)(void);
+
+/* @entry starts on the new stack and must never return */
+SysFiberContext *sys_real_fiber_context_new(SysSize stack_size, SysFiberEntry entry);
+/* the context of the calling thread itself, it owns no stack */
+SysFiberContext *sys_real_fiber_context_main(void);
+void sys_real_fiber_context_free(SysFiberContext *ctx);
+void sys_real_fiber_context_switch(SysFiberContext *from, SysFiberContext *to);
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef __SYS_FIBER_SWITCH_H__
+#define __SYS_FIBER_SWITCH_H__
+
+#include <System/Platform/Common/SysFiberPrivate.h>
+
+/* hand written stack switch of the ELF backends, where the ABI is known.
+ *
+ * sys_real_fiber_switch() saves the callee-saved registers on the old
+ * stack, stores the stack pointer in @from_sp and restores the same
+ * frame from @to_sp. sys_real_fiber_switch_prepare() builds such a
+ * frame at the top of a fresh stack so that the first switch to it
+ * returns straight into @entry.
+ *
+ * The switch itself is defined here, include this from a single
+ * backend source. SYS_FIBER_ASM_SWITCH is left undefined on other
+ * targets. */
+#if defined(__ELF__) && defined(__x86_64__)
+#define SYS_FIBER_ASM_SWITCH
+#elif defined(__ELF__) && defined(__aarch64__)
+#define SYS_FIBER_ASM_SWITCH
+#elif defined(__ELF__) && defined(__arm__) && defined(__ARM_ARCH) && __ARM_ARCH >= 7 && defined(__ARM_FP)
+#define SYS_FIBER_ASM_SWITCH
+#endif
+
+#if defined(SYS_FIBER_ASM_SWITCH)
+void sys_real_fiber_switch(SysPointer *from_sp, SysPointer to_sp);
+
+#if defined(__x86_64__)
+/* callee-saved registers, mxcsr and the x87 control word */
+__asm__(
+    ".text\n"
+    ".globl sys_real_fiber_switch\n"
+    ".hidden sys_real_fiber_switch\n"
+    ".type sys_real_fiber_switch, @function\n"
+    ".p2align 4\n"
+    "sys_real_fiber_switch:\n"
+    "  pushq %rbp\n"
+    "  pushq %rbx\n"
+    "  pushq %r12\n"
+    "  pushq %r13\n"
+    "  pushq %r14\n"
+    "  pushq %r15\n"
+    "  subq $8, %rsp\n"
+    "  stmxcsr (%rsp)\n"
+    "  fnstcw 4(%rsp)\n"
+    "  movq %rsp, (%rdi)\n"
+    "  movq %rsi, %rsp\n"
+    "  ldmxcsr (%rsp)\n"
+    "  fldcw 4(%rsp)\n"
+    "  addq $8, %rsp\n"
+    "  popq %r15\n"
+    "  popq %r14\n"
+    "  popq %r13\n"
+    "  popq %r12\n"
+    "  popq %rbx\n"
+    "  popq %rbp\n"
+    "  ret\n"
+    ".size sys_real_fiber_switch, .-sys_real_fiber_switch\n");
+
+static SysPointer sys_real_fiber_switch_prepare(SysPointer top, SysFiberEntry entry) {
+  SysUInt64 *sp = (SysUInt64 *)((SysUIntPtr)top & ~(SysUIntPtr)15);
+  SysUInt i;
+
+  /* return address of @entry, which never returns */
+  *--sp = 0;
+  *--sp = (SysUInt64)(SysUIntPtr)entry;
+  /* rbp, rbx, r12 - r15 */
+  for (i = 0; i < 6; i++) {
+    *--sp = 0;
+  }
+  /* default mxcsr and x87 control word */
+  *--sp = ((SysUInt64)0x037f << 32) | 0x1f80;
+
+  return sp;
+}
+
+#elif defined(__aarch64__)
+/* d8 - d15, x19 - x28, then the frame pointer and the link register,
+ * ret goes back through the restored x30 */
+__asm__(
+    ".text\n"
+    ".globl sys_real_fiber_switch\n"
+    ".hidden sys_real_fiber_switch\n"
+    ".type sys_real_fiber_switch, %function\n"
+    ".p2align 4\n"
+    "sys_real_fiber_switch:\n"
+    "  sub sp, sp, #160\n"
+    "  stp d8, d9, [sp, #0]\n"
+    "  stp d10, d11, [sp, #16]\n"
+    "  stp d12, d13, [sp, #32]\n"
+    "  stp d14, d15, [sp, #48]\n"
+    "  stp x19, x20, [sp, #64]\n"
+    "  stp x21, x22, [sp, #80]\n"
+    "  stp x23, x24, [sp, #96]\n"
+    "  stp x25, x26, [sp, #112]\n"
+    "  stp x27, x28, [sp, #128]\n"
+    "  stp x29, x30, [sp, #144]\n"
+    "  mov x2, sp\n"
+    "  str x2, [x0]\n"
+    "  mov sp, x1\n"
+    "  ldp d8, d9, [sp, #0]\n"
+    "  ldp d10, d11, [sp, #16]\n"
+    "  ldp d12, d13, [sp, #32]\n"
+    "  ldp d14, d15, [sp, #48]\n"
+    "  ldp x19, x20, [sp, #64]\n"
+    "  ldp x21, x22, [sp, #80]\n"
+    "  ldp x23, x24, [sp, #96]\n"
+    "  ldp x25, x26, [sp, #112]\n"
+    "  ldp x27, x28, [sp, #128]\n"
+    "  ldp x29, x30, [sp, #144]\n"
+    "  add sp, sp, #160\n"
+    "  ret\n"
+    ".size sys_real_fiber_switch, .-sys_real_fiber_switch\n");
+
+static SysPointer sys_real_fiber_switch_prepare(SysPointer top, SysFiberEntry entry) {
+  SysUInt64 *sp = (SysUInt64 *)((SysUIntPtr)top & ~(SysUIntPtr)15);
+  SysUInt i;
+
+  /* 20 saved registers, x30 last, all zero but the link register */
+  sp -= 20;
+  for (i = 0; i < 19; i++) {
+    sp[i] = 0;
+  }
+  sp[19] = (SysUInt64)(SysUIntPtr)entry;
+
+  return sp;
+}
+
+#else
+/* r4 - r12 and lr, then d8 - d15. r12 is only pushed to keep the 8
+ * byte stack alignment, popping into pc returns to the saved lr and
+ * switches between ARM and Thumb as its low bit says */
+__asm__(
+    ".text\n"
+    ".syntax unified\n"
+#if defined(__thumb__)
+    ".thumb\n"
+#else
+    ".arm\n"
+#endif
+    ".globl sys_real_fiber_switch\n"
+    ".hidden sys_real_fiber_switch\n"
+    ".type sys_real_fiber_switch, %function\n"
+    ".p2align 2\n"
+#if defined(__thumb__)
+    ".thumb_func\n"
+#endif
+    "sys_real_fiber_switch:\n"
+    "  push {r4-r12, lr}\n"
+    "  vpush {d8-d15}\n"
+    "  mov r2, sp\n"
+    "  str r2, [r0]\n"
+    "  mov sp, r1\n"
+    "  vpop {d8-d15}\n"
+    "  pop {r4-r12, pc}\n"
+    ".size sys_real_fiber_switch, .-sys_real_fiber_switch\n");
+
+static SysPointer sys_real_fiber_switch_prepare(SysPointer top, SysFiberEntry entry) {
+  SysUInt32 *sp = (SysUInt32 *)((SysUIntPtr)top & ~(SysUIntPtr)7);
+  SysUInt i;
+
+  /* 16 words of d8 - d15, 9 of r4 - r12, lr last */
+  sp -= 26;
+  for (i = 0; i < 25; i++) {
+    sp[i] = 0;
+  }
+  sp[25] = (SysUInt32)(SysUIntPtr)entry;
+
+  return sp;
+}
+#endif
+#endif
+
+#endif
@@ -0,0 +1,222 @@
+#include <System/Platform/Common/SysRcu.h>
+#include <System/Platform/Common/SysMem.h>
+
+typedef struct _SysRcuReader SysRcuReader;
+typedef struct _SysRcuCallback SysRcuCallback;
+
+struct _SysRcuReader {
+  SysRcuReader *next;
+  /* epoch seen on entry, 0 outside of a read section */
+  SysInt state;
+  SysInt in_use;
+  SysInt nesting;
+};
+
+struct _SysRcuCallback {
+  SysRcuCallback *next;
+  SysDestroyFunc func;
+  SysPointer data;
+  SysInt epoch;
+};
+
+static void rcu_reader_release(SysPointer data);
+
+static SysMutex rcu_lock;
+static SysRcuReader *rcu_readers = NULL;
+/* odd and moving by two so a reader state is never 0 */
+static SysInt rcu_epoch = 1;
+/* oldest first, epochs never decrease along the list */
+static SysRcuCallback *rcu_callbacks = NULL;
+static SysRcuCallback **rcu_callbacks_tail = &rcu_callbacks;
+SYS_THREAD_LOCAL_DEFINE_STATIC(rcu_private, rcu_reader_release);
+
+static void rcu_reader_release(SysPointer data) {
+  SysRcuReader *reader = data;
+
+  reader->nesting = 0;
+  sys_atomic_int_set(&reader->state, 0);
+  sys_atomic_int_set(&reader->in_use, 0);
+}
+
+static SysRcuReader *rcu_reader_get(void) {
+  SysRcuReader *reader = sys_thread_local_get(&rcu_private);
+
+  if (reader != NULL) {
+    return reader;
+  }
+
+  sys_mutex_lock(&rcu_lock);
+  for (reader = rcu_readers; reader; reader = reader->next) {
+    if (!sys_atomic_int_get(&reader->in_use)) {
+      break;
+    }
+  }
+
+  if (reader == NULL) {
+    reader = sys_new0(SysRcuReader, 1);
+    reader->next = rcu_readers;
+    rcu_readers = reader;
+  }
+
+  sys_atomic_int_set(&reader->in_use, 1);
+  sys_mutex_unlock(&rcu_lock);
+
+  sys_thread_local_set(&rcu_private, reader);
+
+  return reader;
+}
+
+/* the epoch moves on once every active reader has observed it,
+ * must be called with rcu_lock held */
+static SysBool rcu_try_advance(void) {
+  SysRcuReader *reader;
+  SysInt epoch, state;
+
+  epoch = sys_atomic_int_get(&rcu_epoch);
+  for (reader = rcu_readers; reader; reader = reader->next) {
+    state = sys_atomic_int_get(&reader->state);
+
+    if (state != 0 && state != epoch) {
+      return false;
+    }
+  }
+
+  sys_atomic_int_set(&rcu_epoch, epoch + 2);
+
+  return true;
+}
+
+/* nothing retired at @epoch is reachable by readers two epochs later */
+static SysBool rcu_is_safe(SysInt epoch, SysInt now) {
+  return (SysUInt)now - (SysUInt)epoch >= 4;
+}
+
+/* unlinks the callbacks that became safe, must be called with rcu_lock held */
+static SysRcuCallback *rcu_take_ready(void) {
+  SysRcuCallback *ready = rcu_callbacks;
+  SysRcuCallback **link = &rcu_callbacks;
+  SysInt now = sys_atomic_int_get(&rcu_epoch);
+
+  while (*link && rcu_is_safe((*link)->epoch, now)) {
+    link = &(*link)->next;
+  }
+
+  if (link == &rcu_callbacks) {
+    return NULL;
+  }
+
+  rcu_callbacks = *link;
+  *link = NULL;
+  if (rcu_callbacks == NULL) {
+    rcu_callbacks_tail = &rcu_callbacks;
+  }
+
+  return ready;
+}
+
+static void rcu_run(SysRcuCallback *cb) {
+  SysRcuCallback *next;
+
+  for (; cb; cb = next) {
+    next = cb->next;
+
+    cb->func(cb->data);
+    sys_slice_free(SysRcuCallback, cb);
+  }
+}
+
+/**
+ * sys_rcu_read_lock:
+ *
+ * Enters a read section, data reached through sys_rcu_dereference()
+ * stays valid until the matching sys_rcu_read_unlock(). Sections nest
+ * and must not block on a writer that waits in sys_rcu_synchronize().
+ */
+void sys_rcu_read_lock(void) {
+  SysRcuReader *reader = rcu_reader_get();
+
+  if (reader->nesting++ == 0) {
+    sys_atomic_int_set(&reader->state, sys_atomic_int_get(&rcu_epoch));
+  }
+}
+
+void sys_rcu_read_unlock(void) {
+  SysRcuReader *reader = sys_thread_local_get(&rcu_private);
+
+  sys_return_if_fail(reader != NULL && reader->nesting > 0);
+
+  if (--reader->nesting == 0) {
+    sys_atomic_int_set(&reader->state, 0);
+  }
+}
+
+SysBool sys_rcu_in_read_section(void) {
+  SysRcuReader *reader = sys_thread_local_get(&rcu_private);
+
+  return reader != NULL && reader->nesting > 0;
+}
+
+/**
+ * sys_rcu_call:
+ * @func: destroy function
+ * @data: data already unreachable for new readers
+ *
+ * Calls @func on @data once no read section that started before this
+ * call is left. Ready callbacks of earlier calls run from here, so
+ * @func may be called on any writer thread.
+ */
+void sys_rcu_call(SysDestroyFunc func, SysPointer data) {
+  SysRcuCallback *cb, *ready;
+
+  sys_return_if_fail(func != NULL);
+
+  cb = sys_slice_new(SysRcuCallback);
+  cb->next = NULL;
+  cb->func = func;
+  cb->data = data;
+
+  sys_mutex_lock(&rcu_lock);
+
+  cb->epoch = sys_atomic_int_get(&rcu_epoch);
+  *rcu_callbacks_tail = cb;
+  rcu_callbacks_tail = &cb->next;
+
+  rcu_try_advance();
+  ready = rcu_take_ready();
+
+  sys_mutex_unlock(&rcu_lock);
+
+  rcu_run(ready);
+}
+
+/**
+ * sys_rcu_synchronize:
+ *
+ * Waits until every read section that started before the call is left
+ * and runs the callbacks queued so far. Must not be called inside a
+ * read section.
+ */
+void sys_rcu_synchronize(void) {
+  SysRcuCallback *ready;
+  SysInt target;
+  SysBool advanced;
+
+  sys_return_if_fail(!sys_rcu_in_read_section());
+
+  target = sys_atomic_int_get(&rcu_epoch);
+  while (!rcu_is_safe(target, sys_atomic_int_get(&rcu_epoch))) {
+    sys_mutex_lock(&rcu_lock);
+    advanced = rcu_try_advance();
+    sys_mutex_unlock(&rcu_lock);
+
+    if (!advanced) {
+      sys_thread_yield();
+    }
+  }
+
+  sys_mutex_lock(&rcu_lock);
+  ready = rcu_take_ready();
+  sys_mutex_unlock(&rcu_lock);
+
+  rcu_run(ready);
+}
@@ -0,0 +1,36 @@
+#ifndef __SYS_RCU_H__
+#define __SYS_RCU_H__
+
+#include <System/Platform/Common/SysThread.h>
+#include <System/Platform/Common/SysAtomic.h>
+
+SYS_BEGIN_DECLS
+
+/**
+ * SysRcu: read-copy-update with epoch based reclamation.
+ *
+ * Readers of a shared structure wrap their access in
+ * sys_rcu_read_lock() and sys_rcu_read_unlock(), which only store the
+ * current epoch in a per-thread record, and load the published pointer
+ * with sys_rcu_dereference(). Writers build a new version, publish it
+ * with sys_rcu_assign_pointer() and hand the old one to sys_rcu_call(),
+ * which runs the destroy function once every reader that could still
+ * see it has left its read section.
+ *
+ * Threads register themselves on their first read section, the record
+ * is given back through #SysPrivate when the thread exits.
+ */
+
+#define sys_rcu_dereference(p) sys_atomic_pointer_get(&(p))
+#define sys_rcu_assign_pointer(p, v) sys_atomic_pointer_set(&(p), (v))
+
+SYS_API void sys_rcu_read_lock(void);
+SYS_API void sys_rcu_read_unlock(void);
+SYS_API SysBool sys_rcu_in_read_section(void);
+
+SYS_API void sys_rcu_call(SysDestroyFunc func, SysPointer data);
+SYS_API void sys_rcu_synchronize(void);
+
+SYS_END_DECLS
+
+#endif
@@ -0,0 +1,294 @@
+#include <System/Platform/Common/SysSync.h>
+#include <System/Platform/Common/SysThreadPrivate.h>
+#include <System/Platform/Common/SysAtomic.h>
+
+/* rounds of sys_cpu_relax () before a phase waiter goes to sleep, the
+ * other threads of a parallel phase usually arrive within that time */
+#define SYS_SYNC_SPIN 128
+
+/* SysBarrier {{{1 --------------------------------------------------------- */
+
+void sys_barrier_init (SysBarrier *barrier, SysUInt count) {
+  sys_return_if_fail (barrier != NULL);
+  sys_return_if_fail (count > 0);
+
+  barrier->count = count;
+  barrier->arrived = 0;
+  barrier->generation = 0;
+}
+
+void sys_barrier_clear (SysBarrier *barrier) {
+  sys_return_if_fail (barrier != NULL);
+
+  if (sys_atomic_uint_load (&barrier->arrived, SYS_ATOMIC_RELAXED) != 0)
+    sys_warning_N ("%s", "barrier cleared with threads waiting on it");
+}
+
+/**
+ * sys_barrier_wait:
+ * @barrier: a #SysBarrier
+ *
+ * Blocks until @count threads called it for the current generation.
+ *
+ * Returns: %true in exactly one of the released threads, which can do
+ *   the serial part of the phase
+ */
+SysBool sys_barrier_wait (SysBarrier *barrier) {
+  SysUInt generation;
+  SysInt spin;
+
+  sys_return_val_if_fail (barrier != NULL, false);
+
+  /* read before arriving, the last thread bumps it only after that */
+  generation = sys_atomic_uint_load (&barrier->generation, SYS_ATOMIC_ACQUIRE);
+
+  if (sys_atomic_uint_fetch_add (&barrier->arrived, 1, SYS_ATOMIC_ACQ_REL) + 1 == barrier->count) {
+    /* nobody arrives for the next generation before it is published */
+    sys_atomic_uint_store (&barrier->arrived, 0, SYS_ATOMIC_RELAXED);
+    sys_atomic_uint_fetch_add (&barrier->generation, 1, SYS_ATOMIC_RELEASE);
+    sys_system_futex_wake (&barrier->generation, true);
+
+    return true;
+  }
+
+  for (spin = 0; spin < SYS_SYNC_SPIN; spin++) {
+    if (sys_atomic_uint_load (&barrier->generation, SYS_ATOMIC_ACQUIRE) != generation)
+      return false;
+
+    sys_cpu_relax ();
+  }
+
+  while (sys_atomic_uint_load (&barrier->generation, SYS_ATOMIC_ACQUIRE) == generation)
+    sys_system_futex_wait (&barrier->generation, generation, -1);
+
+  return false;
+}
+
+/* SysLatch {{{1 ----------------------------------------------------------- */
+
+void sys_latch_init (SysLatch *latch, SysUInt count) {
+  sys_return_if_fail (latch != NULL);
+
+  latch->count = count;
+}
+
+void sys_latch_clear (SysLatch *latch) {
+  sys_return_if_fail (latch != NULL);
+}
+
+/**
+ * sys_latch_count_down:
+ * @latch: a #SysLatch
+ * @n: how much to count down
+ *
+ * Releases the waiters when the count reaches zero. Counting below zero
+ * is a bug of the caller, it warns and leaves the count as it is.
+ */
+void sys_latch_count_down (SysLatch *latch, SysUInt n) {
+  SysUInt old;
+
+  sys_return_if_fail (latch != NULL);
+  sys_return_if_fail (n > 0);
+
+  /* never below zero, a wrapped count would block the waiters forever */
+  old = sys_atomic_uint_load (&latch->count, SYS_ATOMIC_RELAXED);
+  do {
+    if SYS_UNLIKELY (old < n) {
+      sys_warning_N ("latch counted down by %u with %u left", n, old);
+      return;
+    }
+  } while (!sys_atomic_uint_compare_exchange (&latch->count, &old, old - n, SYS_ATOMIC_ACQ_REL));
+
+  if (old == n)
+    sys_system_futex_wake (&latch->count, true);
+}
+
+SysBool sys_latch_try_wait (SysLatch *latch) {
+  sys_return_val_if_fail (latch != NULL, false);
+
+  return sys_atomic_uint_load (&latch->count, SYS_ATOMIC_ACQUIRE) == 0;
+}
+
+/**
+ * sys_latch_wait_until:
+ * @latch: a #SysLatch
+ * @end_time: monotonic time to give up at
+ *
+ * Returns: %true once the latch reached zero, %false on timeout
+ */
+SysBool sys_latch_wait_until (SysLatch *latch, SysInt64 end_time) {
+  SysUInt count;
+  SysInt spin;
+
+  sys_return_val_if_fail (latch != NULL, false);
+
+  for (spin = 0; spin < SYS_SYNC_SPIN; spin++) {
+    if (sys_atomic_uint_load (&latch->count, SYS_ATOMIC_ACQUIRE) == 0)
+      return true;
+
+    sys_cpu_relax ();
+  }
+
+  while ((count = sys_atomic_uint_load (&latch->count, SYS_ATOMIC_ACQUIRE)) != 0) {
+    if (!sys_system_futex_wait (&latch->count, count, end_time))
+      return sys_latch_try_wait (latch);
+  }
+
+  return true;
+}
+
+void sys_latch_wait (SysLatch *latch) {
+  sys_latch_wait_until (latch, -1);
+}
+
+void sys_latch_arrive_and_wait (SysLatch *latch) {
+  sys_latch_count_down (latch, 1);
+  sys_latch_wait_until (latch, -1);
+}
+
+/* SysSemaphore {{{1 ------------------------------------------------------- */
+
+void sys_semaphore_init (SysSemaphore *sem, SysUInt value) {
+  sys_return_if_fail (sem != NULL);
+
+  sem->value = value;
+  sem->waiters = 0;
+}
+
+void sys_semaphore_clear (SysSemaphore *sem) {
+  sys_return_if_fail (sem != NULL);
+
+  if (sys_atomic_uint_load (&sem->waiters, SYS_ATOMIC_RELAXED) != 0)
+    sys_warning_N ("%s", "semaphore cleared with threads waiting on it");
+}
+
+/* posters check for waiters after raising the value and waiters count
+ * themselves before sleeping on it, both sequentially consistent, so
+ * one of the two always sees the other */
+void sys_semaphore_post (SysSemaphore *sem) {
+  sys_return_if_fail (sem != NULL);
+
+  sys_atomic_uint_fetch_add (&sem->value, 1, SYS_ATOMIC_SEQ_CST);
+  if (sys_atomic_uint_load (&sem->waiters, SYS_ATOMIC_SEQ_CST) != 0)
+    sys_system_futex_wake (&sem->value, false);
+}
+
+SysBool sys_semaphore_try_wait (SysSemaphore *sem) {
+  SysUInt value;
+
+  sys_return_val_if_fail (sem != NULL, false);
+
+  value = sys_atomic_uint_load (&sem->value, SYS_ATOMIC_RELAXED);
+  while (value > 0) {
+    if (sys_atomic_uint_compare_exchange (&sem->value, &value, value - 1, SYS_ATOMIC_ACQUIRE))
+      return true;
+  }
+
+  return false;
+}
+
+/**
+ * sys_semaphore_wait_until:
+ * @sem: a #SysSemaphore
+ * @end_time: monotonic time to give up at
+ *
+ * Returns: %true when a unit was taken, %false on timeout
+ */
+SysBool sys_semaphore_wait_until (SysSemaphore *sem, SysInt64 end_time) {
+  SysBool woken;
+
+  sys_return_val_if_fail (sem != NULL, false);
+
+  while (!sys_semaphore_try_wait (sem)) {
+    sys_atomic_uint_fetch_add (&sem->waiters, 1, SYS_ATOMIC_SEQ_CST);
+    woken = sys_system_futex_wait (&sem->value, 0, end_time);
+    sys_atomic_uint_fetch_sub (&sem->waiters, 1, SYS_ATOMIC_RELAXED);
+
+    if (!woken)
+      return sys_semaphore_try_wait (sem);
+  }
+
+  return true;
+}
+
+void sys_semaphore_wait (SysSemaphore *sem) {
+  sys_semaphore_wait_until (sem, -1);
+}
+
+/* SysEvent {{{1 ----------------------------------------------------------- */
+
+void sys_event_init (SysEvent *event, SysBool auto_reset) {
+  sys_return_if_fail (event != NULL);
+
+  event->state = 0;
+  event->auto_reset = auto_reset ? 1 : 0;
+  event->waiters = 0;
+}
+
+void sys_event_clear (SysEvent *event) {
+  sys_return_if_fail (event != NULL);
+
+  if (sys_atomic_uint_load (&event->waiters, SYS_ATOMIC_RELAXED) != 0)
+    sys_warning_N ("%s", "event cleared with threads waiting on it");
+}
+
+/* same waiter accounting as SysSemaphore */
+void sys_event_set (SysEvent *event) {
+  sys_return_if_fail (event != NULL);
+
+  sys_atomic_uint_exchange (&event->state, 1, SYS_ATOMIC_SEQ_CST);
+  if (sys_atomic_uint_load (&event->waiters, SYS_ATOMIC_SEQ_CST) != 0)
+    sys_system_futex_wake (&event->state, !event->auto_reset);
+}
+
+void sys_event_reset (SysEvent *event) {
+  sys_return_if_fail (event != NULL);
+
+  sys_atomic_uint_store (&event->state, 0, SYS_ATOMIC_RELEASE);
+}
+
+SysBool sys_event_is_set (SysEvent *event) {
+  sys_return_val_if_fail (event != NULL, false);
+
+  return sys_atomic_uint_load (&event->state, SYS_ATOMIC_ACQUIRE) != 0;
+}
+
+static SysBool sys_event_take (SysEvent *event) {
+  SysUInt state = 1;
+
+  if (event->auto_reset)
+    return sys_atomic_uint_compare_exchange (&event->state, &state, 0, SYS_ATOMIC_ACQUIRE);
+
+  return sys_atomic_uint_load (&event->state, SYS_ATOMIC_ACQUIRE) != 0;
+}
+
+/**
+ * sys_event_wait_until:
+ * @event: a #SysEvent
+ * @end_time: monotonic time to give up at
+ *
+ * Waits for @event to be set, an auto reset event is cleared again by
+ * the thread it releases.
+ *
+ * Returns: %true when released, %false on timeout
+ */
+SysBool sys_event_wait_until (SysEvent *event, SysInt64 end_time) {
+  SysBool woken;
+
+  sys_return_val_if_fail (event != NULL, false);
+
+  while (!sys_event_take (event)) {
+    sys_atomic_uint_fetch_add (&event->waiters, 1, SYS_ATOMIC_SEQ_CST);
+    woken = sys_system_futex_wait (&event->state, 0, end_time);
+    sys_atomic_uint_fetch_sub (&event->waiters, 1, SYS_ATOMIC_RELAXED);
+
+    if (!woken)
+      return sys_event_take (event);
+  }
+
+  return true;
+}
+
+void sys_event_wait (SysEvent *event) {
+  sys_event_wait_until (event, -1);
+}
@@ -0,0 +1,102 @@
+#ifndef __SYS_SYNC_H__
+#define __SYS_SYNC_H__
+
+#include <System/Platform/Common/SysThread.h>
+
+SYS_BEGIN_DECLS
+
+/**
+ * SysSync: thread coordination primitives on a futex word.
+ *
+ * Like #SysMutex they need no allocation: embed them, initialize them
+ * with their init function or their static initializer and clear them
+ * when done. Waiting threads sleep in the kernel on the word itself,
+ * an uncontended call is a single atomic operation.
+ *
+ * Times are absolute, in the sys_get_monotonic_time() clock.
+ */
+
+typedef struct _SysBarrier        SysBarrier;
+typedef struct _SysLatch          SysLatch;
+typedef struct _SysSemaphore      SysSemaphore;
+typedef struct _SysEvent          SysEvent;
+
+/**
+ * SysBarrier: reusable rendezvous of a fixed number of threads.
+ *
+ * The last thread to arrive starts a new generation, which releases
+ * the others, so the same barrier serves every phase of a loop.
+ */
+#define SYS_BARRIER_INIT(count) { (count), 0, 0 }
+struct _SysBarrier {
+  /*< private >*/
+  SysUInt count;
+  SysUInt arrived;
+  SysUInt generation;
+};
+
+/**
+ * SysLatch: single use countdown, waiters are released once it reaches
+ * zero and never block again.
+ */
+#define SYS_LATCH_INIT(count) { (count) }
+struct _SysLatch {
+  /*< private >*/
+  SysUInt count;
+};
+
+/**
+ * SysSemaphore: counting semaphore.
+ */
+#define SYS_SEMAPHORE_INIT(value) { (value), 0 }
+struct _SysSemaphore {
+  /*< private >*/
+  SysUInt value;
+  SysUInt waiters;
+};
+
+/**
+ * SysEvent: signal state threads wait for.
+ *
+ * A manual reset event stays set and releases every waiter until
+ * sys_event_reset(), an auto reset event releases a single waiter and
+ * clears itself.
+ */
+#define SYS_EVENT_INIT(auto_reset) { 0, (auto_reset) ? 1 : 0, 0 }
+struct _SysEvent {
+  /*< private >*/
+  SysUInt state;
+  SysUInt auto_reset;
+  SysUInt waiters;
+};
+
+SYS_API void sys_barrier_init (SysBarrier *barrier, SysUInt count);
+SYS_API void sys_barrier_clear (SysBarrier *barrier);
+SYS_API SysBool sys_barrier_wait (SysBarrier *barrier);
+
+SYS_API void sys_latch_init (SysLatch *latch, SysUInt count);
+SYS_API void sys_latch_clear (SysLatch *latch);
+SYS_API void sys_latch_count_down (SysLatch *latch, SysUInt n);
+SYS_API SysBool sys_latch_try_wait (SysLatch *latch);
+SYS_API void sys_latch_wait (SysLatch *latch);
+SYS_API SysBool sys_latch_wait_until (SysLatch *latch, SysInt64 end_time);
+SYS_API void sys_latch_arrive_and_wait (SysLatch *latch);
+
+SYS_API void sys_semaphore_init (SysSemaphore *sem, SysUInt value);
+SYS_API void sys_semaphore_clear (SysSemaphore *sem);
+SYS_API void sys_semaphore_post (SysSemaphore *sem);
+SYS_API SysBool sys_semaphore_try_wait (SysSemaphore *sem);
+SYS_API void sys_semaphore_wait (SysSemaphore *sem);
+SYS_API SysBool sys_semaphore_wait_until (SysSemaphore *sem, SysInt64 end_time);
+
+SYS_API void sys_event_init (SysEvent *event, SysBool auto_reset);
+SYS_API void sys_event_clear (SysEvent *event);
+SYS_API void sys_event_set (SysEvent *event);
+SYS_API void sys_event_reset (SysEvent *event);
+SYS_API SysBool sys_event_is_set (SysEvent *event);
+SYS_API void sys_event_wait (SysEvent *event);
+SYS_API SysBool sys_event_wait_until (SysEvent *event, SysInt64 end_time);
+
+SYS_END_DECLS
+
+#endif
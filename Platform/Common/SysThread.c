@@ -1,6 +1,16 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <System/Platform/Common/SysThreadPrivate.h>
 #include <System/DataTypes/SysSList.h>
 #include <System/Utils/SysString.h>
+#include <System/Utils/SysFile.h>
+#include <System/Platform/Common/SysAtomic.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
 
 /**
  * this code from glib Thread
@@ -15,7 +25,7 @@ static SysSList   *sys_once_init_list = NULL;
 static SysInt sys_thread_n_created_counter = 0;  /* (atomic) */
 
 static void sys_thread_cleanup (SysPointer data);
-static SysPrivate     sys_thread_specific_private = SYS_PRIVATE_INIT (sys_thread_cleanup);
+SYS_THREAD_LOCAL_DEFINE_STATIC (sys_thread_specific_private, sys_thread_cleanup);
 
 /* SysOnce {{{1 ------------------------------------------------------------- */
 SysPointer sys_once_impl (SysOnce *once, SysThreadFunc func, SysPointer arg) {
@@ -78,6 +88,223 @@ void _sys_once_init_leave (volatile SysPointer location, SysSize          result
   sys_mutex_unlock (&sys_once_mutex);
 }
 
+/* SysPrivate {{{1 --------------------------------------------------------- */
+
+#if defined(SYS_THREAD_LOCAL)
+/* Each key gets a dense index on first use and every thread keeps its
+ * values in an array indexed by it, a lookup is the index and the slot.
+ * Only one native key is left, its destructor runs the notify functions
+ * of a thread when it exits, for SysThreadLocal values too. */
+
+#define SYS_PRIVATE_MAX 1024
+#define SYS_PRIVATE_DESTRUCTOR_ITERATIONS 4
+
+typedef struct _SysThreadSlots SysThreadSlots;
+struct _SysThreadSlots {
+  SysPointer *slots;
+  SysUInt n_slots;
+  SysThreadLocal **locals;
+  SysUInt n_locals;
+  SysUInt locals_size;
+  SysBool registered;
+};
+
+static void sys_thread_slots_free (SysPointer data);
+
+static SysPrivate sys_thread_slots_private = SYS_PRIVATE_INIT (sys_thread_slots_free);
+static SYS_THREAD_LOCAL SysThreadSlots sys_thread_slots;
+
+static SysMutex sys_private_keys_lock;
+static SysPrivate *sys_private_keys[SYS_PRIVATE_MAX];
+static SysUInt sys_private_n_keys;
+
+static void sys_thread_slots_free (SysPointer data) {
+  SysThreadSlots *t = data;
+  SysThreadLocal *tls;
+  SysDestroyFunc notify;
+  SysPointer value;
+  SysBool again = true;
+  SysUInt i, pass;
+
+  /* a notify may set values again, give it a few rounds as POSIX does */
+  for (pass = 0; again && pass < SYS_PRIVATE_DESTRUCTOR_ITERATIONS; pass++) {
+    again = false;
+
+    for (i = 0; i < t->n_slots; i++) {
+      value = t->slots[i];
+      if (value == NULL)
+        continue;
+
+      t->slots[i] = NULL;
+      notify = sys_private_keys[i]->notify;
+      if (notify != NULL) {
+        notify (value);
+        again = true;
+      }
+    }
+
+    for (i = 0; i < t->n_locals; i++) {
+      tls = t->locals[i];
+      value = tls->value;
+      if (value == NULL)
+        continue;
+
+      tls->value = NULL;
+      tls->notify (value);
+      again = true;
+    }
+  }
+
+  for (i = 0; i < t->n_locals; i++)
+    t->locals[i]->registered = false;
+
+  free (t->slots);
+  free (t->locals);
+  memset (t, 0, sizeof (*t));
+}
+
+static void sys_thread_slots_register (SysThreadSlots *t) {
+  if (t->registered)
+    return;
+
+  t->registered = true;
+  sys_system_private_set (&sys_thread_slots_private, t);
+}
+
+static SysUInt sys_private_index_new (SysPrivate *key) {
+  SysUIntPtr index;
+
+  sys_mutex_lock (&sys_private_keys_lock);
+
+  index = (SysUIntPtr) key->p;
+  if (index == 0) {
+    if SYS_UNLIKELY (sys_private_n_keys == SYS_PRIVATE_MAX)
+      sys_abort_N ("more than %d SysPrivate keys", SYS_PRIVATE_MAX);
+
+    sys_private_keys[sys_private_n_keys] = key;
+    index = ++sys_private_n_keys;
+    sys_atomic_pointer_store (&key->p, (SysPointer) index, SYS_ATOMIC_RELEASE);
+  }
+
+  sys_mutex_unlock (&sys_private_keys_lock);
+
+  return (SysUInt) index - 1;
+}
+
+static inline SysUInt sys_private_index (SysPrivate *key) {
+  SysUIntPtr index = (SysUIntPtr) sys_atomic_pointer_load (&key->p, SYS_ATOMIC_ACQUIRE);
+
+  if SYS_UNLIKELY (index == 0)
+    return sys_private_index_new (key);
+
+  return (SysUInt) index - 1;
+}
+
+static SysPointer *sys_private_slot (SysPrivate *key) {
+  SysThreadSlots *t = &sys_thread_slots;
+  SysUInt index = sys_private_index (key);
+  SysUInt n;
+
+  if SYS_UNLIKELY (index >= t->n_slots) {
+    n = t->n_slots ? t->n_slots : 8;
+    while (n <= index)
+      n <<= 1;
+
+    t->slots = realloc (t->slots, n * sizeof (SysPointer));
+    if SYS_UNLIKELY (t->slots == NULL)
+      sys_abort_N ("%s", "out of memory for thread slots");
+
+    memset (t->slots + t->n_slots, 0, (n - t->n_slots) * sizeof (SysPointer));
+    t->n_slots = n;
+    sys_thread_slots_register (t);
+  }
+
+  return &t->slots[index];
+}
+
+/**
+ * sys_private_get:
+ * @key: a #SysPrivate
+ *
+ * Returns: the value of @key in the current thread, %NULL if it was
+ *   never set in this thread
+ */
+SysPointer sys_private_get (SysPrivate *key) {
+  SysThreadSlots *t = &sys_thread_slots;
+  SysUInt index = sys_private_index (key);
+
+  if SYS_LIKELY (index < t->n_slots)
+    return t->slots[index];
+
+  return NULL;
+}
+
+/**
+ * sys_private_set:
+ * @key: a #SysPrivate
+ * @value: the new value
+ *
+ * Sets @key in the current thread, the old value is not notified.
+ */
+void sys_private_set (SysPrivate *key, SysPointer value) {
+  *sys_private_slot (key) = value;
+}
+
+/**
+ * sys_private_replace:
+ * @key: a #SysPrivate
+ * @value: the new value
+ *
+ * Sets @key in the current thread and runs the #SysDestroyFunc of @key
+ * on the old value, if any.
+ */
+void sys_private_replace (SysPrivate *key, SysPointer value) {
+  SysPointer *slot = sys_private_slot (key);
+  SysPointer old = *slot;
+
+  *slot = value;
+  if (old && key->notify)
+    key->notify (old);
+}
+
+/**
+ * sys_thread_local_register:
+ * @tls: a #SysThreadLocal
+ *
+ * Called by sys_thread_local_set() the first time a thread sets @tls,
+ * so its notify function runs when the thread exits.
+ */
+void sys_thread_local_register (SysThreadLocal *tls) {
+  SysThreadSlots *t = &sys_thread_slots;
+
+  if (tls->registered)
+    return;
+
+  if (t->n_locals == t->locals_size) {
+    t->locals_size = t->locals_size ? t->locals_size * 2 : 8;
+    t->locals = realloc (t->locals, t->locals_size * sizeof (SysThreadLocal *));
+    if SYS_UNLIKELY (t->locals == NULL)
+      sys_abort_N ("%s", "out of memory for thread slots");
+  }
+
+  t->locals[t->n_locals++] = tls;
+  tls->registered = true;
+  sys_thread_slots_register (t);
+}
+#else
+SysPointer sys_private_get (SysPrivate *key) {
+  return sys_system_private_get (key);
+}
+
+void sys_private_set (SysPrivate *key, SysPointer value) {
+  sys_system_private_set (key, value);
+}
+
+void sys_private_replace (SysPrivate *key, SysPointer value) {
+  sys_system_private_replace (key, value);
+}
+#endif
+
 /* SysThread  */
 void sys_thread_init(void) {
   sys_system_thread_init();
@@ -115,7 +342,7 @@ SysPointer sys_thread_proxy (SysPointer data) {
   SysRealThread* thread = data;
 
   sys_assert (data);
-  sys_private_set (&sys_thread_specific_private, data);
+  sys_thread_local_set (&sys_thread_specific_private, data);
 
   if (thread->name)
     {
@@ -137,7 +364,7 @@ SysThread * sys_thread_new (const SysChar *name, SysThreadFunc  func, SysPointer
   SysError *error = NULL;
   SysThread *thread;
 
-  thread = sys_thread_new_internal (name, sys_thread_proxy, func, data, 0, &error);
+  thread = sys_thread_new_internal (name, sys_thread_proxy, func, data, NULL, &error);
 
   if SYS_UNLIKELY (thread == NULL)
     sys_error_N ("creating thread '%s': %s", name ? name : "", error->message);
@@ -149,20 +376,67 @@ SysThread * sys_thread_try_new (const SysChar  *name,
                   SysThreadFunc   func,
                   SysPointer      data,
                   SysError      **error) {
-  return sys_thread_new_internal (name, sys_thread_proxy, func, data, 0, error);
+  return sys_thread_new_internal (name, sys_thread_proxy, func, data, NULL, error);
+}
+
+/**
+ * sys_thread_new_full:
+ * @name: (nullable): thread name
+ * @func: function run by the thread
+ * @data: argument of @func
+ * @options: (nullable): creation attributes, %NULL for the defaults
+ * @error: return location for a #SysError
+ *
+ * Like sys_thread_try_new(), but lets latency critical workers pick
+ * their CPUs, stack and scheduling before their first instruction.
+ * Real time policies usually need privileges, the call fails instead of
+ * silently running the thread with the default policy.
+ *
+ * Returns: the new thread or %NULL on error
+ */
+SysThread * sys_thread_new_full (const SysChar *name,
+                  SysThreadFunc   func,
+                  SysPointer      data,
+                  const SysThreadOptions *options,
+                  SysError      **error) {
+  return sys_thread_new_internal (name, sys_thread_proxy, func, data, options, error);
+}
+
+/**
+ * sys_thread_set_affinity:
+ * @thread: a #SysThread, sys_thread_self() for the calling thread
+ * @cpus: CPUs @thread may run on
+ *
+ * Pins a running thread. Other threads than the calling one must have
+ * been created by sys_thread_new() or its variants.
+ *
+ * Returns: %true on success
+ */
+SysBool sys_thread_set_affinity (SysThread *thread, const SysCpuSet *cpus) {
+  SysRealThread *real = (SysRealThread *) thread;
+
+  sys_return_val_if_fail (thread != NULL, false);
+  sys_return_val_if_fail (cpus != NULL, false);
+
+  if (thread == sys_thread_self ())
+    return sys_system_thread_set_affinity (NULL, cpus);
+
+  sys_return_val_if_fail (real->ours, false);
+
+  return sys_system_thread_set_affinity (real, cpus);
 }
 
 SysThread * sys_thread_new_internal (const SysChar *name,
                        SysThreadFunc proxy,
                        SysThreadFunc func,
                        SysPointer data,
-                       SysSize stack_size,
+                       const SysThreadOptions *options,
                        SysError **error) {
   sys_return_val_if_fail (func != NULL, NULL);
 
   sys_atomic_int_inc (&sys_thread_n_created_counter);
 
-  return (SysThread *) sys_system_thread_new (proxy, stack_size, name, func, data, error);
+  return (SysThread *) sys_system_thread_new (proxy, options, name, func, data, error);
 }
 
 void sys_thread_exit (SysPointer retval) {
@@ -196,7 +470,7 @@ SysPointer sys_thread_join (SysThread *thread) {
 }
 
 SysThread* sys_thread_self (void) {
-  SysRealThread* thread = sys_private_get (&sys_thread_specific_private);
+  SysRealThread* thread = sys_thread_local_get (&sys_thread_specific_private);
 
   if (!thread)
     {
@@ -207,7 +481,7 @@ SysThread* sys_thread_self (void) {
       thread = sys_slice_new0 (SysRealThread);
       thread->ref_count = 1;
 
-      sys_private_set (&sys_thread_specific_private, thread);
+      sys_thread_local_set (&sys_thread_specific_private, thread);
     }
 
   return (SysThread*) thread;
@@ -265,3 +539,932 @@ SysUInt sys_get_num_processors (void) {
   return 1; /* Fallback */
 }
 
+
+/* SysCpuSet {{{1 ---------------------------------------------------------- */
+
+void sys_cpu_set_zero (SysCpuSet *set) {
+  sys_return_if_fail (set != NULL);
+
+  memset (set, 0, sizeof (*set));
+}
+
+void sys_cpu_set_add (SysCpuSet *set, SysInt cpu) {
+  sys_return_if_fail (set != NULL);
+  sys_return_if_fail (cpu >= 0 && cpu < SYS_CPU_SET_MAX);
+
+  set->bits[cpu / 64] |= (SysUInt64) 1 << (cpu % 64);
+}
+
+void sys_cpu_set_remove (SysCpuSet *set, SysInt cpu) {
+  sys_return_if_fail (set != NULL);
+  sys_return_if_fail (cpu >= 0 && cpu < SYS_CPU_SET_MAX);
+
+  set->bits[cpu / 64] &= ~((SysUInt64) 1 << (cpu % 64));
+}
+
+SysBool sys_cpu_set_contains (const SysCpuSet *set, SysInt cpu) {
+  sys_return_val_if_fail (set != NULL, false);
+
+  if (cpu < 0 || cpu >= SYS_CPU_SET_MAX)
+    return false;
+
+  return (set->bits[cpu / 64] >> (cpu % 64)) & 1;
+}
+
+SysUInt sys_cpu_set_count (const SysCpuSet *set) {
+  SysUInt count = 0;
+  SysUInt i;
+  SysUInt64 word;
+
+  sys_return_val_if_fail (set != NULL, 0);
+
+  for (i = 0; i < SYS_CPU_SET_MAX / 64; i++) {
+    for (word = set->bits[i]; word != 0; word &= word - 1)
+      count++;
+  }
+
+  return count;
+}
+
+/* SysTopology {{{1 -------------------------------------------------------- */
+
+#if defined(__linux__)
+static SysBool sys_topology_read (const SysChar *path, SysChar *buf, SysInt size) {
+  FILE *fp;
+  SysBool ok;
+
+  fp = sys_fopen (path, "r");
+  if (fp == NULL)
+    return false;
+
+  ok = fgets (buf, size, fp) != NULL;
+  fclose (fp);
+
+  return ok;
+}
+
+static SysInt sys_topology_read_int (const SysChar *path, SysInt def) {
+  SysChar buf[32];
+
+  if (!sys_topology_read (path, buf, sizeof (buf)))
+    return def;
+
+  return (SysInt) strtol (buf, NULL, 10);
+}
+
+/* parses the kernel cpulist format: "0-3,8,10-11" */
+static SysBool sys_topology_read_list (const SysChar *path, SysCpuSet *set) {
+  SysChar buf[4096];
+  SysChar *p, *end;
+  long first, last;
+
+  sys_cpu_set_zero (set);
+  if (!sys_topology_read (path, buf, sizeof (buf)))
+    return false;
+
+  p = buf;
+  while (*p >= '0' && *p <= '9') {
+    first = strtol (p, &end, 10);
+    last = first;
+    if (*end == '-')
+      last = strtol (end + 1, &end, 10);
+
+    for (; first <= last && first < SYS_CPU_SET_MAX; first++)
+      sys_cpu_set_add (set, (SysInt) first);
+
+    p = *end == ',' ? end + 1 : end;
+  }
+
+  return true;
+}
+
+static SysUInt sys_topology_fill (SysCpuInfo *cpus) {
+  SysChar path[128];
+  SysCpuSet online, nodes, node_cpus;
+  SysUInt n = 0;
+  SysInt cpu, node;
+
+  if (!sys_topology_read_list ("/sys/devices/system/cpu/online", &online))
+    return 0;
+
+  for (cpu = 0; cpu < SYS_CPU_SET_MAX; cpu++) {
+    if (!sys_cpu_set_contains (&online, cpu))
+      continue;
+
+    cpus[n].cpu = cpu;
+    sys_snprintf (path, sizeof (path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+    cpus[n].core = sys_topology_read_int (path, cpu);
+    sys_snprintf (path, sizeof (path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+    cpus[n].package = sys_topology_read_int (path, 0);
+    cpus[n].node = 0;
+    n++;
+  }
+
+  /* the node list has the same format as a CPU list */
+  if (!sys_topology_read_list ("/sys/devices/system/node/online", &nodes))
+    return n;
+
+  for (node = 0; node < SYS_CPU_SET_MAX; node++) {
+    SysUInt i;
+
+    if (!sys_cpu_set_contains (&nodes, node))
+      continue;
+
+    sys_snprintf (path, sizeof (path), "/sys/devices/system/node/node%d/cpulist", node);
+    if (!sys_topology_read_list (path, &node_cpus))
+      continue;
+
+    for (i = 0; i < n; i++) {
+      if (sys_cpu_set_contains (&node_cpus, cpus[i].cpu))
+        cpus[i].node = node;
+    }
+  }
+
+  return n;
+}
+#elif defined(SYS_OS_WIN32)
+static SysUInt sys_topology_fill (SysCpuInfo *cpus) {
+  SYSTEM_LOGICAL_PROCESSOR_INFORMATION *info = NULL;
+  DWORD len = 0;
+  DWORD i, count;
+  SysInt core = 0, package = 0;
+  SysInt cpu;
+  SysUInt n = 0;
+
+  if (GetLogicalProcessorInformation (NULL, &len) || GetLastError () != ERROR_INSUFFICIENT_BUFFER)
+    return 0;
+
+  info = sys_malloc (len);
+  if (!GetLogicalProcessorInformation (info, &len)) {
+    sys_free (info);
+    return 0;
+  }
+
+  /* only processor group 0 is visible here, that is 64 CPUs at most */
+  for (cpu = 0; cpu < 64; cpu++)
+    cpus[cpu].cpu = -1;
+
+  count = len / sizeof (*info);
+  for (i = 0; i < count; i++) {
+    for (cpu = 0; cpu < 64 && cpu < (SysInt) sizeof (ULONG_PTR) * 8; cpu++) {
+      if (!((info[i].ProcessorMask >> cpu) & 1))
+        continue;
+
+      switch (info[i].Relationship) {
+        case RelationProcessorCore:
+          cpus[cpu].cpu = cpu;
+          cpus[cpu].core = core;
+          break;
+        case RelationProcessorPackage:
+          cpus[cpu].package = package;
+          break;
+        case RelationNumaNode:
+          cpus[cpu].node = (SysInt) info[i].NumaNode.NodeNumber;
+          break;
+        default:
+          break;
+      }
+    }
+
+    if (info[i].Relationship == RelationProcessorCore)
+      core++;
+    else if (info[i].Relationship == RelationProcessorPackage)
+      package++;
+  }
+  sys_free (info);
+
+  for (cpu = 0; cpu < 64; cpu++) {
+    if (cpus[cpu].cpu >= 0)
+      cpus[n++] = cpus[cpu];
+  }
+
+  return n;
+}
+#else
+static SysUInt sys_topology_fill (SysCpuInfo *cpus) {
+  UNUSED (cpus);
+
+  return 0;
+}
+#endif
+
+/**
+ * sys_get_topology:
+ *
+ * Describes the online logical CPUs: their core, package and NUMA node.
+ * When the system does not tell, every CPU is reported as its own core
+ * on a single package and node.
+ *
+ * Returns: (transfer full): a #SysTopology, free it with sys_topology_free()
+ */
+SysTopology *sys_get_topology (void) {
+  SysTopology *topology;
+  SysCpuInfo *cpus;
+  SysUInt n, i, j;
+  SysBool seen_core, seen_package, seen_node;
+
+  cpus = sys_new0 (SysCpuInfo, SYS_CPU_SET_MAX);
+  n = sys_topology_fill (cpus);
+
+  if (n == 0) {
+    n = sys_get_num_processors ();
+    if (n > SYS_CPU_SET_MAX)
+      n = SYS_CPU_SET_MAX;
+
+    for (i = 0; i < n; i++) {
+      cpus[i].cpu = (SysInt) i;
+      cpus[i].core = (SysInt) i;
+      cpus[i].package = 0;
+      cpus[i].node = 0;
+    }
+  }
+
+  topology = sys_new0 (SysTopology, 1);
+  topology->n_cpus = n;
+  topology->cpus = sys_new (SysCpuInfo, n);
+  memcpy (topology->cpus, cpus, n * sizeof (SysCpuInfo));
+  sys_free (cpus);
+
+  cpus = topology->cpus;
+  for (i = 0; i < n; i++) {
+    seen_core = seen_package = seen_node = false;
+
+    for (j = 0; j < i; j++) {
+      if (cpus[j].package == cpus[i].package) {
+        seen_package = true;
+        if (cpus[j].core == cpus[i].core)
+          seen_core = true;
+      }
+      if (cpus[j].node == cpus[i].node)
+        seen_node = true;
+    }
+
+    topology->n_cores += !seen_core;
+    topology->n_packages += !seen_package;
+    topology->n_nodes += !seen_node;
+  }
+
+  return topology;
+}
+
+void sys_topology_free (SysTopology *topology) {
+  sys_return_if_fail (topology != NULL);
+
+  sys_free (topology->cpus);
+  sys_free (topology);
+}
+
+/**
+ * sys_topology_get_siblings:
+ * @topology: a #SysTopology
+ * @cpu: a logical CPU number
+ * @siblings: (out): the CPUs of the core @cpu belongs to, @cpu included
+ */
+void sys_topology_get_siblings (SysTopology *topology, SysInt cpu, SysCpuSet *siblings) {
+  SysCpuInfo *info = NULL;
+  SysUInt i;
+
+  sys_return_if_fail (topology != NULL);
+  sys_return_if_fail (siblings != NULL);
+
+  sys_cpu_set_zero (siblings);
+
+  for (i = 0; i < topology->n_cpus; i++) {
+    if (topology->cpus[i].cpu == cpu)
+      info = &topology->cpus[i];
+  }
+  if (info == NULL)
+    return;
+
+  for (i = 0; i < topology->n_cpus; i++) {
+    if (topology->cpus[i].package == info->package
+        && topology->cpus[i].core == info->core)
+      sys_cpu_set_add (siblings, topology->cpus[i].cpu);
+  }
+}
+
+/**
+ * sys_topology_get_node_cpus:
+ * @topology: a #SysTopology
+ * @node: a NUMA node number
+ * @cpus: (out): the CPUs of @node
+ */
+void sys_topology_get_node_cpus (SysTopology *topology, SysInt node, SysCpuSet *cpus) {
+  SysUInt i;
+
+  sys_return_if_fail (topology != NULL);
+  sys_return_if_fail (cpus != NULL);
+
+  sys_cpu_set_zero (cpus);
+
+  for (i = 0; i < topology->n_cpus; i++) {
+    if (topology->cpus[i].node == node)
+      sys_cpu_set_add (cpus, topology->cpus[i].cpu);
+  }
+}
+
+
+/* SysBRLock {{{1 ---------------------------------------------------------- */
+
+#define SYS_BR_LOCK_LINE 64
+
+typedef struct _SysBRLockSlot SysBRLockSlot;
+struct _SysBRLockSlot {
+  SysInt readers;
+  SysChar pad[SYS_BR_LOCK_LINE - sizeof (SysInt)];
+};
+
+static SysUInt sys_br_lock_current_cpu (void) {
+#if defined(SYS_OS_WIN32)
+  return (SysUInt) GetCurrentProcessorNumber ();
+#elif defined(__linux__)
+  SysInt cpu = sched_getcpu ();
+
+  return cpu < 0 ? 0 : (SysUInt) cpu;
+#else
+  SysInt local;
+
+  /* no CPU number here, spread threads by their stack instead */
+  return (SysUInt) ((SysUIntPtr) &local >> 16);
+#endif
+}
+
+/**
+ * sys_br_lock_init:
+ * @br_lock: an uninitialized #SysBRLock
+ *
+ * Makes one reader slot per CPU, release them with sys_br_lock_clear().
+ */
+void sys_br_lock_init (SysBRLock *br_lock) {
+  SysUInt n_slots = 1;
+  SysUInt n_cpus;
+
+  sys_return_if_fail (br_lock != NULL);
+
+  n_cpus = sys_get_num_processors ();
+  while (n_slots < n_cpus)
+    n_slots <<= 1;
+
+  br_lock->mem = sys_malloc0 (n_slots * sizeof (SysBRLockSlot) + SYS_BR_LOCK_LINE);
+  br_lock->slots = (SysPointer) (((SysUIntPtr) br_lock->mem + SYS_BR_LOCK_LINE - 1)
+      & ~(SysUIntPtr) (SYS_BR_LOCK_LINE - 1));
+  br_lock->mask = n_slots - 1;
+  br_lock->writer = 0;
+  sys_mutex_init (&br_lock->writer_lock);
+}
+
+void sys_br_lock_clear (SysBRLock *br_lock) {
+  sys_return_if_fail (br_lock != NULL);
+
+  sys_mutex_clear (&br_lock->writer_lock);
+  sys_free (br_lock->mem);
+  br_lock->mem = NULL;
+  br_lock->slots = NULL;
+}
+
+/**
+ * sys_br_lock_reader_lock:
+ * @br_lock: a #SysBRLock
+ *
+ * Takes a read lock, only the slot of the current CPU is written.
+ *
+ * Returns: the slot to give back to sys_br_lock_reader_unlock(), the
+ *   thread may have moved to another CPU by then
+ */
+SysUInt sys_br_lock_reader_lock (SysBRLock *br_lock) {
+  SysBRLockSlot *slots = br_lock->slots;
+  SysUInt slot;
+
+  while (true) {
+    slot = sys_br_lock_current_cpu () & br_lock->mask;
+    sys_atomic_int_inc (&slots[slot].readers);
+
+    if SYS_LIKELY (!sys_atomic_int_get (&br_lock->writer))
+      return slot;
+
+    /* back off and sleep until the writer is done */
+    sys_atomic_int_dec (&slots[slot].readers);
+    sys_mutex_lock (&br_lock->writer_lock);
+    sys_mutex_unlock (&br_lock->writer_lock);
+  }
+}
+
+void sys_br_lock_reader_unlock (SysBRLock *br_lock, SysUInt slot) {
+  SysBRLockSlot *slots = br_lock->slots;
+
+  sys_atomic_int_dec (&slots[slot].readers);
+}
+
+/**
+ * sys_br_lock_writer_lock:
+ * @br_lock: a #SysBRLock
+ *
+ * Takes the write lock, new readers wait and the ones inside are
+ * waited for on every slot.
+ */
+void sys_br_lock_writer_lock (SysBRLock *br_lock) {
+  SysBRLockSlot *slots = br_lock->slots;
+  SysUInt i, spins;
+
+  sys_mutex_lock (&br_lock->writer_lock);
+  sys_atomic_int_set (&br_lock->writer, 1);
+
+  for (i = 0; i <= br_lock->mask; i++) {
+    for (spins = 0; sys_atomic_int_get (&slots[i].readers) != 0; spins++) {
+      if (spins < 64)
+        sys_cpu_relax ();
+      else
+        sys_thread_yield ();
+    }
+  }
+}
+
+void sys_br_lock_writer_unlock (SysBRLock *br_lock) {
+  sys_atomic_int_set (&br_lock->writer, 0);
+  sys_mutex_unlock (&br_lock->writer_lock);
+}
+
+/* SysSeqLock {{{1 --------------------------------------------------------- */
+
+void sys_seq_lock_init (SysSeqLock *seq_lock) {
+  sys_return_if_fail (seq_lock != NULL);
+
+  seq_lock->seq = 0;
+  sys_mutex_init (&seq_lock->writer_lock);
+}
+
+void sys_seq_lock_clear (SysSeqLock *seq_lock) {
+  sys_return_if_fail (seq_lock != NULL);
+
+  sys_mutex_clear (&seq_lock->writer_lock);
+}
+
+/**
+ * sys_seq_lock_read_begin:
+ * @seq_lock: a #SysSeqLock
+ *
+ * Waits out a writer in progress and starts a read.
+ *
+ * Returns: the sequence to give to sys_seq_lock_read_retry()
+ */
+SysUInt sys_seq_lock_read_begin (SysSeqLock *seq_lock) {
+  SysUInt seq;
+  SysUInt spins = 0;
+
+  /* odd while a writer is inside */
+  while ((seq = (SysUInt) sys_atomic_int_get (&seq_lock->seq)) & 1) {
+    if (spins++ < 64)
+      sys_cpu_relax ();
+    else
+      sys_thread_yield ();
+  }
+
+  return seq;
+}
+
+/**
+ * sys_seq_lock_read_retry:
+ * @seq_lock: a #SysSeqLock
+ * @seq: the value returned by sys_seq_lock_read_begin()
+ *
+ * Returns: %true if a writer ran since @seq and the copy must be redone
+ */
+SysBool sys_seq_lock_read_retry (SysSeqLock *seq_lock, SysUInt seq) {
+  /* the data loads must be done before the sequence is checked again */
+  sys_atomic_fence ();
+
+  return (SysUInt) sys_atomic_int_get (&seq_lock->seq) != seq;
+}
+
+void sys_seq_lock_writer_lock (SysSeqLock *seq_lock) {
+  sys_mutex_lock (&seq_lock->writer_lock);
+
+  sys_atomic_int_set (&seq_lock->seq, seq_lock->seq + 1);
+  /* readers must see the odd sequence before any of the new data */
+  sys_atomic_fence ();
+}
+
+void sys_seq_lock_writer_unlock (SysSeqLock *seq_lock) {
+  sys_atomic_int_set (&seq_lock->seq, seq_lock->seq + 1);
+
+  sys_mutex_unlock (&seq_lock->writer_lock);
+}
+
+/* SysLockProfile {{{1 ----------------------------------------------------- */
+
+/* locks a thread may hold at once with a hold time being measured, the
+ * ones past that are simply not sampled */
+#define SYS_LOCK_PROFILE_DEPTH 16
+#define SYS_LOCK_PROFILE_DEFAULT_RATE 16
+
+typedef struct _SysLockHeld SysLockHeld;
+typedef struct _SysLockProfileThread SysLockProfileThread;
+
+struct _SysLockHeld {
+  SysPointer lock;
+  SysLockSite *site;
+  SysUInt64 start;
+  /* hold time before the condition waits, if any */
+  SysUInt64 elapsed;
+};
+
+struct _SysLockProfileThread {
+  SysUInt counter;
+  SysUInt n_held;
+  SysLockHeld held[SYS_LOCK_PROFILE_DEPTH];
+};
+
+static SysInt sys_lock_profile_enabled = 0;
+static SysUInt sys_lock_profile_rate = SYS_LOCK_PROFILE_DEFAULT_RATE;
+static SysLockSite *sys_lock_sites = NULL;
+
+SYS_THREAD_LOCAL_DEFINE_STATIC (sys_lock_profile_thread, sys_free);
+
+static SysUInt64 sys_lock_profile_now (void) {
+#if defined(SYS_OS_WIN32)
+  LARGE_INTEGER counter, freq;
+
+  QueryPerformanceCounter (&counter);
+  QueryPerformanceFrequency (&freq);
+
+  return (SysUInt64) (counter.QuadPart / freq.QuadPart) * 1000000000
+    + (SysUInt64) (counter.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+#else
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return (SysUInt64) ts.tv_sec * 1000000000 + (SysUInt64) ts.tv_nsec;
+#endif
+}
+
+static void sys_lock_site_register (SysLockSite *site) {
+  SysInt registered = 0;
+  SysPointer head;
+
+  if SYS_LIKELY (sys_atomic_int_load (&site->registered, SYS_ATOMIC_ACQUIRE))
+    return;
+
+  if (!sys_atomic_int_compare_exchange (&site->registered, &registered, 1, SYS_ATOMIC_ACQ_REL))
+    return;
+
+  head = sys_atomic_pointer_load ((SysPointer *) &sys_lock_sites, SYS_ATOMIC_RELAXED);
+  do {
+    site->next = head;
+  } while (!sys_atomic_pointer_compare_exchange ((SysPointer *) &sys_lock_sites, &head, site, SYS_ATOMIC_RELEASE));
+}
+
+static void sys_lock_profile_max (SysUInt64 *max, SysUInt64 value) {
+  SysUInt64 old = sys_atomic_uint64_load (max, SYS_ATOMIC_RELAXED);
+
+  while (value > old) {
+    if (sys_atomic_uint64_compare_exchange (max, &old, value, SYS_ATOMIC_RELAXED))
+      break;
+  }
+}
+
+static SysUInt sys_lock_hist_bucket (SysUInt64 ns) {
+  SysUInt bucket = 0;
+
+  while (ns > 1 && bucket < SYS_LOCK_HIST_BUCKETS - 1) {
+    ns >>= 1;
+    bucket++;
+  }
+
+  return bucket;
+}
+
+static void sys_lock_site_add_wait (SysLockSite *site, SysUInt64 ns) {
+  sys_lock_site_register (site);
+
+  sys_atomic_uint64_fetch_add (&site->contended, 1, SYS_ATOMIC_RELAXED);
+  sys_atomic_uint64_fetch_add (&site->wait_total, ns, SYS_ATOMIC_RELAXED);
+  sys_atomic_uint64_fetch_add (&site->wait_hist[sys_lock_hist_bucket (ns)], 1, SYS_ATOMIC_RELAXED);
+  sys_lock_profile_max (&site->wait_max, ns);
+}
+
+static void sys_lock_site_add_hold (SysLockSite *site, SysUInt64 ns) {
+  sys_lock_site_register (site);
+
+  sys_atomic_uint64_fetch_add (&site->samples, 1, SYS_ATOMIC_RELAXED);
+  sys_atomic_uint64_fetch_add (&site->hold_total, ns, SYS_ATOMIC_RELAXED);
+  sys_atomic_uint64_fetch_add (&site->hold_hist[sys_lock_hist_bucket (ns)], 1, SYS_ATOMIC_RELAXED);
+  sys_lock_profile_max (&site->hold_max, ns);
+}
+
+/* called with the lock taken, starts a hold sample once in a while */
+static void sys_lock_profile_acquired (SysLockSite *site, SysPointer lock) {
+  SysLockProfileThread *thread = sys_thread_local_get (&sys_lock_profile_thread);
+  SysLockHeld *held;
+
+  if SYS_UNLIKELY (thread == NULL) {
+    thread = sys_new0 (SysLockProfileThread, 1);
+    sys_thread_local_set (&sys_lock_profile_thread, thread);
+  }
+
+  if (++thread->counter < sys_atomic_uint_load (&sys_lock_profile_rate, SYS_ATOMIC_RELAXED))
+    return;
+  thread->counter = 0;
+
+  if (thread->n_held == SYS_LOCK_PROFILE_DEPTH)
+    return;
+
+  held = &thread->held[thread->n_held++];
+  held->lock = lock;
+  held->site = site;
+  held->start = sys_lock_profile_now ();
+  held->elapsed = 0;
+}
+
+static SysLockHeld *sys_lock_profile_find (SysPointer lock) {
+  SysLockProfileThread *thread = sys_thread_local_get (&sys_lock_profile_thread);
+  SysUInt i;
+
+  if (thread == NULL)
+    return NULL;
+
+  for (i = thread->n_held; i-- > 0;) {
+    if (thread->held[i].lock == lock)
+      return &thread->held[i];
+  }
+
+  return NULL;
+}
+
+/* called before the lock is released, ends its hold sample if any */
+static void sys_lock_profile_released (SysPointer lock) {
+  SysLockProfileThread *thread;
+  SysLockHeld *held = sys_lock_profile_find (lock);
+
+  if (held == NULL)
+    return;
+
+  sys_lock_site_add_hold (held->site, held->elapsed + sys_lock_profile_now () - held->start);
+
+  thread = sys_thread_local_get (&sys_lock_profile_thread);
+  thread->n_held--;
+  memmove (held, held + 1, (SysSize) (&thread->held[thread->n_held] - held) * sizeof (SysLockHeld));
+}
+
+/**
+ * sys_lock_profile_enable:
+ * @enable: whether to profile
+ *
+ * Turns lock profiling on or off for the code built with
+ * SYS_PROFILE_LOCKS, without it the macros call the locks directly.
+ */
+void sys_lock_profile_enable (SysBool enable) {
+  sys_atomic_int_store (&sys_lock_profile_enabled, enable ? 1 : 0, SYS_ATOMIC_RELAXED);
+}
+
+SysBool sys_lock_profile_is_enabled (void) {
+  return sys_atomic_int_load (&sys_lock_profile_enabled, SYS_ATOMIC_RELAXED) != 0;
+}
+
+/**
+ * sys_lock_profile_set_sample_rate:
+ * @every: measure the hold time of one acquisition out of @every per
+ *   thread, 1 for all of them
+ *
+ * Wait times are always measured, a wait is already slow.
+ */
+void sys_lock_profile_set_sample_rate (SysUInt every) {
+  sys_return_if_fail (every > 0);
+
+  sys_atomic_uint_store (&sys_lock_profile_rate, every, SYS_ATOMIC_RELAXED);
+}
+
+/**
+ * sys_lock_profile_reset:
+ *
+ * Zeroes the counters of every site, samples taken meanwhile may be
+ * half counted.
+ */
+void sys_lock_profile_reset (void) {
+  SysLockSite *site;
+  SysUInt i;
+
+  site = sys_atomic_pointer_load ((SysPointer *) &sys_lock_sites, SYS_ATOMIC_ACQUIRE);
+  for (; site != NULL; site = site->next) {
+    sys_atomic_uint64_store (&site->samples, 0, SYS_ATOMIC_RELAXED);
+    sys_atomic_uint64_store (&site->contended, 0, SYS_ATOMIC_RELAXED);
+    sys_atomic_uint64_store (&site->wait_total, 0, SYS_ATOMIC_RELAXED);
+    sys_atomic_uint64_store (&site->wait_max, 0, SYS_ATOMIC_RELAXED);
+    sys_atomic_uint64_store (&site->hold_total, 0, SYS_ATOMIC_RELAXED);
+    sys_atomic_uint64_store (&site->hold_max, 0, SYS_ATOMIC_RELAXED);
+
+    for (i = 0; i < SYS_LOCK_HIST_BUCKETS; i++) {
+      sys_atomic_uint64_store (&site->wait_hist[i], 0, SYS_ATOMIC_RELAXED);
+      sys_atomic_uint64_store (&site->hold_hist[i], 0, SYS_ATOMIC_RELAXED);
+    }
+  }
+}
+
+/* copies the counters of @site, so the report sorts and prints values
+ * other threads no longer change */
+static void sys_lock_site_snapshot (SysLockSite *site, SysLockSite *copy) {
+  SysUInt i;
+
+  copy->name = site->name;
+  copy->file = site->file;
+  copy->line = site->line;
+  copy->samples = sys_atomic_uint64_load (&site->samples, SYS_ATOMIC_RELAXED);
+  copy->contended = sys_atomic_uint64_load (&site->contended, SYS_ATOMIC_RELAXED);
+  copy->wait_total = sys_atomic_uint64_load (&site->wait_total, SYS_ATOMIC_RELAXED);
+  copy->wait_max = sys_atomic_uint64_load (&site->wait_max, SYS_ATOMIC_RELAXED);
+  copy->hold_total = sys_atomic_uint64_load (&site->hold_total, SYS_ATOMIC_RELAXED);
+  copy->hold_max = sys_atomic_uint64_load (&site->hold_max, SYS_ATOMIC_RELAXED);
+
+  for (i = 0; i < SYS_LOCK_HIST_BUCKETS; i++) {
+    copy->wait_hist[i] = sys_atomic_uint64_load (&site->wait_hist[i], SYS_ATOMIC_RELAXED);
+    copy->hold_hist[i] = sys_atomic_uint64_load (&site->hold_hist[i], SYS_ATOMIC_RELAXED);
+  }
+}
+
+static SysInt sys_lock_site_cmp (const void *a, const void *b) {
+  const SysLockSite *sa = a;
+  const SysLockSite *sb = b;
+
+  if (sa->wait_total != sb->wait_total)
+    return sa->wait_total < sb->wait_total ? 1 : -1;
+
+  return sa->hold_total < sb->hold_total ? 1 : sa->hold_total > sb->hold_total ? -1 : 0;
+}
+
+/* upper bound of the bucket holding the 99th percentile, never above
+ * the largest sample seen */
+static SysUInt64 sys_lock_hist_p99 (const SysUInt64 *hist, SysUInt64 total, SysUInt64 max) {
+  SysUInt64 seen = 0;
+  SysUInt64 bound;
+  SysUInt i;
+
+  if (total == 0)
+    return 0;
+
+  for (i = 0; i < SYS_LOCK_HIST_BUCKETS; i++) {
+    seen += hist[i];
+    if (seen * 100 >= total * 99)
+      break;
+  }
+
+  bound = (SysUInt64) 2 << (i < SYS_LOCK_HIST_BUCKETS ? i : SYS_LOCK_HIST_BUCKETS - 1);
+
+  return bound < max ? bound : max;
+}
+
+static const SysChar *sys_lock_profile_format_ns (SysChar *buf, SysSize size, SysUInt64 ns) {
+  if (ns < 10000)
+    sys_snprintf (buf, size, "%uns", (SysUInt) ns);
+  else if (ns < 10000000)
+    sys_snprintf (buf, size, "%.1fus", ns / 1e3);
+  else if (ns < UINT64_CONSTANT (10000000000))
+    sys_snprintf (buf, size, "%.1fms", ns / 1e6);
+  else
+    sys_snprintf (buf, size, "%.1fs", ns / 1e9);
+
+  return buf;
+}
+
+/**
+ * sys_lock_profile_report:
+ * @top_n: number of sites to list, 0 for all of them
+ *
+ * Lists the lock sites by total wait time, most contended first. Hold
+ * times and acquisition counts are estimated from the samples.
+ *
+ * Returns: (transfer full): the report, free it with sys_free()
+ */
+SysChar *sys_lock_profile_report (SysUInt top_n) {
+  SysSize mlen = 1024, len = 0;
+  SysChar *report = sys_str_newsize (mlen);
+  SysLockSite *site;
+  SysLockSite *sites;
+  SysChar line[512];
+  SysChar b[6][32];
+  SysUInt n = 0, i, rate;
+  SysUInt64 acquired;
+
+  site = sys_atomic_pointer_load ((SysPointer *) &sys_lock_sites, SYS_ATOMIC_ACQUIRE);
+  for (; site != NULL; site = site->next)
+    n++;
+
+  sites = sys_new0 (SysLockSite, n ? n : 1);
+  site = sys_atomic_pointer_load ((SysPointer *) &sys_lock_sites, SYS_ATOMIC_ACQUIRE);
+  for (i = 0; i < n; i++, site = site->next)
+    sys_lock_site_snapshot (site, &sites[i]);
+
+  qsort (sites, n, sizeof (SysLockSite), sys_lock_site_cmp);
+  if (top_n == 0 || top_n > n)
+    top_n = n;
+
+  rate = sys_atomic_uint_load (&sys_lock_profile_rate, SYS_ATOMIC_RELAXED);
+  report[0] = '\0';
+  sys_snprintf (line, sizeof (line), "lock profile: %u sites, hold sampled 1/%u\n"
+      "%10s %10s %10s %10s %12s %10s %10s %10s  %s\n", n, rate,
+      "wait", "wait max", "wait p99", "contended", "acquired~", "hold avg", "hold max", "hold p99", "site");
+  sys_strmcat (&report, &mlen, &len, line);
+
+  for (i = 0; i < top_n; i++) {
+    site = &sites[i];
+    acquired = site->samples * rate;
+    if (acquired < site->contended)
+      acquired = site->contended;
+
+    sys_snprintf (line, sizeof (line), "%10s %10s %10s %10llu %12llu %10s %10s %10s  %s (%s:%d)\n",
+        sys_lock_profile_format_ns (b[0], sizeof (b[0]), site->wait_total),
+        sys_lock_profile_format_ns (b[1], sizeof (b[1]), site->wait_max),
+        sys_lock_profile_format_ns (b[2], sizeof (b[2]), sys_lock_hist_p99 (site->wait_hist, site->contended, site->wait_max)),
+        (unsigned long long) site->contended,
+        (unsigned long long) acquired,
+        sys_lock_profile_format_ns (b[3], sizeof (b[3]), site->samples ? site->hold_total / site->samples : 0),
+        sys_lock_profile_format_ns (b[4], sizeof (b[4]), site->hold_max),
+        sys_lock_profile_format_ns (b[5], sizeof (b[5]), sys_lock_hist_p99 (site->hold_hist, site->samples, site->hold_max)),
+        site->name, site->file, site->line);
+    sys_strmcat (&report, &mlen, &len, line);
+  }
+
+  sys_free (sites);
+
+  return report;
+}
+
+void sys_lock_profile_mutex_lock (SysLockSite *site, SysMutex *mutex) {
+  SysUInt64 start;
+
+  if (!sys_atomic_int_load (&sys_lock_profile_enabled, SYS_ATOMIC_RELAXED)) {
+    sys_mutex_lock (mutex);
+    return;
+  }
+
+  if (!sys_mutex_trylock (mutex)) {
+    start = sys_lock_profile_now ();
+    sys_mutex_lock (mutex);
+    sys_lock_site_add_wait (site, sys_lock_profile_now () - start);
+  }
+
+  sys_lock_profile_acquired (site, mutex);
+}
+
+void sys_lock_profile_mutex_unlock (SysMutex *mutex) {
+  sys_lock_profile_released (mutex);
+  sys_mutex_unlock (mutex);
+}
+
+void sys_lock_profile_rw_lock_writer_lock (SysLockSite *site, SysRWLock *rw_lock) {
+  SysUInt64 start;
+
+  if (!sys_atomic_int_load (&sys_lock_profile_enabled, SYS_ATOMIC_RELAXED)) {
+    sys_rw_lock_writer_lock (rw_lock);
+    return;
+  }
+
+  if (!sys_rw_lock_writer_trylock (rw_lock)) {
+    start = sys_lock_profile_now ();
+    sys_rw_lock_writer_lock (rw_lock);
+    sys_lock_site_add_wait (site, sys_lock_profile_now () - start);
+  }
+
+  sys_lock_profile_acquired (site, rw_lock);
+}
+
+void sys_lock_profile_rw_lock_writer_unlock (SysRWLock *rw_lock) {
+  sys_lock_profile_released (rw_lock);
+  sys_rw_lock_writer_unlock (rw_lock);
+}
+
+void sys_lock_profile_rw_lock_reader_lock (SysLockSite *site, SysRWLock *rw_lock) {
+  SysUInt64 start;
+
+  if (!sys_atomic_int_load (&sys_lock_profile_enabled, SYS_ATOMIC_RELAXED)) {
+    sys_rw_lock_reader_lock (rw_lock);
+    return;
+  }
+
+  if (!sys_rw_lock_reader_trylock (rw_lock)) {
+    start = sys_lock_profile_now ();
+    sys_rw_lock_reader_lock (rw_lock);
+    sys_lock_site_add_wait (site, sys_lock_profile_now () - start);
+  }
+
+  sys_lock_profile_acquired (site, rw_lock);
+}
+
+void sys_lock_profile_rw_lock_reader_unlock (SysRWLock *rw_lock) {
+  sys_lock_profile_released (rw_lock);
+  sys_rw_lock_reader_unlock (rw_lock);
+}
+
+/* the time spent in the condition is not a hold, the sample of @mutex
+ * is paused before waiting and resumed once it is taken again, it still
+ * counts once when the mutex is unlocked */
+void sys_lock_profile_cond_wait (SysCond *cond, SysMutex *mutex) {
+  SysLockHeld *held = sys_lock_profile_find (mutex);
+
+  if (held != NULL)
+    held->elapsed += sys_lock_profile_now () - held->start;
+
+  sys_cond_wait (cond, mutex);
+
+  if (held != NULL)
+    held->start = sys_lock_profile_now ();
+}
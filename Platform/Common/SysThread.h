@@ -17,7 +17,82 @@ typedef struct _SysRecMutex       SysRecMutex;
 typedef struct _SysRWLock         SysRWLock;
 typedef struct _SysCond           SysCond;
 typedef struct _SysPrivate        SysPrivate;
+typedef struct _SysThreadLocal    SysThreadLocal;
+typedef struct _SysLockSite       SysLockSite;
 typedef struct _SysOnce           SysOnce;
+typedef struct _SysMutexStats     SysMutexStats;
+typedef struct _SysBRLock         SysBRLock;
+typedef struct _SysSeqLock        SysSeqLock;
+typedef struct _SysCpuSet         SysCpuSet;
+typedef struct _SysThreadOptions  SysThreadOptions;
+typedef struct _SysCpuInfo        SysCpuInfo;
+typedef struct _SysTopology       SysTopology;
+
+/* SYS_RW_LOCK_PREFER_WRITER is honoured by the Unix backend only, it
+ * is a no-op on Win32 and Android */
+typedef enum {
+  SYS_RW_LOCK_DEFAULT = 0,
+  SYS_RW_LOCK_PREFER_WRITER = 1 << 0
+} SysRWLockFlags;
+
+typedef enum {
+  SYS_THREAD_SCHED_INHERIT,
+  SYS_THREAD_SCHED_NORMAL,
+  SYS_THREAD_SCHED_FIFO,
+  SYS_THREAD_SCHED_RR
+} SysThreadSched;
+
+/**
+ * SysCpuSet: fixed size set of logical CPU numbers.
+ */
+#define SYS_CPU_SET_MAX 1024
+struct _SysCpuSet {
+  /*< private >*/
+  SysUInt64 bits[SYS_CPU_SET_MAX / 64];
+};
+
+/**
+ * SysThreadOptions: attributes for sys_thread_new_full().
+ *
+ * @cpus: CPUs the thread may run on, %NULL to leave it unpinned
+ * @stack_size: stack size in bytes, 0 for the system default
+ * @guard_size: guard area past the stack in bytes, 0 for the system default
+ * @sched: scheduling policy, %SYS_THREAD_SCHED_INHERIT keeps the creator's
+ * @priority: real time priority for %SYS_THREAD_SCHED_FIFO and
+ *   %SYS_THREAD_SCHED_RR, nice value for %SYS_THREAD_SCHED_NORMAL
+ *
+ * A zeroed struct creates the same thread as sys_thread_new().
+ */
+struct _SysThreadOptions {
+  const SysCpuSet *cpus;
+  SysSize stack_size;
+  SysSize guard_size;
+  SysThreadSched sched;
+  SysInt priority;
+};
+
+/**
+ * SysCpuInfo: placement of one logical CPU.
+ *
+ * CPUs sharing @package and @core are SMT siblings.
+ */
+struct _SysCpuInfo {
+  SysInt cpu;
+  SysInt core;
+  SysInt package;
+  SysInt node;
+};
+
+/**
+ * SysTopology: logical CPUs of the machine, see sys_get_topology().
+ */
+struct _SysTopology {
+  SysUInt n_cpus;
+  SysUInt n_cores;
+  SysUInt n_packages;
+  SysUInt n_nodes;
+  SysCpuInfo *cpus;
+};
 
 struct _SysThread {
   /*< private >*/
@@ -38,6 +113,43 @@ struct _SysRWLock {
   SysUInt i[2];
 };
 
+/**
+ * SysBRLock: big reader lock.
+ *
+ * Readers count themselves in a slot of the CPU they run on, each slot
+ * on its own cache line, so concurrent readers never share a line.
+ * Writers are expensive: they wait for every slot to drain.
+ */
+struct _SysBRLock {
+  /*< private >*/
+  SysPointer slots;
+  SysPointer mem;
+  SysUInt mask;
+  SysInt writer;
+  SysMutex writer_lock;
+};
+
+/**
+ * SysSeqLock: sequence lock for small plain data.
+ *
+ * Writers bump the sequence around their update, readers copy the data
+ * without writing anything and start over when the sequence changed:
+ *
+ *   do {
+ *     seq = sys_seq_lock_read_begin (&lock);
+ *     copy = shared;
+ *   } while (sys_seq_lock_read_retry (&lock, seq));
+ *
+ * The data must not hold pointers the reader follows, a torn copy is
+ * only detected after the fact.
+ */
+#define SYS_SEQ_LOCK_INIT { 0, { NULL } }
+struct _SysSeqLock {
+  /*< private >*/
+  SysInt seq;
+  SysMutex writer_lock;
+};
+
 struct _SysCond {
   /*< private >*/
   SysPointer p;
@@ -50,6 +162,19 @@ struct _SysRecMutex {
   SysUInt i[2];
 };
 
+/**
+ * SysMutexStats: process wide contention counters of #SysMutex.
+ *
+ * @contended: locks that found the mutex taken
+ * @spin_acquired: contended locks that got it while spinning
+ * @parked: contended locks that had to sleep in the kernel
+ */
+struct _SysMutexStats {
+  SysUInt64 contended;
+  SysUInt64 spin_acquired;
+  SysUInt64 parked;
+};
+
 #define SYS_PRIVATE_INIT(notify) { NULL, (notify), { NULL, NULL } }
 struct _SysPrivate {
   /*< private >*/
@@ -58,6 +183,39 @@ struct _SysPrivate {
   SysPointer future[2];
 };
 
+/**
+ * SysThreadLocal: thread local pointer declared at compile time.
+ *
+ * Lighter than #SysPrivate: reading it is a single load from static
+ * TLS. The notify function runs on the value a thread still holds when
+ * it exits. Only define it in static scope:
+ *
+ *   SYS_THREAD_LOCAL_DEFINE_STATIC (cache, sys_free);
+ *
+ *   buf = sys_thread_local_get (&cache);
+ */
+#if defined(SYS_THREAD_LOCAL)
+#define SYS_THREAD_LOCAL_INIT(notify) { NULL, (notify), false }
+struct _SysThreadLocal {
+  /*< private >*/
+  SysPointer value;
+  SysDestroyFunc notify;
+  SysBool registered;
+};
+
+#define SYS_THREAD_LOCAL_DEFINE_STATIC(name, notify) \
+  static SYS_THREAD_LOCAL SysThreadLocal name = SYS_THREAD_LOCAL_INIT (notify)
+#else
+#define SYS_THREAD_LOCAL_INIT(notify) { SYS_PRIVATE_INIT (notify) }
+struct _SysThreadLocal {
+  /*< private >*/
+  SysPrivate key;
+};
+
+#define SYS_THREAD_LOCAL_DEFINE_STATIC(name, notify) \
+  static SysThreadLocal name = SYS_THREAD_LOCAL_INIT (notify)
+#endif
+
 typedef enum {
   SYS_ONCE_STATUS_NOTCALLED,
   SYS_ONCE_STATUS_PROGRESS,
@@ -75,37 +233,85 @@ struct _SysOnce {
 #define SYS_LOCK_DEFINE(name)           SysMutex SYS_LOCK_NAME (name)
 #define SYS_LOCK_EXTERN(name)           extern SysMutex SYS_LOCK_NAME (name)
 
-#ifdef SYS_DEBUSYS_LOCKS
-#  define SYS_LOCK(name)                SYS_STMT_START{             \
-      sys_log (SYS_LOSYS_DOMAIN, SYS_LOSYS_LEVEL_DEBUG,                   \
-             "file %s: line %d (%s): locking: %s ",             \
-             __FILE__,        __LINE__, SYS_STRFUNC,              \
-             #name);                                            \
-      sys_mutex_lock (&SYS_LOCK_NAME (name));                       \
+/**
+ * SysLockSite: contention profile of one lock call site.
+ *
+ * Build with SYS_PROFILE_LOCKS defined and call
+ * sys_lock_profile_enable() to profile the SYS_LOCK() and
+ * SYS_MUTEX_LOCK() style macros below. Every contended acquisition
+ * records its wait time; one acquisition in the sample rate also
+ * records how long the lock was held. Times are in nanoseconds, the
+ * histograms have one bucket per power of two.
+ */
+#define SYS_LOCK_HIST_BUCKETS 32
+#define SYS_LOCK_SITE_INIT(name) { (name), __FILE__, __LINE__, NULL, 0 }
+struct _SysLockSite {
+  const SysChar *name;
+  const SysChar *file;
+  SysInt line;
+  /*< private >*/
+  SysLockSite *next;
+  SysInt registered;
+  SysUInt64 samples;
+  SysUInt64 contended;
+  SysUInt64 wait_total;
+  SysUInt64 wait_max;
+  SysUInt64 hold_total;
+  SysUInt64 hold_max;
+  SysUInt64 wait_hist[SYS_LOCK_HIST_BUCKETS];
+  SysUInt64 hold_hist[SYS_LOCK_HIST_BUCKETS];
+};
+
+#ifdef SYS_PROFILE_LOCKS
+#  define SYS_LOCK_SITE_DEFINE(name) \
+      static SysLockSite sys__lock_site = SYS_LOCK_SITE_INIT (name)
+#  define SYS_MUTEX_LOCK(mutex)         SYS_STMT_START{             \
+      SYS_LOCK_SITE_DEFINE (#mutex);                              \
+      sys_lock_profile_mutex_lock (&sys__lock_site, (mutex));     \
+   }SYS_STMT_END
+#  define SYS_MUTEX_UNLOCK(mutex)       sys_lock_profile_mutex_unlock (mutex)
+#  define SYS_RW_LOCK_WRITER_LOCK(rw_lock) SYS_STMT_START{          \
+      SYS_LOCK_SITE_DEFINE (#rw_lock);                            \
+      sys_lock_profile_rw_lock_writer_lock (&sys__lock_site, (rw_lock)); \
+   }SYS_STMT_END
+#  define SYS_RW_LOCK_WRITER_UNLOCK(rw_lock) sys_lock_profile_rw_lock_writer_unlock (rw_lock)
+#  define SYS_RW_LOCK_READER_LOCK(rw_lock) SYS_STMT_START{          \
+      SYS_LOCK_SITE_DEFINE (#rw_lock);                            \
+      sys_lock_profile_rw_lock_reader_lock (&sys__lock_site, (rw_lock)); \
    }SYS_STMT_END
-#  define SYS_UNLOCK(name)              SYS_STMT_START{             \
-      sys_log (SYS_LOSYS_DOMAIN, SYS_LOSYS_LEVEL_DEBUG,                   \
-             "file %s: line %d (%s): unlocking: %s ",           \
-             __FILE__,        __LINE__, SYS_STRFUNC,              \
-             #name);                                            \
-     sys_mutex_unlock (&SYS_LOCK_NAME (name));                      \
+#  define SYS_RW_LOCK_READER_UNLOCK(rw_lock) sys_lock_profile_rw_lock_reader_unlock (rw_lock)
+#  define SYS_COND_WAIT(cond, mutex)    sys_lock_profile_cond_wait ((cond), (mutex))
+#  define SYS_LOCK(name)                SYS_STMT_START{             \
+      SYS_LOCK_SITE_DEFINE (#name);                               \
+      sys_lock_profile_mutex_lock (&sys__lock_site, &SYS_LOCK_NAME (name)); \
    }SYS_STMT_END
-#  define SYS_TRYLOCK(name)                                       \
-      (sys_log (SYS_LOSYS_DOMAIN, SYS_LOSYS_LEVEL_DEBUG,                  \
-             "file %s: line %d (%s): try locking: %s ",         \
-             __FILE__,        __LINE__, SYS_STRFUNC,              \
-             #name), sys_mutex_trylock (&SYS_LOCK_NAME (name)))
-#else  /* !SYS_DEBUSYS_LOCKS */
+#  define SYS_UNLOCK(name) sys_lock_profile_mutex_unlock (&SYS_LOCK_NAME (name))
+   /* no wait to measure and no site to charge the hold time to */
+#  define SYS_TRYLOCK(name) sys_mutex_trylock (&SYS_LOCK_NAME (name))
+#else  /* !SYS_PROFILE_LOCKS */
+#  define SYS_MUTEX_LOCK(mutex) sys_mutex_lock (mutex)
+#  define SYS_MUTEX_UNLOCK(mutex) sys_mutex_unlock (mutex)
+#  define SYS_RW_LOCK_WRITER_LOCK(rw_lock) sys_rw_lock_writer_lock (rw_lock)
+#  define SYS_RW_LOCK_WRITER_UNLOCK(rw_lock) sys_rw_lock_writer_unlock (rw_lock)
+#  define SYS_RW_LOCK_READER_LOCK(rw_lock) sys_rw_lock_reader_lock (rw_lock)
+#  define SYS_RW_LOCK_READER_UNLOCK(rw_lock) sys_rw_lock_reader_unlock (rw_lock)
+#  define SYS_COND_WAIT(cond, mutex) sys_cond_wait ((cond), (mutex))
 #  define SYS_LOCK(name) sys_mutex_lock       (&SYS_LOCK_NAME (name))
 #  define SYS_UNLOCK(name) sys_mutex_unlock   (&SYS_LOCK_NAME (name))
 #  define SYS_TRYLOCK(name) sys_mutex_trylock (&SYS_LOCK_NAME (name))
-#endif /* !SYS_DEBUSYS_LOCKS */
+#endif /* !SYS_PROFILE_LOCKS */
 
 
 SYS_API SysThread * sys_thread_ref (SysThread *thread);
 SYS_API void sys_thread_unref (SysThread *thread);
 SYS_API SysThread * sys_thread_new (const SysChar *name, SysThreadFunc func, SysPointer data);
 SYS_API SysThread * sys_thread_try_new (const SysChar *name, SysThreadFunc func, SysPointer data, SysError **error);
+SYS_API SysThread * sys_thread_new_full (const SysChar *name,
+    SysThreadFunc func,
+    SysPointer data,
+    const SysThreadOptions *options,
+    SysError **error);
+SYS_API SysBool sys_thread_set_affinity (SysThread *thread, const SysCpuSet *cpus);
 
 
 SYS_API void sys_thread_init(void);
@@ -123,9 +329,12 @@ SYS_API void sys_mutex_clear (SysMutex *mutex);
 SYS_API void sys_mutex_lock (SysMutex *mutex);
 SYS_API SysBool sys_mutex_trylock (SysMutex *mutex);
 SYS_API void sys_mutex_unlock (SysMutex *mutex);
+SYS_API void sys_mutex_get_stats (SysMutexStats *stats);
+SYS_API void sys_mutex_reset_stats (void);
 
 
 SYS_API void sys_rw_lock_init (SysRWLock *rw_lock);
+SYS_API void sys_rw_lock_init_full (SysRWLock *rw_lock, SysRWLockFlags flags);
 SYS_API void sys_rw_lock_clear (SysRWLock *rw_lock);
 SYS_API void sys_rw_lock_writer_lock (SysRWLock *rw_lock);
 SYS_API SysBool sys_rw_lock_writer_trylock (SysRWLock *rw_lock);
@@ -134,6 +343,35 @@ SYS_API void sys_rw_lock_reader_lock (SysRWLock *rw_lock);
 SYS_API SysBool sys_rw_lock_reader_trylock (SysRWLock *rw_lock);
 SYS_API void sys_rw_lock_reader_unlock (SysRWLock *rw_lock);
 
+SYS_API void sys_br_lock_init (SysBRLock *br_lock);
+SYS_API void sys_br_lock_clear (SysBRLock *br_lock);
+SYS_API SysUInt sys_br_lock_reader_lock (SysBRLock *br_lock);
+SYS_API void sys_br_lock_reader_unlock (SysBRLock *br_lock, SysUInt slot);
+SYS_API void sys_br_lock_writer_lock (SysBRLock *br_lock);
+SYS_API void sys_br_lock_writer_unlock (SysBRLock *br_lock);
+
+SYS_API void sys_seq_lock_init (SysSeqLock *seq_lock);
+SYS_API void sys_seq_lock_clear (SysSeqLock *seq_lock);
+SYS_API SysUInt sys_seq_lock_read_begin (SysSeqLock *seq_lock);
+SYS_API SysBool sys_seq_lock_read_retry (SysSeqLock *seq_lock, SysUInt seq);
+SYS_API void sys_seq_lock_writer_lock (SysSeqLock *seq_lock);
+SYS_API void sys_seq_lock_writer_unlock (SysSeqLock *seq_lock);
+
+
+SYS_API void sys_lock_profile_enable (SysBool enable);
+SYS_API SysBool sys_lock_profile_is_enabled (void);
+SYS_API void sys_lock_profile_set_sample_rate (SysUInt every);
+SYS_API void sys_lock_profile_reset (void);
+SYS_API SysChar * sys_lock_profile_report (SysUInt top_n);
+
+SYS_API void sys_lock_profile_mutex_lock (SysLockSite *site, SysMutex *mutex);
+SYS_API void sys_lock_profile_mutex_unlock (SysMutex *mutex);
+SYS_API void sys_lock_profile_rw_lock_writer_lock (SysLockSite *site, SysRWLock *rw_lock);
+SYS_API void sys_lock_profile_rw_lock_writer_unlock (SysRWLock *rw_lock);
+SYS_API void sys_lock_profile_rw_lock_reader_lock (SysLockSite *site, SysRWLock *rw_lock);
+SYS_API void sys_lock_profile_rw_lock_reader_unlock (SysRWLock *rw_lock);
+SYS_API void sys_lock_profile_cond_wait (SysCond *cond, SysMutex *mutex);
+
 
 SYS_API void sys_rec_mutex_init (SysRecMutex *rec_mutex);
 SYS_API void sys_rec_mutex_clear (SysRecMutex *rec_mutex);
@@ -153,6 +391,42 @@ SYS_API SysBool sys_cond_wait_until (SysCond *cond, SysMutex *mutex, SysInt64 en
 SYS_API SysPointer sys_private_get (SysPrivate *key);
 SYS_API void sys_private_set (SysPrivate *key, SysPointer value);
 SYS_API void sys_private_replace (SysPrivate *key, SysPointer value);
+
+#if defined(SYS_THREAD_LOCAL)
+SYS_API void sys_thread_local_register (SysThreadLocal *tls);
+
+static inline SysPointer sys_thread_local_get (SysThreadLocal *tls) {
+  return tls->value;
+}
+
+static inline void sys_thread_local_set (SysThreadLocal *tls, SysPointer value) {
+  if (SYS_UNLIKELY (tls->notify != NULL && !tls->registered))
+    sys_thread_local_register (tls);
+
+  tls->value = value;
+}
+
+static inline void sys_thread_local_replace (SysThreadLocal *tls, SysPointer value) {
+  SysPointer old = tls->value;
+
+  sys_thread_local_set (tls, value);
+  if (old != NULL && tls->notify != NULL)
+    tls->notify (old);
+}
+#else
+static inline SysPointer sys_thread_local_get (SysThreadLocal *tls) {
+  return sys_private_get (&tls->key);
+}
+
+static inline void sys_thread_local_set (SysThreadLocal *tls, SysPointer value) {
+  sys_private_set (&tls->key, value);
+}
+
+static inline void sys_thread_local_replace (SysThreadLocal *tls, SysPointer value) {
+  sys_private_replace (&tls->key, value);
+}
+#endif
+
 SYS_API SysPointer sys_once_impl (SysOnce *once, SysThreadFunc func, SysPointer arg);
 SYS_API SysBool _sys_once_init_enter (volatile SysPointer location);
 SYS_API void _sys_once_init_leave (volatile SysPointer location, SysSize result);
@@ -189,6 +463,17 @@ SYS_API void _sys_once_init_leave (volatile SysPointer location, SysSize result)
 
 SysUInt  sys_get_num_processors (void);
 
+SYS_API void sys_cpu_set_zero (SysCpuSet *set);
+SYS_API void sys_cpu_set_add (SysCpuSet *set, SysInt cpu);
+SYS_API void sys_cpu_set_remove (SysCpuSet *set, SysInt cpu);
+SYS_API SysBool sys_cpu_set_contains (const SysCpuSet *set, SysInt cpu);
+SYS_API SysUInt sys_cpu_set_count (const SysCpuSet *set);
+
+SYS_API SysTopology *sys_get_topology (void);
+SYS_API void sys_topology_free (SysTopology *topology);
+SYS_API void sys_topology_get_siblings (SysTopology *topology, SysInt cpu, SysCpuSet *siblings);
+SYS_API void sys_topology_get_node_cpus (SysTopology *topology, SysInt node, SysCpuSet *cpus);
+
 typedef void SysMutexLocker;
 
 static inline SysMutexLocker * sys_mutex_locker_new (SysMutex *mutex) {
@@ -3,6 +3,20 @@
 
 #include <System/Platform/Common/SysThread.h>
 
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__NR_futex)
+#define sys_futex_simple(uaddr, futex_op, ...) \
+  syscall (__NR_futex, (uaddr), (SysSize) (futex_op), __VA_ARGS__)
+#elif defined(__NR_futex_time64)
+#define sys_futex_simple(uaddr, futex_op, ...) \
+  syscall (__NR_futex_time64, (uaddr), (SysSize) (futex_op), __VA_ARGS__)
+#endif
+#endif
+
 
 SYS_BEGIN_DECLS
 
@@ -23,22 +37,40 @@ void sys_system_thread_detach(void);
 void            sys_system_thread_wait            (SysRealThread  *thread);
 
 SysRealThread *sys_system_thread_new (SysThreadFunc proxy,
-                                  SysSize stack_size,
+                                  const SysThreadOptions *options,
                                   const SysChar *name,
                                   SysThreadFunc func,
                                   SysPointer data,
                                   SysError **error);
 void            sys_system_thread_free            (SysRealThread  *thread);
 
+/* sleeps while *address holds expected, until woken, spuriously or at
+ * end_time in monotonic microseconds (-1 for never). Returns false
+ * only on timeout. SysBarrier and friends sit on top of them */
+SysBool         sys_system_futex_wait             (SysUInt        *address,
+                                                 SysUInt         expected,
+                                                 SysInt64        end_time);
+void            sys_system_futex_wake             (SysUInt        *address,
+                                                 SysBool         all);
+
+/* native thread keys, SysPrivate sits on top of them */
+SysPointer      sys_system_private_get            (SysPrivate     *key);
+void            sys_system_private_set            (SysPrivate     *key,
+                                                 SysPointer      value);
+void            sys_system_private_replace        (SysPrivate     *key,
+                                                 SysPointer      value);
+
 void            sys_system_thread_exit            (void);
 void            sys_system_thread_set_name        (const SysChar  *name);
+SysBool         sys_system_thread_set_affinity    (SysRealThread  *thread,
+                                                 const SysCpuSet *cpus);
 
 /* gthread.c */
 SysThread *sys_thread_new_internal (const SysChar *name,
                                 SysThreadFunc proxy,
                                 SysThreadFunc func,
                                 SysPointer data,
-                                SysSize stack_size,
+                                const SysThreadOptions *options,
                                 SysError **error);
 
 SysPointer        sys_thread_proxy                  (SysPointer      thread);
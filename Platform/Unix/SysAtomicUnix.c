@@ -49,3 +49,7 @@ void sys_atomic_pointer_set(volatile SysPointer o, SysPointer n) {
 
   __atomic_store (no, &nn, __ATOMIC_SEQ_CST);
 }
+
+void sys_atomic_fence(void) {
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+}
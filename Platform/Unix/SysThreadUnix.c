@@ -1,5 +1,22 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <System/Utils/SysString.h>
 #include <System/Platform/Common/SysThreadPrivate.h>
+#include <System/Platform/Common/SysAtomic.h>
+
+#include <sys/resource.h>
+
+/* futex based SysMutex and SysCond where the kernel has them */
+#if defined(sys_futex_simple) && !defined(USE_NATIVE_MUTEX)
+#define USE_NATIVE_MUTEX
+#endif
+
+/* only touched on contention */
+static SysMutexStats sys_mutex_stats;
+#define SYS_MUTEX_STATS_INC(field) \
+  __atomic_fetch_add (&sys_mutex_stats.field, 1, __ATOMIC_RELAXED)
 
 /**
  * this code from glib SysThread
@@ -152,9 +169,19 @@ sys_mutex_clear (SysMutex *mutex)
 void
 sys_mutex_lock (SysMutex *mutex)
 {
+  pthread_mutex_t *impl = sys_mutex_get_impl (mutex);
   SysInt status;
 
-  if SYS_UNLIKELY ((status = pthread_mutex_lock (sys_mutex_get_impl (mutex))) != 0)
+  if SYS_LIKELY ((status = pthread_mutex_trylock (impl)) == 0)
+    return;
+
+  if SYS_UNLIKELY (status != EBUSY)
+    sys_thread_abort (status, "pthread_mutex_trylock");
+
+  SYS_MUTEX_STATS_INC (contended);
+  SYS_MUTEX_STATS_INC (parked);
+
+  if SYS_UNLIKELY ((status = pthread_mutex_lock (impl)) != 0)
     sys_thread_abort (status, "pthread_mutex_lock");
 }
 
@@ -372,9 +399,13 @@ sys_rec_mutex_trylock (SysRecMutex *rec_mutex)
 
 /* {{{1 SysRWLock */
 
+#if !defined(USE_NATIVE_MUTEX)
+
+/* i[0] keeps the #SysRWLockFlags, p the lazily made pthread lock */
 static pthread_rwlock_t *
-sys_rw_lock_impl_new (void)
+sys_rw_lock_impl_new (SysRWLockFlags flags)
 {
+  pthread_rwlockattr_t attr;
   pthread_rwlock_t *rwlock;
   SysInt status;
 
@@ -382,9 +413,17 @@ sys_rw_lock_impl_new (void)
   if SYS_UNLIKELY (rwlock == NULL)
     sys_thread_abort (errno, "malloc");
 
-  if SYS_UNLIKELY ((status = pthread_rwlock_init (rwlock, NULL)) != 0)
+  pthread_rwlockattr_init (&attr);
+#ifdef PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP
+  if (flags & SYS_RW_LOCK_PREFER_WRITER)
+    pthread_rwlockattr_setkind_np (&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+
+  if SYS_UNLIKELY ((status = pthread_rwlock_init (rwlock, &attr)) != 0)
     sys_thread_abort (status, "pthread_rwlock_init");
 
+  pthread_rwlockattr_destroy (&attr);
+
   return rwlock;
 }
 
@@ -402,7 +441,7 @@ sys_rw_lock_get_impl (SysRWLock *lock)
 
   if SYS_UNLIKELY (impl == NULL)
     {
-      impl = sys_rw_lock_impl_new ();
+      impl = sys_rw_lock_impl_new ((SysRWLockFlags) lock->i[0]);
       if (!sys_atomic_pointer_cmpxchg (&lock->p, NULL, impl))
         sys_rw_lock_impl_free (impl);
       impl = lock->p;
@@ -445,7 +484,24 @@ sys_rw_lock_get_impl (SysRWLock *lock)
 void
 sys_rw_lock_init (SysRWLock *rw_lock)
 {
-  rw_lock->p = sys_rw_lock_impl_new ();
+  sys_rw_lock_init_full (rw_lock, SYS_RW_LOCK_DEFAULT);
+}
+
+/**
+ * sys_rw_lock_init_full:
+ * @rw_lock: an uninitialized #SysRWLock
+ * @flags: #SysRWLockFlags for the lock
+ *
+ * Like sys_rw_lock_init(), with %SYS_RW_LOCK_PREFER_WRITER new readers
+ * wait while a writer is waiting.  A thread must then not take the read
+ * lock recursively, or it can deadlock against a waiting writer.
+ */
+void
+sys_rw_lock_init_full (SysRWLock      *rw_lock,
+                       SysRWLockFlags  flags)
+{
+  rw_lock->i[0] = flags;
+  rw_lock->p = sys_rw_lock_impl_new (flags);
 }
 
 /**
@@ -598,6 +654,8 @@ sys_rw_lock_reader_unlock (SysRWLock *rw_lock)
   pthread_rwlock_unlock (sys_rw_lock_get_impl (rw_lock));
 }
 
+#endif /* !defined(USE_NATIVE_MUTEX) */
+
 /* {{{1 SysCond */
 
 #if !defined(USE_NATIVE_MUTEX)
@@ -969,7 +1027,7 @@ sys_private_get_impl (SysPrivate *key)
 }
 
 /**
- * sys_private_get:
+ * sys_system_private_get:
  * @key: a #SysPrivate
  *
  * Returns the current value of the thread local variable @key.
@@ -981,14 +1039,14 @@ sys_private_get_impl (SysPrivate *key)
  * Returns: the thread-local value
  */
 SysPointer
-sys_private_get (SysPrivate *key)
+sys_system_private_get (SysPrivate *key)
 {
   /* quote POSIX: No errors are returned from pthread_getspecific(). */
   return pthread_getspecific (*sys_private_get_impl (key));
 }
 
 /**
- * sys_private_set:
+ * sys_system_private_set:
  * @key: a #SysPrivate
  * @value: the new value
  *
@@ -999,8 +1057,8 @@ sys_private_get (SysPrivate *key)
  * the #SysDestroyFunc for @key is not called on the old value.
  */
 void
-sys_private_set (SysPrivate *key,
-               SysPointer  value)
+sys_system_private_set (SysPrivate *key,
+                      SysPointer  value)
 {
   SysInt status;
 
@@ -1009,7 +1067,7 @@ sys_private_set (SysPrivate *key,
 }
 
 /**
- * sys_private_replace:
+ * sys_system_private_replace:
  * @key: a #SysPrivate
  * @value: the new value
  *
@@ -1023,8 +1081,8 @@ sys_private_set (SysPrivate *key,
  * Since: 2.32
  **/
 void
-sys_private_replace (SysPrivate *key,
-                   SysPointer  value)
+sys_system_private_replace (SysPrivate *key,
+                          SysPointer  value)
 {
   pthread_key_t *impl = sys_private_get_impl (key);
   SysPointer old;
@@ -1059,6 +1117,11 @@ typedef struct
   SysMutex    lock;
 
   void *(*proxy) (void *);
+
+  /* applied by the thread itself before it runs proxy */
+  SysCpuSet *cpus;
+  SysBool renice;
+  SysInt nice;
 } SysThreadPosix;
 
 void
@@ -1074,9 +1137,51 @@ sys_system_thread_free (SysRealThread *thread)
   sys_slice_free (SysThreadPosix, pt);
 }
 
+#if defined(__linux__)
+static void
+sys_cpu_set_to_posix (const SysCpuSet *cpus, cpu_set_t *set)
+{
+  SysInt cpu;
+
+  CPU_ZERO (set);
+  for (cpu = 0; cpu < SYS_CPU_SET_MAX && cpu < CPU_SETSIZE; cpu++)
+    if (sys_cpu_set_contains (cpus, cpu))
+      CPU_SET (cpu, set);
+}
+#endif
+
+static void *
+sys_thread_posix_proxy (void *data)
+{
+  SysThreadPosix *thread = data;
+
+#if defined(__linux__)
+  if (thread->cpus)
+    {
+      cpu_set_t set;
+
+      sys_cpu_set_to_posix (thread->cpus, &set);
+      if (sched_setaffinity (0, sizeof (set), &set) != 0)
+        sys_warning_N ("sched_setaffinity: %s", sys_strerror (errno));
+
+      sys_free (thread->cpus);
+      thread->cpus = NULL;
+    }
+
+  /* nice is per thread on linux, the tid stands for the thread */
+  if (thread->renice && setpriority (PRIO_PROCESS, (id_t) syscall (SYS_gettid), thread->nice) != 0)
+    sys_warning_N ("setpriority: %s", sys_strerror (errno));
+#else
+  if (thread->renice && setpriority (PRIO_PROCESS, 0, thread->nice) != 0)
+    sys_warning_N ("setpriority: %s", sys_strerror (errno));
+#endif
+
+  return thread->proxy (thread);
+}
+
 SysRealThread *
 sys_system_thread_new (SysThreadFunc proxy,
-                     SysULong stack_size,
+                     const SysThreadOptions *options,
                      const SysChar *name,
                      SysThreadFunc func,
                      SysPointer data,
@@ -1095,39 +1200,84 @@ sys_system_thread_new (SysThreadFunc proxy,
   base_thread->thread.func = func;
   base_thread->thread.data = data;
   base_thread->name = sys_strdup (name);
-  thread->proxy = proxy;
+  thread->proxy = (void *(*) (void *)) proxy;
 
   posix_check_cmd (pthread_attr_init (&attr));
 
-#ifdef HAVE_PTHREAD_ATTR_SETSTACKSIZE
-  if (stack_size)
+  if (options && options->stack_size)
     {
+      SysSize stack_size = options->stack_size;
 #ifdef _SC_THREAD_STACK_MIN
       long min_stack_size = sysconf (_SC_THREAD_STACK_MIN);
-      if (min_stack_size >= 0)
-        stack_size = MAX ((SysULong) min_stack_size, stack_size);
+      if (min_stack_size >= 0 && stack_size < (SysSize) min_stack_size)
+        stack_size = (SysSize) min_stack_size;
 #endif /* _SC_THREAD_STACK_MIN */
       /* No error check here, because some systems can't do it and
        * we simply don't want threads to fail because of that. */
       pthread_attr_setstacksize (&attr, stack_size);
     }
-#endif /* HAVE_PTHREAD_ATTR_SETSTACKSIZE */
 
-#ifdef HAVE_PTHREAD_ATTR_SETINHERITSCHED
+  if (options && options->guard_size)
+    pthread_attr_setguardsize (&attr, options->guard_size);
+
+  if (options && options->cpus)
+    {
+#if defined(__GLIBC__)
+      {
+        cpu_set_t set;
+
+        sys_cpu_set_to_posix (options->cpus, &set);
+        pthread_attr_setaffinity_np (&attr, sizeof (set), &set);
+      }
+#elif defined(__linux__)
+      thread->cpus = sys_new (SysCpuSet, 1);
+      *thread->cpus = *options->cpus;
+#else
+      sys_warning_N ("%s", "thread affinity is not supported on this system");
+#endif
+    }
+
+  if (options && options->sched != SYS_THREAD_SCHED_INHERIT)
     {
-      /* While this is the default, better be explicit about it */
-      pthread_attr_setinheritsched (&attr, PTHREAD_INHERIT_SCHED);
+      struct sched_param param;
+      SysInt policy;
+
+      memset (&param, 0, sizeof (param));
+      switch (options->sched)
+        {
+        case SYS_THREAD_SCHED_FIFO:
+          policy = SCHED_FIFO;
+          param.sched_priority = options->priority;
+          break;
+        case SYS_THREAD_SCHED_RR:
+          policy = SCHED_RR;
+          param.sched_priority = options->priority;
+          break;
+        default:
+          policy = SCHED_OTHER;
+          thread->renice = true;
+          thread->nice = options->priority;
+          break;
+        }
+
+      pthread_attr_setinheritsched (&attr, PTHREAD_EXPLICIT_SCHED);
+      pthread_attr_setschedpolicy (&attr, policy);
+      pthread_attr_setschedparam (&attr, &param);
     }
-#endif /* HAVE_PTHREAD_ATTR_SETINHERITSCHED */
 
-  ret = pthread_create (&thread->system_thread, &attr, (void* (*)(void*))proxy, thread);
+  ret = pthread_create (&thread->system_thread, &attr, sys_thread_posix_proxy, thread);
 
   posix_check_cmd (pthread_attr_destroy (&attr));
 
-  if (ret == EAGAIN)
+  /* EPERM and EINVAL come from a real time policy or priority the
+   * caller may not use, they are the caller's to handle */
+  if (ret == EAGAIN || ret == EPERM || ret == EINVAL)
     {
       sys_error_set_N (error, "Error creating thread: %s", sys_strerror (ret));
-      sys_free (thread->thread.name);
+      if (thread->cpus)
+        sys_free (thread->cpus);
+      if (base_thread->name)
+        sys_free (base_thread->name);
       sys_slice_free (SysThreadPosix, thread);
       return NULL;
     }
@@ -1178,7 +1328,13 @@ sys_system_thread_exit (void)
 void
 sys_system_thread_set_name (const SysChar *name)
 {
-#if defined(HAVE_PTHREAD_SETNAME_NP_WITHOUT_TID)
+#if defined(__linux__)
+  SysChar buf[16];
+
+  /* the kernel limit is 15 bytes, longer names are refused outright */
+  sys_snprintf (buf, sizeof (buf), "%s", name);
+  pthread_setname_np (pthread_self (), buf);
+#elif defined(HAVE_PTHREAD_SETNAME_NP_WITHOUT_TID) || defined(__APPLE__)
   pthread_setname_np (name); /* on OS X and iOS */
 #elif defined(HAVE_PTHREAD_SETNAME_NP_WITH_TID)
   pthread_setname_np (pthread_self (), name); /* on Linux and Solaris */
@@ -1189,44 +1345,64 @@ sys_system_thread_set_name (const SysChar *name)
 #endif
 }
 
-/* {{{1 SysMutex and SysCond futex implementation */
+SysBool
+sys_system_thread_set_affinity (SysRealThread *thread, const SysCpuSet *cpus)
+{
+#if defined(__linux__)
+  cpu_set_t set;
+  SysInt ret;
 
-#if defined(USE_NATIVE_MUTEX)
-/* We should expand the set of operations available in gatomic once we
- * have better C11 support in GCC in common distributions (ie: 4.9).
- *
- * Before then, let's define a couple of useful things for our own
- * purposes...
- */
+  sys_cpu_set_to_posix (cpus, &set);
+  ret = pthread_setaffinity_np (thread ? ((SysThreadPosix *) thread)->system_thread : pthread_self (),
+      sizeof (set), &set);
+  if (ret != 0)
+    {
+      sys_warning_N ("pthread_setaffinity_np: %s", sys_strerror (ret));
+      return false;
+    }
+
+  return true;
+#else
+  UNUSED (thread);
+  UNUSED (cpus);
 
-#ifdef HAVE_STDATOMIC_H
+  return false;
+#endif
+}
 
-#include <stdatomic.h>
+/* {{{1 SysMutex statistics */
 
-#define exchange_acquire(ptr, new) \
-  atomic_exchange_explicit((atomic_uint *) (ptr), (new), __ATOMIC_ACQUIRE)
-#define compare_exchange_acquire(ptr, old, new) \
-  atomic_compare_exchange_stronsys_explicit((atomic_uint *) (ptr), (old), (new), \
-                                          __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)
+void
+sys_mutex_get_stats (SysMutexStats *stats)
+{
+  sys_return_if_fail (stats != NULL);
 
-#define exchange_release(ptr, new) \
-  atomic_exchange_explicit((atomic_uint *) (ptr), (new), __ATOMIC_RELEASE)
-#define store_release(ptr, new) \
-  atomic_store_explicit((atomic_uint *) (ptr), (new), __ATOMIC_RELEASE)
+  stats->contended = __atomic_load_n (&sys_mutex_stats.contended, __ATOMIC_RELAXED);
+  stats->spin_acquired = __atomic_load_n (&sys_mutex_stats.spin_acquired, __ATOMIC_RELAXED);
+  stats->parked = __atomic_load_n (&sys_mutex_stats.parked, __ATOMIC_RELAXED);
+}
 
-#else
+void
+sys_mutex_reset_stats (void)
+{
+  __atomic_store_n (&sys_mutex_stats.contended, 0, __ATOMIC_RELAXED);
+  __atomic_store_n (&sys_mutex_stats.spin_acquired, 0, __ATOMIC_RELAXED);
+  __atomic_store_n (&sys_mutex_stats.parked, 0, __ATOMIC_RELAXED);
+}
+
+/* {{{1 SysMutex and SysCond futex implementation */
+
+#if defined(USE_NATIVE_MUTEX)
 
 #define exchange_acquire(ptr, new) \
-  __atomic_exchange_4((ptr), (new), __ATOMIC_ACQUIRE)
+  __atomic_exchange_n((ptr), (new), __ATOMIC_ACQUIRE)
 #define compare_exchange_acquire(ptr, old, new) \
-  __atomic_compare_exchange_4((ptr), (old), (new), 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)
+  __atomic_compare_exchange_n((ptr), (old), (new), 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)
 
 #define exchange_release(ptr, new) \
-  __atomic_exchange_4((ptr), (new), __ATOMIC_RELEASE)
+  __atomic_exchange_n((ptr), (new), __ATOMIC_RELEASE)
 #define store_release(ptr, new) \
-  __atomic_store_4((ptr), (new), __ATOMIC_RELEASE)
-
-#endif
+  __atomic_store_n((ptr), (new), __ATOMIC_RELEASE)
 
 /* Our strategy for the mutex is pretty simple:
  *
@@ -1257,12 +1433,23 @@ typedef enum {
  * wait.  We must always ensure that we mark a value >1 while we are
  * waiting in order to instruct the holder to do a wake operation on
  * unlock.
+ *
+ * Before sleeping, a contended lock spins with exponential backoff.
+ * i[1] keeps a running average of the pauses it took to get the mutex
+ * that way, which tracks how long the mutex is usually held.  The spin
+ * budget is twice that average, so mutexes with short critical sections
+ * keep spinning and the budget of long held ones decays to a few pauses.
  */
 
+#define SYS_MUTEX_SPIN_MIN 16
+#define SYS_MUTEX_SPIN_MAX 4096
+#define SYS_MUTEX_BACKOFF_MAX 64
+
 void
 sys_mutex_init (SysMutex *mutex)
 {
   mutex->i[0] = SYS_MUTEX_STATE_EMPTY;
+  mutex->i[1] = 0;
 }
 
 void
@@ -1271,14 +1458,61 @@ sys_mutex_clear (SysMutex *mutex)
   if SYS_UNLIKELY (mutex->i[0] != SYS_MUTEX_STATE_EMPTY)
     {
       fprintf (stderr, "sys_mutex_clear() called on uninitialised or locked mutex\n");
-      sys_abort_N_N_N_N ();
+      abort ();
     }
 }
 
-SYS_GNUC_NO_INLINE
+static SysBool
+sys_mutex_lock_spin (SysMutex *mutex)
+{
+  static SysUInt n_cpus = 0;
+  SysUInt average, budget;
+  SysUInt spins = 0, backoff = 1, i;
+  SysUInt empty;
+
+  /* the holder can't run while we spin on a single CPU */
+  if SYS_UNLIKELY (__atomic_load_n (&n_cpus, __ATOMIC_RELAXED) == 0)
+    __atomic_store_n (&n_cpus, sys_get_num_processors (), __ATOMIC_RELAXED);
+  if (n_cpus == 1)
+    return false;
+
+  average = __atomic_load_n (&mutex->i[1], __ATOMIC_RELAXED);
+  budget = min (average * 2 + SYS_MUTEX_SPIN_MIN, SYS_MUTEX_SPIN_MAX);
+
+  while (spins < budget)
+    {
+      for (i = 0; i < backoff; i++)
+        sys_cpu_relax ();
+      spins += backoff;
+
+      empty = SYS_MUTEX_STATE_EMPTY;
+      if (__atomic_load_n (&mutex->i[0], __ATOMIC_RELAXED) == SYS_MUTEX_STATE_EMPTY
+          && compare_exchange_acquire (&mutex->i[0], &empty, SYS_MUTEX_STATE_OWNED))
+        {
+          __atomic_store_n (&mutex->i[1], average + ((SysInt) (spins - average)) / 8, __ATOMIC_RELAXED);
+          return true;
+        }
+
+      backoff = min (backoff * 2, SYS_MUTEX_BACKOFF_MAX);
+    }
+
+  __atomic_store_n (&mutex->i[1], average - average / 8, __ATOMIC_RELAXED);
+  return false;
+}
+
 static void
 sys_mutex_lock_slowpath (SysMutex *mutex)
 {
+  SYS_MUTEX_STATS_INC (contended);
+
+  if (sys_mutex_lock_spin (mutex))
+    {
+      SYS_MUTEX_STATS_INC (spin_acquired);
+      return;
+    }
+
+  SYS_MUTEX_STATS_INC (parked);
+
   /* Set to contended.  If it was empty before then we
    * just acquired the lock.
    *
@@ -1291,7 +1525,6 @@ sys_mutex_lock_slowpath (SysMutex *mutex)
     }
 }
 
-SYS_GNUC_NO_INLINE
 static void
 sys_mutex_unlock_slowpath (SysMutex *mutex,
                          SysUInt   prev)
@@ -1302,7 +1535,7 @@ sys_mutex_unlock_slowpath (SysMutex *mutex,
   if SYS_UNLIKELY (prev == SYS_MUTEX_STATE_EMPTY)
     {
       fprintf (stderr, "Attempt to unlock mutex that was not locked\n");
-      sys_abort_N_N_N_N ();
+      abort ();
     }
 
   sys_futex_simple (&mutex->i[0], (SysSize) FUTEX_WAKE_PRIVATE, (SysSize) 1, NULL);
@@ -1311,10 +1544,10 @@ sys_mutex_unlock_slowpath (SysMutex *mutex,
 void
 sys_mutex_lock (SysMutex *mutex)
 {
+  SysUInt empty = SYS_MUTEX_STATE_EMPTY;
+
   /* empty -> owned and we're done.  Anything else, and we need to wait... */
-  if SYS_UNLIKELY (!sys_atomic_int_cmpxchg (&mutex->i[0],
-                                                     SYS_MUTEX_STATE_EMPTY,
-                                                     SYS_MUTEX_STATE_OWNED))
+  if SYS_UNLIKELY (!compare_exchange_acquire (&mutex->i[0], &empty, SYS_MUTEX_STATE_OWNED))
     sys_mutex_lock_slowpath (mutex);
 }
 
@@ -1333,7 +1566,7 @@ sys_mutex_unlock (SysMutex *mutex)
 SysBool
 sys_mutex_trylock (SysMutex *mutex)
 {
-  SysMutexState empty = SYS_MUTEX_STATE_EMPTY;
+  SysUInt empty = SYS_MUTEX_STATE_EMPTY;
 
   /* We don't want to touch the value at all unless we can move it from
    * exactly empty to owned.
@@ -1364,13 +1597,14 @@ sys_cond_init (SysCond *cond)
 void
 sys_cond_clear (SysCond *cond)
 {
+  UNUSED (cond);
 }
 
 void
 sys_cond_wait (SysCond  *cond,
              SysMutex *mutex)
 {
-  SysUInt sampled = (SysUInt) sys_atomic_int_get (&cond->i[0]);
+  SysUInt sampled = __atomic_load_n (&cond->i[0], __ATOMIC_SEQ_CST);
 
   sys_mutex_unlock (mutex);
   sys_futex_simple (&cond->i[0], (SysSize) FUTEX_WAIT_PRIVATE, (SysSize) sampled, NULL);
@@ -1380,7 +1614,7 @@ sys_cond_wait (SysCond  *cond,
 void
 sys_cond_signal (SysCond *cond)
 {
-  sys_atomic_int_inc (&cond->i[0]);
+  __atomic_fetch_add (&cond->i[0], 1, __ATOMIC_SEQ_CST);
 
   sys_futex_simple (&cond->i[0], (SysSize) FUTEX_WAKE_PRIVATE, (SysSize) 1, NULL);
 }
@@ -1388,7 +1622,7 @@ sys_cond_signal (SysCond *cond)
 void
 sys_cond_broadcast (SysCond *cond)
 {
-  sys_atomic_int_inc (&cond->i[0]);
+  __atomic_fetch_add (&cond->i[0], 1, __ATOMIC_SEQ_CST);
 
   sys_futex_simple (&cond->i[0], (SysSize) FUTEX_WAKE_PRIVATE, (SysSize) INT_MAX, NULL);
 }
@@ -1431,7 +1665,7 @@ sys_cond_wait_until (SysCond  *cond,
    *      platforms and always uses 64-bit `time_t`.
    *   b) otherwise (or if that returns `ENOSYS`), we call the normal `futex`
    *      syscall with the `struct timespec` used by the kernel, which uses
-   *      `__kernel_lonsys_t` for both its fields. We use that instead of
+   *      `__kernel_long_t` for both its fields. We use that instead of
    *      `__kernel_old_time_t` because it is equivalent and available in the
    *      kernel headers for a longer time.
    *
@@ -1475,13 +1709,13 @@ sys_cond_wait_until (SysCond  *cond,
   {
     struct
     {
-      __kernel_lonsys_t tv_sec;
-      __kernel_lonsys_t tv_nsec;
+      __kernel_long_t tv_sec;
+      __kernel_long_t tv_nsec;
     } span_arg;
 
     /* Make sure to only ever call this if the end time actually fits into the target type */
-    if (SYS_UNLIKELY (sizeof (__kernel_lonsys_t) < 8 && span.tv_sec > SYS_MAXINT32))
-      sys_error ("%s: Can’t wait for more than %us", SYS_STRFUNC, SYS_MAXINT32);
+    if (SYS_UNLIKELY (sizeof (__kernel_long_t) < 8 && span.tv_sec > INT32_MAX))
+      sys_error_N ("Can't wait for more than %us", (SysUInt) INT32_MAX);
 
     span_arg.tv_sec = span.tv_sec;
     span_arg.tv_nsec = span.tv_nsec;
@@ -1498,7 +1732,327 @@ sys_cond_wait_until (SysCond  *cond,
   sys_assert_not_reached ();
 }
 
+/* {{{1 SysRWLock futex implementation */
+
+/* i[0] is the lock word:
+ *
+ *  bits 0-29: number of readers holding the lock
+ *  bit 30: somebody sleeps on the lock word and must be woken
+ *  bit 31: a writer holds the lock
+ *
+ * i[1] counts writers waiting, which stops new readers when the lock
+ * prefers writers.  p keeps the #SysRWLockFlags.
+ *
+ * Every unlock that finds bit 30 set clears it and wakes all sleepers,
+ * they set it again if they still have to wait.
+ */
+
+#define SYS_RW_LOCK_READERS 0x3fffffffU
+#define SYS_RW_LOCK_WAITERS 0x40000000U
+#define SYS_RW_LOCK_WRITER  0x80000000U
+
+void
+sys_rw_lock_init_full (SysRWLock      *rw_lock,
+                       SysRWLockFlags  flags)
+{
+  rw_lock->p = (SysPointer) (SysUIntPtr) flags;
+  rw_lock->i[0] = 0;
+  rw_lock->i[1] = 0;
+}
+
+void
+sys_rw_lock_init (SysRWLock *rw_lock)
+{
+  sys_rw_lock_init_full (rw_lock, SYS_RW_LOCK_DEFAULT);
+}
+
+void
+sys_rw_lock_clear (SysRWLock *rw_lock)
+{
+  if SYS_UNLIKELY ((rw_lock->i[0] & ~SYS_RW_LOCK_WAITERS) != 0)
+    {
+      fprintf (stderr, "sys_rw_lock_clear() called on a locked lock\n");
+      abort ();
+    }
+}
+
+/* sets the waiters bit on the expected value and sleeps while it holds */
+static void
+sys_rw_lock_wait (SysRWLock *rw_lock,
+                  SysUInt    state)
+{
+  if (!(state & SYS_RW_LOCK_WAITERS)
+      && !__atomic_compare_exchange_n (&rw_lock->i[0], &state, state | SYS_RW_LOCK_WAITERS,
+                                       false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+    return;
+
+  sys_futex_simple (&rw_lock->i[0], (SysSize) FUTEX_WAIT_PRIVATE,
+                    (SysSize) (state | SYS_RW_LOCK_WAITERS), NULL);
+}
+
+static void
+sys_rw_lock_wake (SysRWLock *rw_lock)
+{
+  sys_futex_simple (&rw_lock->i[0], (SysSize) FUTEX_WAKE_PRIVATE, (SysSize) INT_MAX, NULL);
+}
+
+static inline SysBool
+sys_rw_lock_writers_first (SysRWLock *rw_lock)
+{
+  return ((SysUIntPtr) rw_lock->p & SYS_RW_LOCK_PREFER_WRITER)
+    && __atomic_load_n (&rw_lock->i[1], __ATOMIC_SEQ_CST) > 0;
+}
+
+void
+sys_rw_lock_writer_lock (SysRWLock *rw_lock)
+{
+  SysUInt state = 0;
+  SysBool waiting = false;
+
+  if SYS_LIKELY (__atomic_compare_exchange_n (&rw_lock->i[0], &state, SYS_RW_LOCK_WRITER,
+                                              false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    return;
+
+  while (true)
+    {
+      state = __atomic_load_n (&rw_lock->i[0], __ATOMIC_RELAXED);
+
+      if ((state & ~SYS_RW_LOCK_WAITERS) == 0)
+        {
+          if (__atomic_compare_exchange_n (&rw_lock->i[0], &state, state | SYS_RW_LOCK_WRITER,
+                                           false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            break;
+          continue;
+        }
+
+      if (!waiting)
+        {
+          __atomic_fetch_add (&rw_lock->i[1], 1, __ATOMIC_SEQ_CST);
+          waiting = true;
+          continue;
+        }
+
+      sys_rw_lock_wait (rw_lock, state);
+    }
+
+  if (waiting)
+    __atomic_fetch_sub (&rw_lock->i[1], 1, __ATOMIC_SEQ_CST);
+}
+
+SysBool
+sys_rw_lock_writer_trylock (SysRWLock *rw_lock)
+{
+  SysUInt state = __atomic_load_n (&rw_lock->i[0], __ATOMIC_RELAXED);
+
+  while ((state & ~SYS_RW_LOCK_WAITERS) == 0)
+    {
+      if (__atomic_compare_exchange_n (&rw_lock->i[0], &state, state | SYS_RW_LOCK_WRITER,
+                                       false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return true;
+    }
+
+  return false;
+}
+
+void
+sys_rw_lock_writer_unlock (SysRWLock *rw_lock)
+{
+  SysUInt prev = __atomic_exchange_n (&rw_lock->i[0], 0, __ATOMIC_SEQ_CST);
+
+  if SYS_UNLIKELY (prev & SYS_RW_LOCK_WAITERS)
+    sys_rw_lock_wake (rw_lock);
+}
+
+void
+sys_rw_lock_reader_lock (SysRWLock *rw_lock)
+{
+  SysUInt state = __atomic_load_n (&rw_lock->i[0], __ATOMIC_RELAXED);
+
+  while (true)
+    {
+      if (!(state & SYS_RW_LOCK_WRITER) && !sys_rw_lock_writers_first (rw_lock))
+        {
+          if SYS_UNLIKELY ((state & SYS_RW_LOCK_READERS) == SYS_RW_LOCK_READERS)
+            sys_abort_N ("Too many readers on RW lock %p", rw_lock);
+
+          if (__atomic_compare_exchange_n (&rw_lock->i[0], &state, state + 1,
+                                           false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return;
+          continue;
+        }
+
+      if (!(state & SYS_RW_LOCK_WAITERS))
+        {
+          if (!__atomic_compare_exchange_n (&rw_lock->i[0], &state, state | SYS_RW_LOCK_WAITERS,
+                                            false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            continue;
+          state |= SYS_RW_LOCK_WAITERS;
+
+          /* the writer we yielded to may have come and gone before the
+           * bit was set, nobody would wake us then */
+          if (!(state & SYS_RW_LOCK_WRITER) && !sys_rw_lock_writers_first (rw_lock))
+            continue;
+        }
+
+      sys_rw_lock_wait (rw_lock, state);
+      state = __atomic_load_n (&rw_lock->i[0], __ATOMIC_RELAXED);
+    }
+}
+
+SysBool
+sys_rw_lock_reader_trylock (SysRWLock *rw_lock)
+{
+  SysUInt state = __atomic_load_n (&rw_lock->i[0], __ATOMIC_RELAXED);
+
+  while (!(state & SYS_RW_LOCK_WRITER)
+         && (state & SYS_RW_LOCK_READERS) != SYS_RW_LOCK_READERS
+         && !sys_rw_lock_writers_first (rw_lock))
+    {
+      if (__atomic_compare_exchange_n (&rw_lock->i[0], &state, state + 1,
+                                       false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return true;
+    }
+
+  return false;
+}
+
+void
+sys_rw_lock_reader_unlock (SysRWLock *rw_lock)
+{
+  SysUInt prev = __atomic_fetch_sub (&rw_lock->i[0], 1, __ATOMIC_SEQ_CST);
+
+  /* the last reader wakes the sleepers, unless somebody took the lock
+   * again meanwhile and will do it on its own unlock */
+  if SYS_UNLIKELY ((prev & ~SYS_RW_LOCK_WAITERS) == 1 && (prev & SYS_RW_LOCK_WAITERS))
+    {
+      SysUInt state = SYS_RW_LOCK_WAITERS;
+
+      if (__atomic_compare_exchange_n (&rw_lock->i[0], &state, 0,
+                                       false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        sys_rw_lock_wake (rw_lock);
+    }
+}
+
 #endif
 
+#if defined(sys_futex_simple)
+/* {{{1 Address wait and wake */
+
+SysBool
+sys_system_futex_wait (SysUInt  *address,
+                       SysUInt   expected,
+                       SysInt64  end_time)
+{
+  SysInt res;
+
+  if (end_time < 0)
+    {
+      sys_futex_simple (address, (SysSize) FUTEX_WAIT_PRIVATE, (SysSize) expected, NULL);
+      return true;
+    }
+
+  /* FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC time, the two
+   * timespec layouts are explained in sys_cond_wait_until() */
+#ifdef __NR_futex_time64
+  {
+    struct
+    {
+      SysInt64 tv_sec;
+      SysInt64 tv_nsec;
+    } abs_arg;
+
+    abs_arg.tv_sec = end_time / 1000000;
+    abs_arg.tv_nsec = (end_time % 1000000) * 1000;
+
+    res = syscall (__NR_futex_time64, address, (SysSize) FUTEX_WAIT_BITSET_PRIVATE,
+                   (SysSize) expected, &abs_arg, NULL, (SysSize) FUTEX_BITSET_MATCH_ANY);
+#  ifdef __NR_futex
+    if (res >= 0 || errno != ENOSYS)
+#  endif /* defined(__NR_futex) */
+      return !(res < 0 && errno == ETIMEDOUT);
+  }
+#endif
+
+#ifdef __NR_futex
+  {
+    struct
+    {
+      __kernel_long_t tv_sec;
+      __kernel_long_t tv_nsec;
+    } abs_arg;
+
+    abs_arg.tv_sec = end_time / 1000000;
+    abs_arg.tv_nsec = (end_time % 1000000) * 1000;
+
+    res = syscall (__NR_futex, address, (SysSize) FUTEX_WAIT_BITSET_PRIVATE,
+                   (SysSize) expected, &abs_arg, NULL, (SysSize) FUTEX_BITSET_MATCH_ANY);
+    return !(res < 0 && errno == ETIMEDOUT);
+  }
+#endif /* defined(__NR_futex) */
+}
+
+void
+sys_system_futex_wake (SysUInt *address,
+                       SysBool  all)
+{
+  sys_futex_simple (address, (SysSize) FUTEX_WAKE_PRIVATE, (SysSize) (all ? INT_MAX : 1), NULL);
+}
+
+#else /* !defined(sys_futex_simple) */
+
+/* no futex here: sleep on one of a few condition variables picked by
+ * the address, wakers take the same lock so no wakeup is lost */
+#define SYS_FUTEX_BUCKETS 64
+
+typedef struct
+{
+  SysMutex lock;
+  SysCond  cond;
+} SysFutexBucket;
+
+static SysFutexBucket sys_futex_buckets[SYS_FUTEX_BUCKETS];
+
+static SysFutexBucket *
+sys_futex_bucket (SysUInt *address)
+{
+  return &sys_futex_buckets[((SysUIntPtr) address >> 4) % SYS_FUTEX_BUCKETS];
+}
+
+SysBool
+sys_system_futex_wait (SysUInt  *address,
+                       SysUInt   expected,
+                       SysInt64  end_time)
+{
+  SysFutexBucket *bucket = sys_futex_bucket (address);
+  SysBool success = true;
+
+  sys_mutex_lock (&bucket->lock);
+  if (__atomic_load_n (address, __ATOMIC_SEQ_CST) == expected)
+    {
+      if (end_time < 0)
+        sys_cond_wait (&bucket->cond, &bucket->lock);
+      else
+        success = sys_cond_wait_until (&bucket->cond, &bucket->lock, end_time);
+    }
+  sys_mutex_unlock (&bucket->lock);
+
+  return success;
+}
+
+void
+sys_system_futex_wake (SysUInt *address,
+                       SysBool  all)
+{
+  SysFutexBucket *bucket = sys_futex_bucket (address);
+
+  UNUSED (all);
+
+  /* the bucket is shared, a single wakeup could hit the wrong waiter */
+  sys_mutex_lock (&bucket->lock);
+  sys_cond_broadcast (&bucket->cond);
+  sys_mutex_unlock (&bucket->lock);
+}
+#endif /* defined(sys_futex_simple) */
+
   /* {{{1 Epilogue */
 /* vim:set foldmethod=marker: */
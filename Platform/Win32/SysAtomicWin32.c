@@ -44,3 +44,7 @@ void sys_atomic_pointer_set(volatile SysPointer o, SysPointer n) {
   *ptr = n;
   MemoryBarrier();
 }
+
+void sys_atomic_fence(void) {
+  MemoryBarrier();
+}
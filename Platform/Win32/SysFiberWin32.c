@@ -0,0 +1,63 @@
+#include <System/Platform/Common/SysFiberPrivate.h>
+#include <System/Platform/Common/SysMem.h>
+
+/* native fibers, their stacks come with guard pages already */
+struct _SysFiberContext {
+  LPVOID fiber;
+  SysFiberEntry entry;
+  /* the context of a thread, converted back when freed if we did it */
+  SysBool is_thread;
+  SysBool converted;
+};
+
+static VOID CALLBACK fiber_proc(LPVOID param) {
+  SysFiberContext *ctx = param;
+
+  ctx->entry();
+}
+
+SysFiberContext *sys_real_fiber_context_new(SysSize stack_size, SysFiberEntry entry) {
+  SysFiberContext *ctx = sys_new0(SysFiberContext, 1);
+
+  ctx->entry = entry;
+  /* @stack_size is only reserved, a single page is committed up front
+   * and the guard page commits the rest as the stack grows */
+  ctx->fiber = CreateFiberEx(4096, stack_size, FIBER_FLAG_FLOAT_SWITCH, fiber_proc, ctx);
+  if (ctx->fiber == NULL) {
+    sys_warning_N("CreateFiberEx failed: %lu", GetLastError());
+    sys_free(ctx);
+    return NULL;
+  }
+
+  return ctx;
+}
+
+SysFiberContext *sys_real_fiber_context_main(void) {
+  SysFiberContext *ctx = sys_new0(SysFiberContext, 1);
+
+  ctx->is_thread = true;
+  if (IsThreadAFiber()) {
+    ctx->fiber = GetCurrentFiber();
+  } else {
+    ctx->fiber = ConvertThreadToFiberEx(NULL, FIBER_FLAG_FLOAT_SWITCH);
+    ctx->converted = true;
+  }
+
+  return ctx;
+}
+
+void sys_real_fiber_context_free(SysFiberContext *ctx) {
+  if (!ctx->is_thread) {
+    DeleteFiber(ctx->fiber);
+  } else if (ctx->converted) {
+    ConvertFiberToThread();
+  }
+
+  sys_free(ctx);
+}
+
+void sys_real_fiber_context_switch(SysFiberContext *from, SysFiberContext *to) {
+  UNUSED(from);
+
+  SwitchToFiber(to->fiber);
+}
@@ -1,6 +1,16 @@
+/* WaitOnAddress() is declared from Windows 8 on */
+#if !defined(_WIN32_WINNT) || _WIN32_WINNT < 0x0602
+#undef _WIN32_WINNT
+#define _WIN32_WINNT 0x0602
+#endif
+
 #include <System/Platform/Common/SysThreadPrivate.h>
 #include <System/Utils/SysString.h>
 
+#if defined(_MSC_VER)
+#pragma comment(lib, "synchronization.lib")
+#endif
+
 
 static void
 sys_thread_abort (SysInt         status,
@@ -36,9 +46,16 @@ sys_mutex_clear (SysMutex *mutex)
 {
 }
 
+/* only touched on contention */
+static volatile LONG64 sys_mutex_contended;
+
 void
 sys_mutex_lock (SysMutex *mutex)
 {
+  if SYS_LIKELY (TryAcquireSRWLockExclusive ((SysPointer) mutex))
+    return;
+
+  InterlockedIncrement64 (&sys_mutex_contended);
   AcquireSRWLockExclusive ((SysPointer) mutex);
 }
 
@@ -54,6 +71,22 @@ sys_mutex_unlock (SysMutex *mutex)
   ReleaseSRWLockExclusive ((SysPointer) mutex);
 }
 
+void
+sys_mutex_get_stats (SysMutexStats *stats)
+{
+  sys_return_if_fail (stats != NULL);
+
+  stats->contended = (SysUInt64) InterlockedOr64 (&sys_mutex_contended, 0);
+  stats->spin_acquired = 0;
+  stats->parked = stats->contended;
+}
+
+void
+sys_mutex_reset_stats (void)
+{
+  InterlockedExchange64 (&sys_mutex_contended, 0);
+}
+
 /* {{{1 SysRecMutex */
 
 static CRITICAL_SECTION *
@@ -122,6 +155,18 @@ sys_rec_mutex_trylock (SysRecMutex *mutex)
 
 /* {{{1 SysRWLock */
 
+/* SRW locks have no preference to choose */
+/* %SYS_RW_LOCK_PREFER_WRITER is a no-op, SRW locks have no
+ * configurable preference */
+void
+sys_rw_lock_init_full (SysRWLock      *lock,
+                       SysRWLockFlags  flags)
+{
+  UNUSED (flags);
+
+  sys_rw_lock_init (lock);
+}
+
 void
 sys_rw_lock_init (SysRWLock *lock)
 {
@@ -315,21 +360,21 @@ sys_private_get_impl (SysPrivate *key)
 }
 
 SysPointer
-sys_private_get (SysPrivate *key)
+sys_system_private_get (SysPrivate *key)
 {
   return TlsGetValue (sys_private_get_impl (key));
 }
 
 void
-sys_private_set (SysPrivate *key,
-               SysPointer  value)
+sys_system_private_set (SysPrivate *key,
+                      SysPointer  value)
 {
   TlsSetValue(sys_private_get_impl(key), value);
 }
 
 void
-sys_private_replace (SysPrivate *key,
-                   SysPointer  value)
+sys_system_private_replace (SysPrivate *key,
+                          SysPointer  value)
 {
   DWORD impl = sys_private_get_impl (key);
   SysPointer old;
@@ -406,9 +451,29 @@ sys_thread_win32_proxy (SysPointer data)
   return 0;
 }
 
+/* windows has no real time policy for threads, FIFO and RR map to the
+ * highest priority and nice values onto the five normal levels */
+static SysInt
+sys_thread_win32_priority (const SysThreadOptions *options)
+{
+  if (options->sched != SYS_THREAD_SCHED_NORMAL)
+    return THREAD_PRIORITY_TIME_CRITICAL;
+
+  if (options->priority <= -10)
+    return THREAD_PRIORITY_HIGHEST;
+  if (options->priority < 0)
+    return THREAD_PRIORITY_ABOVE_NORMAL;
+  if (options->priority == 0)
+    return THREAD_PRIORITY_NORMAL;
+  if (options->priority < 10)
+    return THREAD_PRIORITY_BELOW_NORMAL;
+
+  return THREAD_PRIORITY_LOWEST;
+}
+
 SysRealThread *
 sys_system_thread_new (SysThreadFunc proxy,
-                     SysSize stack_size,
+                     const SysThreadOptions *options,
                      const SysChar *name,
                      SysThreadFunc func,
                      SysPointer data,
@@ -431,7 +496,8 @@ sys_system_thread_new (SysThreadFunc proxy,
   base_thread->thread.data = data;
   base_thread->name = sys_strdup (name);
 
-  thread->handle = (HANDLE) _beginthreadex(NULL, (SysUInt)stack_size, sys_thread_win32_proxy, thread,
+  /* the guard page is managed by the system, guard_size has no say here */
+  thread->handle = (HANDLE) _beginthreadex(NULL, options ? (SysUInt)options->stack_size : 0, sys_thread_win32_proxy, thread,
                                             CREATE_SUSPENDED, &ignore);
 
   if (thread->handle == NULL)
@@ -448,10 +514,13 @@ sys_system_thread_new (SysThreadFunc proxy,
    * On Windows, by default all new threads are created with NORMAL thread
    * priority.
    */
-  {
-    HANDLE current_thread = GetCurrentThread ();
-    thread_prio = GetThreadPriority (current_thread);
-  }
+  if (options == NULL || options->sched == SYS_THREAD_SCHED_INHERIT)
+    {
+      HANDLE current_thread = GetCurrentThread ();
+      thread_prio = GetThreadPriority (current_thread);
+    }
+  else
+    thread_prio = sys_thread_win32_priority (options);
 
   if (thread_prio == THREAD_PRIORITY_ERROR_RETURN)
     {
@@ -465,6 +534,12 @@ sys_system_thread_new (SysThreadFunc proxy,
       goto error;
     }
 
+  if (options && options->cpus && !sys_system_thread_set_affinity (base_thread, options->cpus))
+    {
+      message = "Error setting new thread affinity";
+      goto error;
+    }
+
   if (ResumeThread (thread->handle) == (DWORD) -1)
     {
       message = "Error resuming new thread";
@@ -478,6 +553,8 @@ error:
   {
     if (thread->handle)
       CloseHandle (thread->handle);
+    if (base_thread->name)
+      sys_free (base_thread->name);
     sys_slice_free (SysThreadWin32, thread);
     return NULL;
   }
@@ -497,6 +574,23 @@ sys_system_thread_wait (SysRealThread *thread)
   win32_check_for_error (WAIT_FAILED != WaitForSingleObject (wt->handle, INFINITE));
 }
 
+SysBool
+sys_system_thread_set_affinity (SysRealThread *thread, const SysCpuSet *cpus)
+{
+  HANDLE handle = thread ? ((SysThreadWin32 *) thread)->handle : GetCurrentThread ();
+  DWORD_PTR mask;
+
+  /* processor group 0 only, as GetProcessAffinityMask () */
+  mask = (DWORD_PTR) cpus->bits[0];
+  if (SetThreadAffinityMask (handle, mask) == 0)
+    {
+      sys_warning_N ("SetThreadAffinityMask failed: %lu", GetLastError ());
+      return false;
+    }
+
+  return true;
+}
+
 #define EXCEPTION_SET_THREAD_NAME ((DWORD) 0x406D1388)
 
 #ifndef _MSC_VER
@@ -613,6 +707,45 @@ sys_system_thread_set_name (const SysChar *name)
     SetThreadName ((DWORD) -1, name);
 }
 
+/* {{{1 Address wait and wake */
+
+SysBool
+sys_system_futex_wait (SysUInt  *address,
+                       SysUInt   expected,
+                       SysInt64  end_time)
+{
+  SysInt64 span;
+  DWORD span_millis = INFINITE;
+
+  if (end_time >= 0)
+    {
+      span = end_time - (SysInt64) sys_get_monotonic_time ();
+
+      if (span <= 0)
+        span_millis = 0;
+      else if (span > INT64_CONSTANT (1000) * (INFINITE - 1))
+        span_millis = INFINITE - 1;
+      else
+        /* Round up so we don't time out too early */
+        span_millis = (DWORD) ((span + 1000 - 1) / 1000);
+    }
+
+  if (WaitOnAddress (address, &expected, sizeof (SysUInt), span_millis))
+    return true;
+
+  return GetLastError () != ERROR_TIMEOUT;
+}
+
+void
+sys_system_futex_wake (SysUInt *address,
+                       SysBool  all)
+{
+  if (all)
+    WakeByAddressAll (address);
+  else
+    WakeByAddressSingle (address);
+}
+
 /* {{{1 Epilogue */
 
 void
@@ -10,6 +10,9 @@
 #include <System/Platform/Common/SysAtomic.h>
 #include <System/Platform/Common/SysProcess.h>
 #include <System/Platform/Common/SysThread.h>
+#include <System/Platform/Common/SysRcu.h>
+#include <System/Platform/Common/SysSync.h>
+#include <System/Platform/Common/SysFiber.h>
 
 #include <System/DataTypes/SysBit.h>
 #include <System/DataTypes/SysQuark.h>
@@ -21,13 +24,22 @@
 #include <System/DataTypes/SysList.h>
 #include <System/DataTypes/SysSList.h>
 #include <System/DataTypes/SysHsList.h>
+#include <System/DataTypes/SysHList.h>
 #include <System/DataTypes/SysQueue.h>
+#include <System/DataTypes/SysUQueue.h>
+#include <System/DataTypes/SysDeque.h>
 #include <System/DataTypes/SysAsyncQueue.h>
+#include <System/DataTypes/SysFuture.h>
 #include <System/DataTypes/SysBHeap.h>
+#include <System/DataTypes/SysDHeap.h>
 #include <System/DataTypes/SysNode.h>
 #include <System/DataTypes/SysHNode.h>
 #include <System/DataTypes/SysTree.h>
+#include <System/DataTypes/SysBTree.h>
+#include <System/DataTypes/SysPTree.h>
+#include <System/DataTypes/SysRadixTree.h>
 #include <System/DataTypes/SysPQueue.h>
+#include <System/DataTypes/SysTimerWheel.h>
 
 #include <System/Type/SysType.h>
 #include <System/Type/SysObject.h>